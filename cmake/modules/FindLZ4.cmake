@@ -0,0 +1,20 @@
+# Filename: FindLZ4.cmake
+# Authors: agent (18 Oct, 2026)
+#
+# Usage:
+#   find_package(LZ4 [REQUIRED] [QUIET])
+#
+# Once done this will define:
+#   LZ4_FOUND       - system has liblz4
+#   LZ4_INCLUDE_DIR - the include directory containing lz4.h
+#   LZ4_LIBRARY     - the path to the liblz4 library
+#
+
+find_path(LZ4_INCLUDE_DIR NAMES "lz4.h")
+
+find_library(LZ4_LIBRARY NAMES "lz4" "liblz4" "liblz4_static")
+
+mark_as_advanced(LZ4_INCLUDE_DIR LZ4_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LZ4 DEFAULT_MSG LZ4_INCLUDE_DIR LZ4_LIBRARY)
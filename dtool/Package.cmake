@@ -72,6 +72,7 @@ if(THIRDPARTY_DIRECTORY)
     HarfBuzz
     JPEG
     LibSquish
+    LZ4
     ODE
     Ogg
     OpenAL
@@ -85,6 +86,7 @@ if(THIRDPARTY_DIRECTORY)
     VorbisFile
     VRPN
     ZLIB
+    Zstd
   )
 
     string(TOLOWER "${_Package}" _package)
@@ -340,6 +342,24 @@ package_option(ZLIB
 
 package_status(ZLIB "zlib")
 
+# LZ4
+find_package(LZ4 QUIET)
+
+package_option(LZ4
+  "Enables support for fast LZ4 compression of vertex data pages."
+  FOUND_AS LZ4)
+
+package_status(LZ4 "LZ4")
+
+# Zstandard
+find_package(Zstd QUIET)
+
+package_option(ZSTD
+  "Enables support for Zstandard compression of vertex data pages."
+  FOUND_AS Zstd)
+
+package_status(ZSTD "Zstandard")
+
 
 #
 # ------------ Image formats ------------
@@ -101,6 +101,14 @@ PRC_DESC("This specifies the priority assign to an asynchronous bind "
          "model loads).  A higher number here makes the animations "
          "load sooner."));
 
+ConfigVariableInt anim_update_num_threads
+("anim-update-num-threads", 0,
+PRC_DESC("The number of worker threads that PartBundle::update_all() uses "
+         "to evaluate animated PartBundles in parallel.  Each PartBundle is "
+         "still evaluated by a single thread, so the results are the same "
+         "as when updating them one at a time.  Set this to 0 to update "
+         "all bundles on the calling thread."));
+
 ConfigureFn(config_chan) {
   AnimBundle::init_type();
   AnimBundleNode::init_type();
@@ -28,6 +28,10 @@
 #include "configVariableEnum.h"
 #include "loaderOptions.h"
 #include "bindAnimRequest.h"
+#include "lightMutexHolder.h"
+#include "pStatTimer.h"
+#include "asyncParallelJob.h"
+#include "atomicAdjust.h"
 
 #include <algorithm>
 
@@ -37,6 +41,25 @@ using std::string;
 
 TypeHandle PartBundle::_type_handle;
 
+LightMutex PartBundle::_animated_lock("PartBundle::_animated_lock");
+PartBundle::AnimatedBundles PartBundle::_animated_bundles;
+PStatCollector PartBundle::_update_all_pcollector("*:Animation:Update all");
+
+/**
+ * The work done by update_all(); each item is one bundle.
+ */
+class PartBundle::UpdateJob : public AsyncParallelJob {
+public:
+  UpdateJob() : AsyncParallelJob("anim", TP_high) {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+
+public:
+  PT(PartBundle) *_bundles;
+  AtomicAdjust::Integer _num_changed;
+};
+
 
 static ConfigVariableEnum<PartBundle::BlendType> anim_blend_type
 ("anim-blend-type", PartBundle::BT_normalized_linear,
@@ -55,6 +78,7 @@ PartBundle(const PartBundle &copy) :
 {
   _anim_preload = copy._anim_preload;
   _update_delay = 0.0;
+  _is_animated = false;
 
   CDWriter cdata(_cycler, true);
   CDReader cdata_from(copy._cycler);
@@ -73,6 +97,7 @@ PartBundle(const string &name) :
   PartGroup(name)
 {
   _update_delay = 0.0;
+  _is_animated = false;
 }
 
 /**
@@ -523,6 +548,86 @@ force_update() {
 }
 
 
+/**
+ * Updates all of the PartBundles that have an animation bound to them, as if
+ * update() were called on each one.  If anim-update-num-threads is nonzero,
+ * the bundles are distributed over that many worker threads; each bundle is
+ * still evaluated by one thread, so the results are identical to updating
+ * them one at a time.
+ *
+ * Calling this once per frame, before the cull traversal, takes the cost of
+ * animating a large number of Characters off the cull thread.  Returns the
+ * number of bundles that changed as a result.
+ */
+int PartBundle::
+update_all() {
+  PStatTimer timer(_update_all_pcollector);
+
+  // Take a reference to every bundle that still exists, dropping the ones
+  // that don't.
+  pvector<PT(PartBundle)> bundles;
+  {
+    LightMutexHolder holder(_animated_lock);
+    bundles.reserve(_animated_bundles.size());
+
+    AnimatedBundles::iterator dest = _animated_bundles.begin();
+    for (WPT(PartBundle) &bundle_ref : _animated_bundles) {
+      PT(PartBundle) bundle = bundle_ref.lock();
+      if (bundle != nullptr) {
+        *dest++ = std::move(bundle_ref);
+        bundles.push_back(std::move(bundle));
+      }
+    }
+    _animated_bundles.erase(dest, _animated_bundles.end());
+  }
+
+  if (bundles.empty()) {
+    return 0;
+  }
+
+  UpdateJob job;
+  job._bundles = &bundles[0];
+  job._num_changed = 0;
+  job.run((int)bundles.size(), anim_update_num_threads);
+
+  return (int)job._num_changed;
+}
+
+/**
+ * Returns the number of PartBundles that update_all() is currently keeping
+ * track of.  This includes bundles that have been destructed since the last
+ * call to update_all(), which removes them.
+ */
+int PartBundle::
+get_num_animated_bundles() {
+  LightMutexHolder holder(_animated_lock);
+  return (int)_animated_bundles.size();
+}
+
+/**
+ * Adds this bundle to the set of bundles considered by update_all(), if it is
+ * not there already.
+ */
+void PartBundle::
+mark_animated() {
+  LightMutexHolder holder(_animated_lock);
+  if (!_is_animated) {
+    _is_animated = true;
+    _animated_bundles.push_back(this);
+  }
+}
+
+/**
+ * Updates the nth bundle.  Called by each of the threads taking part in
+ * update_all().
+ */
+void PartBundle::UpdateJob::
+do_item(int n, Thread *) {
+  if (_bundles[n]->update()) {
+    AtomicAdjust::inc(_num_changed);
+  }
+}
+
 /**
  * Called by the AnimControl whenever it starts an animation.  This is just a
  * hook so the bundle can do something, if necessary, before the animation
@@ -674,6 +779,8 @@ do_set_control_effect(AnimControl *control, PN_stdfloat effect, CData *cdata) {
       cdata->_anim_changed = true;
     }
     cdata->_last_control_set = control;
+
+    mark_animated();
   }
 
   determine_effective_channels(cdata);
@@ -31,6 +31,8 @@
 #include "transformState.h"
 #include "weakPointerTo.h"
 #include "copyOnWritePointer.h"
+#include "lightMutex.h"
+#include "pStatCollector.h"
 
 class Loader;
 class AnimBundle;
@@ -145,6 +147,9 @@ PUBLISHED:
   bool update();
   bool force_update();
 
+  static int update_all();
+  static int get_num_animated_bundles();
+
 public:
   // The following functions aren't really part of the public interface;
   // they're just public so we don't have to declare a bunch of friends.
@@ -166,6 +171,9 @@ private:
   PN_stdfloat do_get_control_effect(AnimControl *control, const CData *cdata) const;
   void clear_and_stop_intersecting(AnimControl *control, CData *cdata);
 
+  void mark_animated();
+  class UpdateJob;
+
   COWPT(AnimPreloadTable) _anim_preload;
 
   typedef pvector<PartBundleNode *> Nodes;
@@ -176,6 +184,16 @@ private:
 
   double _update_delay;
 
+  // The set of bundles that have had an animation bound to them, which are
+  // the ones considered by update_all().  This is protected by
+  // _animated_lock, which must never be held while locking a cycler.
+  typedef pvector<WPT(PartBundle)> AnimatedBundles;
+  static LightMutex _animated_lock;
+  static AnimatedBundles _animated_bundles;
+  bool _is_animated;
+
+  static PStatCollector _update_all_pcollector;
+
   // This is the data that must be cycled between pipeline stages.
   class CData : public CycleData {
   public:
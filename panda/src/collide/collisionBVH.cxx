@@ -0,0 +1,293 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "collisionBVH.h"
+#include "finiteBoundingVolume.h"
+#include "boundingLine.h"
+
+#include <algorithm>
+
+// The maximum number of solids stored in a leaf of the hierarchy.
+static const int max_leaf_entries = 4;
+
+/**
+ * Builds the hierarchy from the indicated bounding volumes, which should be
+ * the bounds of the solids of a CollisionNode, in order.
+ */
+CollisionBVH::
+CollisionBVH(const Bounds &bounds) {
+  _entries.reserve(bounds.size());
+
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    const BoundingVolume *bv = bounds[i];
+    if (bv == nullptr) {
+      _unbounded.push_back((int)i);
+
+    } else if (bv->is_empty()) {
+      // An empty volume can't intersect anything; leave it out altogether.
+
+    } else if (bv->is_infinite() ||
+               !bv->is_of_type(FiniteBoundingVolume::get_class_type())) {
+      _unbounded.push_back((int)i);
+
+    } else {
+      const FiniteBoundingVolume *fbv = (const FiniteBoundingVolume *)bv;
+      Entry entry;
+      entry._min = fbv->get_min();
+      entry._max = fbv->get_max();
+      entry._center = (entry._min + entry._max) * 0.5f;
+      entry._index = (int)i;
+      _entries.push_back(entry);
+    }
+  }
+
+  if (!_entries.empty()) {
+    _nodes.reserve(_entries.size() * 2 / max_leaf_entries + 1);
+    r_build(0, (int)_entries.size());
+  }
+}
+
+/**
+ * Fills indices with the indices of the solids whose bounding volumes might
+ * intersect the indicated volume, in ascending order.  Returns true on
+ * success, or false if the volume is of a type that the hierarchy cannot be
+ * tested against, in which case the caller should test all of the solids.
+ */
+bool CollisionBVH::
+find_overlaps(const GeometricBoundingVolume *volume,
+              pvector<int> &indices) const {
+  indices.clear();
+  if (volume->is_empty()) {
+    return true;
+  }
+  if (volume->is_infinite()) {
+    return false;
+  }
+
+  bool result;
+  if (volume->is_of_type(FiniteBoundingVolume::get_class_type())) {
+    const FiniteBoundingVolume *fbv = (const FiniteBoundingVolume *)volume;
+    result = find_box_overlaps(fbv->get_min(), fbv->get_max(), indices);
+
+  } else if (volume->is_exact_type(BoundingLine::get_class_type())) {
+    const BoundingLine *line = (const BoundingLine *)volume;
+    const LPoint3 &origin = line->get_point_a();
+    result = find_line_overlaps(origin, line->get_point_b() - origin,
+                                -FLT_MAX, FLT_MAX, indices);
+
+  } else {
+    return false;
+  }
+
+  if (result) {
+    indices.insert(indices.end(), _unbounded.begin(), _unbounded.end());
+
+    // Report them in the order of the solids in the node, so that the
+    // collisions are detected in the same order as without the hierarchy.
+    std::sort(indices.begin(), indices.end());
+  }
+  return result;
+}
+
+/**
+ * Fills indices with the indices of the solids whose bounding volumes might
+ * be crossed by the indicated ray, between the origin and the point at the
+ * parametric distance max_t along the direction, in ascending order.
+ */
+void CollisionBVH::
+find_ray_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                  PN_stdfloat max_t, pvector<int> &indices) const {
+  indices.clear();
+  if (!find_line_overlaps(origin, direction, 0.0f, max_t, indices)) {
+    // A degenerate ray; let the solids sort it out.
+    indices.clear();
+    for (const Entry &entry : _entries) {
+      indices.push_back(entry._index);
+    }
+  }
+  indices.insert(indices.end(), _unbounded.begin(), _unbounded.end());
+  std::sort(indices.begin(), indices.end());
+}
+
+/**
+ * Collects the solids whose boxes overlap the indicated box.
+ */
+bool CollisionBVH::
+find_box_overlaps(const LPoint3 &min_point, const LPoint3 &max_point,
+                  pvector<int> &indices) const {
+  if (_nodes.empty()) {
+    return true;
+  }
+
+  int stack[64];
+  int stack_size = 0;
+  stack[stack_size++] = 0;
+
+  while (stack_size > 0) {
+    const Node &node = _nodes[stack[--stack_size]];
+    if (node._min[0] > max_point[0] || node._max[0] < min_point[0] ||
+        node._min[1] > max_point[1] || node._max[1] < min_point[1] ||
+        node._min[2] > max_point[2] || node._max[2] < min_point[2]) {
+      continue;
+    }
+
+    if (node._left < 0) {
+      for (int i = node._begin; i < node._end; ++i) {
+        const Entry &entry = _entries[i];
+        if (entry._min[0] <= max_point[0] && entry._max[0] >= min_point[0] &&
+            entry._min[1] <= max_point[1] && entry._max[1] >= min_point[1] &&
+            entry._min[2] <= max_point[2] && entry._max[2] >= min_point[2]) {
+          indices.push_back(entry._index);
+        }
+      }
+    } else {
+      nassertr(stack_size + 2 <= 64, false);
+      stack[stack_size++] = node._right;
+      stack[stack_size++] = node._left;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Returns true if the part of the line through origin in the indicated
+ * direction between the parametric distances t_min and t_max passes through
+ * the box, using the slab test.
+ */
+static inline bool
+line_intersects_box(const LPoint3 &origin, const LVector3 &direction,
+                    PN_stdfloat t_min, PN_stdfloat t_max,
+                    const LPoint3 &min_point, const LPoint3 &max_point) {
+  for (int i = 0; i < 3; ++i) {
+    if (IS_NEARLY_ZERO(direction[i])) {
+      if (origin[i] < min_point[i] || origin[i] > max_point[i]) {
+        return false;
+      }
+    } else {
+      PN_stdfloat t1 = (min_point[i] - origin[i]) / direction[i];
+      PN_stdfloat t2 = (max_point[i] - origin[i]) / direction[i];
+      if (t1 > t2) {
+        std::swap(t1, t2);
+      }
+      t_min = std::max(t_min, t1);
+      t_max = std::min(t_max, t2);
+      if (t_min > t_max) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Collects the solids whose boxes are crossed by the indicated line, between
+ * the indicated parametric distances along it.
+ */
+bool CollisionBVH::
+find_line_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                   PN_stdfloat min_t, PN_stdfloat max_t,
+                   pvector<int> &indices) const {
+  if (_nodes.empty()) {
+    return true;
+  }
+  if (direction.almost_equal(LVector3::zero())) {
+    return false;
+  }
+
+  int stack[64];
+  int stack_size = 0;
+  stack[stack_size++] = 0;
+
+  while (stack_size > 0) {
+    const Node &node = _nodes[stack[--stack_size]];
+    if (!line_intersects_box(origin, direction, min_t, max_t,
+                             node._min, node._max)) {
+      continue;
+    }
+
+    if (node._left < 0) {
+      for (int i = node._begin; i < node._end; ++i) {
+        const Entry &entry = _entries[i];
+        if (line_intersects_box(origin, direction, min_t, max_t,
+                                entry._min, entry._max)) {
+          indices.push_back(entry._index);
+        }
+      }
+    } else {
+      nassertr(stack_size + 2 <= 64, false);
+      stack[stack_size++] = node._right;
+      stack[stack_size++] = node._left;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Recursively builds the node for the indicated range of entries, by
+ * splitting it at the median along the axis in which the centers of the
+ * solids are most spread out.  Returns the index of the new node.
+ */
+int CollisionBVH::
+r_build(int begin, int end) {
+  int index = (int)_nodes.size();
+  _nodes.push_back(Node());
+
+  LPoint3 min_point = _entries[begin]._min;
+  LPoint3 max_point = _entries[begin]._max;
+  LPoint3 min_center = _entries[begin]._center;
+  LPoint3 max_center = _entries[begin]._center;
+  for (int i = begin + 1; i < end; ++i) {
+    const Entry &entry = _entries[i];
+    for (int j = 0; j < 3; ++j) {
+      min_point[j] = std::min(min_point[j], entry._min[j]);
+      max_point[j] = std::max(max_point[j], entry._max[j]);
+      min_center[j] = std::min(min_center[j], entry._center[j]);
+      max_center[j] = std::max(max_center[j], entry._center[j]);
+    }
+  }
+
+  int left = -1;
+  int right = -1;
+  if (end - begin > max_leaf_entries) {
+    LVector3 extent = max_center - min_center;
+    int axis = 0;
+    if (extent[1] > extent[axis]) {
+      axis = 1;
+    }
+    if (extent[2] > extent[axis]) {
+      axis = 2;
+    }
+
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(_entries.begin() + begin, _entries.begin() + mid,
+                     _entries.begin() + end,
+                     [axis](const Entry &a, const Entry &b) {
+      return a._center[axis] < b._center[axis];
+    });
+
+    left = r_build(begin, mid);
+    right = r_build(mid, end);
+  }
+
+  // The vector may have been reallocated by the recursive calls.
+  Node &node = _nodes[index];
+  node._min = min_point;
+  node._max = max_point;
+  node._left = left;
+  node._right = right;
+  node._begin = begin;
+  node._end = end;
+  return index;
+}
@@ -0,0 +1,85 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef COLLISIONBVH_H
+#define COLLISIONBVH_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "boundingVolume.h"
+#include "geometricBoundingVolume.h"
+#include "luse.h"
+#include "pvector.h"
+#include "pointerTo.h"
+
+/**
+ * A bounding-volume hierarchy of axis-aligned boxes over the solids of a
+ * single CollisionNode.  This is built on demand by a CollisionNode with many
+ * solids, and is used by the CollisionTraverser to quickly find the subset of
+ * solids whose bounding volumes might intersect a collider, instead of
+ * testing the bounding volume of each solid in turn.
+ *
+ * The hierarchy only ever discards solids that cannot possibly intersect; the
+ * remaining solids are still subjected to the usual bounding volume test.
+ */
+class EXPCL_PANDA_COLLIDE CollisionBVH : public ReferenceCount {
+public:
+  typedef pvector<CPT(BoundingVolume)> Bounds;
+  explicit CollisionBVH(const Bounds &bounds);
+
+  bool find_overlaps(const GeometricBoundingVolume *volume,
+                     pvector<int> &indices) const;
+  void find_ray_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                         PN_stdfloat max_t, pvector<int> &indices) const;
+
+  INLINE size_t get_num_nodes() const;
+
+private:
+  bool find_box_overlaps(const LPoint3 &min_point, const LPoint3 &max_point,
+                         pvector<int> &indices) const;
+  bool find_line_overlaps(const LPoint3 &origin, const LVector3 &direction,
+                          PN_stdfloat min_t, PN_stdfloat max_t,
+                          pvector<int> &indices) const;
+
+  int r_build(int begin, int end);
+
+  class Entry {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    LPoint3 _center;
+    int _index;
+  };
+  typedef pvector<Entry> Entries;
+  Entries _entries;
+
+  // Each node either has two children, or refers to a range of entries.
+  class Node {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    int _left;
+    int _right;
+    int _begin;
+    int _end;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  // Solids whose bounding volume is not finite are always reported.
+  pvector<int> _unbounded;
+};
+
+#include "collisionBVH.I"
+
+#endif
@@ -168,6 +168,7 @@ private:
 
   friend class CollisionTraverser;
   friend class CollisionHandlerFluidPusher;
+  friend class CollisionSolid;
 };
 
 INLINE std::ostream &operator << (std::ostream &out, const CollisionEntry &entry);
@@ -29,6 +29,7 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "config_mathutil.h"
+#include "lightMutexHolder.h"
 
 TypeHandle CollisionNode::_type_handle;
 
@@ -321,6 +322,40 @@ compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
 
   internal_bounds = gbv;
   internal_vertices = 0;
+
+  LightMutexHolder holder(_bvh_lock);
+  _bvh.clear();
+}
+
+/**
+ * Returns a bounding-volume hierarchy over the bounds of the solids in this
+ * node, building it first if necessary.  This is used by the
+ * CollisionTraverser to avoid testing each solid of a node with many solids.
+ *
+ * The hierarchy is rebuilt after the node's bounds have been recomputed, so
+ * it is only kept up-to-date if changes to the solids are made through
+ * modify_solid() or set_solid().
+ */
+CPT(CollisionBVH) CollisionNode::
+get_solid_bvh() const {
+  LightMutexHolder holder(_bvh_lock);
+  if (_bvh == nullptr) {
+    CollisionBVH::Bounds bounds;
+    bounds.reserve(_solids.size());
+
+    Solids::const_iterator si;
+    for (si = _solids.begin(); si != _solids.end(); ++si) {
+      CPT(CollisionSolid) solid = (*si).get_read_pointer();
+      CPT(BoundingVolume) volume = solid->get_bounds();
+      if (volume->is_of_type(GeometricBoundingVolume::get_class_type())) {
+        bounds.push_back(std::move(volume));
+      } else {
+        bounds.push_back(nullptr);
+      }
+    }
+    _bvh = new CollisionBVH(bounds);
+  }
+  return _bvh;
 }
 
 /**
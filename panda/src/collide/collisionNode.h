@@ -19,7 +19,9 @@
 #include "collisionSolid.h"
 
 #include "collideMask.h"
+#include "collisionBVH.h"
 #include "pandaNode.h"
+#include "lightMutex.h"
 
 /**
  * A node in the scene graph that can hold any number of CollisionSolids.
@@ -78,6 +80,9 @@ PUBLISHED:
   INLINE static CollideMask get_default_collide_mask();
   MAKE_PROPERTY(default_collide_mask, get_default_collide_mask);
 
+public:
+  CPT(CollisionBVH) get_solid_bvh() const;
+
 protected:
   virtual void compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
                                        int &internal_vertices,
@@ -95,6 +100,11 @@ private:
   typedef pvector< COWPT(CollisionSolid) > Solids;
   Solids _solids;
 
+  // The hierarchy over the bounds of the solids, built on demand by the
+  // CollisionTraverser.  It is discarded whenever the bounds are recomputed.
+  mutable LightMutex _bvh_lock;
+  mutable CPT(CollisionBVH) _bvh;
+
   friend class CollisionTraverser;
 
 public:
@@ -237,6 +237,25 @@ test_intersection_from_ray(const CollisionEntry &entry) const {
   return new_entry;
 }
 
+/**
+ * Tests the indicated ray, given in the plane's coordinate space, against
+ * the plane.  See CollisionSolid::intersect_ray().
+ */
+bool CollisionPlane::
+intersect_ray(PN_stdfloat &t, LVector3 &normal, const LPoint3 &origin,
+              const LVector3 &direction) const {
+  if (_plane.dist_to_plane(origin) < 0.0f) {
+    // The origin of the ray is behind the plane.
+    t = 0.0f;
+
+  } else if (!_plane.intersects_line(t, origin, direction) || t < 0.0f) {
+    return false;
+  }
+
+  normal = has_effective_normal() ? get_effective_normal() : get_normal();
+  return true;
+}
+
 /**
  *
  */
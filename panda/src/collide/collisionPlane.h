@@ -39,6 +39,10 @@ public:
 
   virtual void xform(const LMatrix4 &mat);
 
+  virtual bool intersect_ray(PN_stdfloat &t, LVector3 &normal,
+                             const LPoint3 &origin,
+                             const LVector3 &direction) const;
+
   virtual PStatCollector &get_volume_pcollector();
   virtual PStatCollector &get_test_pcollector();
 
@@ -712,6 +712,31 @@ test_intersection_from_ray(const CollisionEntry &entry) const {
   return new_entry;
 }
 
+/**
+ * Tests the indicated ray, given in the polygon's coordinate space, against
+ * the polygon.  See CollisionSolid::intersect_ray().  Unlike the usual
+ * intersection test, this does not take clip planes into account.
+ */
+bool CollisionPolygon::
+intersect_ray(PN_stdfloat &t, LVector3 &normal, const LPoint3 &origin,
+              const LVector3 &direction) const {
+  if (_points.size() < 3) {
+    return false;
+  }
+
+  if (!get_plane().intersects_line(t, origin, direction) || t < 0.0f) {
+    return false;
+  }
+
+  LPoint2 p = to_2d(origin + t * direction);
+  if (!point_is_inside(p, _points)) {
+    return false;
+  }
+
+  normal = has_effective_normal() ? get_effective_normal() : get_normal();
+  return true;
+}
+
 /**
  * This is part of the double-dispatch implementation of test_intersection().
  * It is called when the "from" object is a segment.
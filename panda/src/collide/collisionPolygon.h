@@ -70,6 +70,10 @@ PUBLISHED:
 public:
   virtual void xform(const LMatrix4 &mat);
 
+  virtual bool intersect_ray(PN_stdfloat &t, LVector3 &normal,
+                             const LPoint3 &origin,
+                             const LVector3 &direction) const;
+
   virtual PT(PandaNode) get_viz(const CullTraverser *trav,
                                 const CullTraverserData &data,
                                 bool bounds_only) const;
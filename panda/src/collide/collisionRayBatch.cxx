@@ -0,0 +1,474 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionRayBatch.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "collisionRayBatch.h"
+#include "collisionNode.h"
+#include "collisionSolid.h"
+#include "collisionBVH.h"
+#include "config_collide.h"
+#include "finiteBoundingVolume.h"
+#include "transformState.h"
+#include "pStatCollector.h"
+#include "pStatTimer.h"
+
+#include <limits>
+
+#if !defined(STDFLOAT_DOUBLE) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#include <emmintrin.h>
+#define RAY_BATCH_SSE
+#endif
+
+static PStatCollector ray_batch_pcollector("App:Collisions:Ray batch");
+
+/**
+ * The rays that are still of interest at one level of the traversal, stored
+ * as separate arrays of each component so that several of them may be tested
+ * against a bounding box at once.
+ */
+class CollisionRayBatch::Bundle {
+public:
+  INLINE size_t size() const {
+    return _index.size();
+  }
+
+  INLINE void clear() {
+    _index.clear();
+    _ox.clear(); _oy.clear(); _oz.clear();
+    _dx.clear(); _dy.clear(); _dz.clear();
+    _ix.clear(); _iy.clear(); _iz.clear();
+  }
+
+  INLINE void add(int index, const LPoint3 &origin, const LVector3 &direction) {
+    static const PN_stdfloat huge = std::numeric_limits<PN_stdfloat>::max();
+    _index.push_back(index);
+    _ox.push_back(origin[0]); _oy.push_back(origin[1]); _oz.push_back(origin[2]);
+    _dx.push_back(direction[0]); _dy.push_back(direction[1]); _dz.push_back(direction[2]);
+    // Axis-parallel rays get a huge, rather than an infinite, reciprocal, so
+    // that the slab test never has to multiply zero by infinity.
+    _ix.push_back(direction[0] != 0 ? 1 / direction[0] : huge);
+    _iy.push_back(direction[1] != 0 ? 1 / direction[1] : huge);
+    _iz.push_back(direction[2] != 0 ? 1 / direction[2] : huge);
+  }
+
+  INLINE void add_from(const Bundle &other, size_t i) {
+    _index.push_back(other._index[i]);
+    _ox.push_back(other._ox[i]); _oy.push_back(other._oy[i]); _oz.push_back(other._oz[i]);
+    _dx.push_back(other._dx[i]); _dy.push_back(other._dy[i]); _dz.push_back(other._dz[i]);
+    _ix.push_back(other._ix[i]); _iy.push_back(other._iy[i]); _iz.push_back(other._iz[i]);
+  }
+
+  INLINE LPoint3 get_origin(size_t i) const {
+    return LPoint3(_ox[i], _oy[i], _oz[i]);
+  }
+
+  INLINE LVector3 get_direction(size_t i) const {
+    return LVector3(_dx[i], _dy[i], _dz[i]);
+  }
+
+  pvector<int> _index;
+  pvector<PN_stdfloat> _ox, _oy, _oz;
+  pvector<PN_stdfloat> _dx, _dy, _dz;
+  pvector<PN_stdfloat> _ix, _iy, _iz;
+};
+
+/**
+ *
+ */
+CollisionRayBatch::
+CollisionRayBatch() :
+  _collide_mask(CollideMask::all_on()),
+  _num_hits(0)
+{
+}
+
+/**
+ *
+ */
+CollisionRayBatch::
+~CollisionRayBatch() {
+  for (Bundle *bundle : _bundles) {
+    delete bundle;
+  }
+}
+
+/**
+ * Removes all rays and segments from the batch, along with the results of
+ * the last traversal.
+ */
+void CollisionRayBatch::
+clear() {
+  _rays.clear();
+  _hits.clear();
+  _num_hits = 0;
+}
+
+/**
+ * Preallocates room for the indicated number of rays and segments.
+ */
+void CollisionRayBatch::
+reserve(size_t num_rays) {
+  _rays.reserve(num_rays);
+  _hits.reserve(num_rays);
+}
+
+/**
+ * Adds a ray that starts at the indicated origin and extends infinitely in
+ * the indicated direction, in the coordinate space of the root that will be
+ * passed to traverse().  Returns the index of the new ray.
+ */
+size_t CollisionRayBatch::
+add_ray(const LPoint3 &origin, const LVector3 &direction) {
+  Ray ray;
+  ray._origin = origin;
+  ray._direction = direction;
+  ray._max_t = std::numeric_limits<PN_stdfloat>::max();
+  _rays.push_back(ray);
+  return _rays.size() - 1;
+}
+
+/**
+ * Adds a line segment between the two indicated points, in the coordinate
+ * space of the root that will be passed to traverse().  Returns the index of
+ * the new segment.
+ */
+size_t CollisionRayBatch::
+add_segment(const LPoint3 &point_a, const LPoint3 &point_b) {
+  Ray ray;
+  ray._origin = point_a;
+  ray._direction = point_b - point_a;
+  ray._max_t = 1;
+  _rays.push_back(ray);
+  return _rays.size() - 1;
+}
+
+/**
+ * Replaces the nth ray or segment with a ray.  This allows the same batch to
+ * be reused from frame to frame without reallocating it.
+ */
+void CollisionRayBatch::
+set_ray(size_t n, const LPoint3 &origin, const LVector3 &direction) {
+  nassertv(n < _rays.size());
+  Ray &ray = _rays[n];
+  ray._origin = origin;
+  ray._direction = direction;
+  ray._max_t = std::numeric_limits<PN_stdfloat>::max();
+}
+
+/**
+ * Replaces the nth ray or segment with a line segment.
+ */
+void CollisionRayBatch::
+set_segment(size_t n, const LPoint3 &point_a, const LPoint3 &point_b) {
+  nassertv(n < _rays.size());
+  Ray &ray = _rays[n];
+  ray._origin = point_a;
+  ray._direction = point_b - point_a;
+  ray._max_t = 1;
+}
+
+/**
+ * Tests all of the rays and segments against the CollisionNodes at and below
+ * the indicated root, and records the nearest hit of each.  The rays are
+ * understood to be in the coordinate space of the root node.  Returns the
+ * number of rays and segments that hit something.
+ */
+int CollisionRayBatch::
+traverse(const NodePath &root) {
+  nassertr(!root.is_empty(), 0);
+  PStatTimer timer(ray_batch_pcollector);
+  Thread *current_thread = Thread::get_current_thread();
+
+  size_t num_rays = _rays.size();
+  _hits.resize(num_rays);
+  _num_hits = 0;
+
+  Bundle &bundle = get_bundle(0);
+  bundle.clear();
+  for (size_t i = 0; i < num_rays; ++i) {
+    const Ray &ray = _rays[i];
+    Hit &hit = _hits[i];
+    hit._t = ray._max_t;
+    hit._node = nullptr;
+    hit._solid_index = -1;
+    if (!ray._direction.almost_equal(LVector3::zero())) {
+      bundle.add((int)i, ray._origin, ray._direction);
+    }
+  }
+
+  // The root's own bounding volume is in the space of its parent, so we
+  // don't test against it; we start by testing its children's.
+  PandaNode *node = root.node();
+  if (bundle.size() != 0 &&
+      !(node->get_net_collide_mask(current_thread) & _collide_mask).is_zero()) {
+    r_traverse(node, LMatrix4::ident_mat(), 1, bundle, current_thread);
+  }
+
+  for (size_t i = 0; i < num_rays; ++i) {
+    if (_hits[i]._node == nullptr) {
+      _hits[i]._t = 0;
+    }
+  }
+  return _num_hits;
+}
+
+/**
+ * The recursive implementation of traverse().  The rays in the bundle are
+ * already in the coordinate space of the indicated node, and have already
+ * been tested against its bounding volume; net_mat converts from that space
+ * to the space of the root.
+ */
+void CollisionRayBatch::
+r_traverse(PandaNode *node, const LMatrix4 &net_mat, int depth,
+           const Bundle &bundle, Thread *current_thread) {
+  if (node->is_collision_node()) {
+    CollisionNode *cnode = (CollisionNode *)node;
+    if (!(cnode->get_into_collide_mask() & _collide_mask).is_zero()) {
+      test_collision_node(cnode, net_mat, bundle, current_thread);
+    }
+  }
+
+  PandaNode::Children children = node->get_children(current_thread);
+  size_t num_children = children.get_num_children();
+  size_t begin = 0;
+  size_t end = num_children;
+  if (node->has_single_child_visibility()) {
+    int index = node->get_visible_child();
+    if (index < 0 || (size_t)index >= num_children) {
+      return;
+    }
+    begin = (size_t)index;
+    end = begin + 1;
+  }
+
+  for (size_t ci = begin; ci < end; ++ci) {
+    PandaNode *child = children.get_child(ci);
+    if ((child->get_net_collide_mask(current_thread) & _collide_mask).is_zero()) {
+      continue;
+    }
+
+    // The child's bounding volume already includes its transform, so it is
+    // in our space, which is the space the rays are in now.  Discard the rays
+    // that miss it before bringing the others into the child's space.
+    CPT(BoundingVolume) bounds = child->get_bounds(current_thread);
+    const Bundle *clipped = clip_bundle(bounds, bundle, get_bundle(depth * 2));
+    if (clipped == nullptr) {
+      continue;
+    }
+
+    CPT(TransformState) transform = child->get_transform(current_thread);
+    if (transform->is_identity()) {
+      r_traverse(child, net_mat, depth + 1, *clipped, current_thread);
+      continue;
+    }
+    if (transform->is_invalid() || transform->is_singular()) {
+      continue;
+    }
+
+    // Bring the rays into the child's space.  The parametric distances along
+    // the rays are unchanged by an affine transform, so the hits we have
+    // found so far still apply.
+    const LMatrix4 &mat = transform->get_mat();
+    const LMatrix4 &inv = transform->get_inverse()->get_mat();
+    Bundle &xformed = get_bundle(depth * 2 + 1);
+    xformed.clear();
+    size_t num_rays = clipped->size();
+    for (size_t i = 0; i < num_rays; ++i) {
+      xformed.add(clipped->_index[i],
+                  inv.xform_point(clipped->get_origin(i)),
+                  inv.xform_vec(clipped->get_direction(i)));
+    }
+    r_traverse(child, mat * net_mat, depth + 1, xformed, current_thread);
+  }
+}
+
+/**
+ * Copies to out the rays in the bundle that pass through the indicated
+ * bounding volume, which must be in the same space as the rays, before they
+ * reach a hit we have already found.  Returns the bundle of rays that
+ * remain, which may be in itself if the volume is infinite, or nullptr if
+ * there are none left.
+ */
+const CollisionRayBatch::Bundle *CollisionRayBatch::
+clip_bundle(const BoundingVolume *bounds, const Bundle &in, Bundle &out) const {
+  if (bounds->is_empty()) {
+    return nullptr;
+  }
+  const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+  if (fbv == nullptr) {
+    return &in;
+  }
+  out.clear();
+
+  LPoint3 bmin = fbv->get_min();
+  LPoint3 bmax = fbv->get_max();
+  size_t num_rays = in.size();
+  size_t i = 0;
+
+#ifdef RAY_BATCH_SSE
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 minx = _mm_set1_ps(bmin[0]);
+  const __m128 miny = _mm_set1_ps(bmin[1]);
+  const __m128 minz = _mm_set1_ps(bmin[2]);
+  const __m128 maxx = _mm_set1_ps(bmax[0]);
+  const __m128 maxy = _mm_set1_ps(bmax[1]);
+  const __m128 maxz = _mm_set1_ps(bmax[2]);
+
+  for (; i + 4 <= num_rays; i += 4) {
+    __m128 tfar = _mm_set_ps(_hits[in._index[i + 3]]._t,
+                             _hits[in._index[i + 2]]._t,
+                             _hits[in._index[i + 1]]._t,
+                             _hits[in._index[i]]._t);
+    __m128 tnear = zero;
+
+    // The computed value is passed as the first operand of min/max, so that
+    // a NaN leaves the running interval unchanged.
+    __m128 o = _mm_loadu_ps(&in._ox[i]);
+    __m128 inv = _mm_loadu_ps(&in._ix[i]);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(minx, o), inv);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(maxx, o), inv);
+    tnear = _mm_max_ps(_mm_min_ps(t1, t2), tnear);
+    tfar = _mm_min_ps(_mm_max_ps(t1, t2), tfar);
+
+    o = _mm_loadu_ps(&in._oy[i]);
+    inv = _mm_loadu_ps(&in._iy[i]);
+    t1 = _mm_mul_ps(_mm_sub_ps(miny, o), inv);
+    t2 = _mm_mul_ps(_mm_sub_ps(maxy, o), inv);
+    tnear = _mm_max_ps(_mm_min_ps(t1, t2), tnear);
+    tfar = _mm_min_ps(_mm_max_ps(t1, t2), tfar);
+
+    o = _mm_loadu_ps(&in._oz[i]);
+    inv = _mm_loadu_ps(&in._iz[i]);
+    t1 = _mm_mul_ps(_mm_sub_ps(minz, o), inv);
+    t2 = _mm_mul_ps(_mm_sub_ps(maxz, o), inv);
+    tnear = _mm_max_ps(_mm_min_ps(t1, t2), tnear);
+    tfar = _mm_min_ps(_mm_max_ps(t1, t2), tfar);
+
+    int mask = _mm_movemask_ps(_mm_cmple_ps(tnear, tfar));
+    if (mask != 0) {
+      for (size_t j = 0; j < 4; ++j) {
+        if (mask & (1 << j)) {
+          out.add_from(in, i + j);
+        }
+      }
+    }
+  }
+#endif  // RAY_BATCH_SSE
+
+  for (; i < num_rays; ++i) {
+    PN_stdfloat tnear = 0;
+    PN_stdfloat tfar = _hits[in._index[i]]._t;
+
+    PN_stdfloat t1 = (bmin[0] - in._ox[i]) * in._ix[i];
+    PN_stdfloat t2 = (bmax[0] - in._ox[i]) * in._ix[i];
+    tnear = std::max(tnear, std::min(t1, t2));
+    tfar = std::min(tfar, std::max(t1, t2));
+
+    t1 = (bmin[1] - in._oy[i]) * in._iy[i];
+    t2 = (bmax[1] - in._oy[i]) * in._iy[i];
+    tnear = std::max(tnear, std::min(t1, t2));
+    tfar = std::min(tfar, std::max(t1, t2));
+
+    t1 = (bmin[2] - in._oz[i]) * in._iz[i];
+    t2 = (bmax[2] - in._oz[i]) * in._iz[i];
+    tnear = std::max(tnear, std::min(t1, t2));
+    tfar = std::min(tfar, std::max(t1, t2));
+
+    if (tnear <= tfar) {
+      out.add_from(in, i);
+    }
+  }
+
+  if (out.size() == 0) {
+    return nullptr;
+  }
+  return &out;
+}
+
+/**
+ * Tests the rays in the bundle, which are in the space of the indicated node,
+ * against each of its solids.
+ */
+void CollisionRayBatch::
+test_collision_node(CollisionNode *cnode, const LMatrix4 &net_mat,
+                    const Bundle &bundle, Thread *current_thread) {
+  size_t num_solids = cnode->get_num_solids();
+  size_t num_rays = bundle.size();
+
+  CPT(CollisionBVH) bvh;
+  if (collision_bvh_min_solids > 0 &&
+      num_solids >= (size_t)collision_bvh_min_solids) {
+    bvh = cnode->get_solid_bvh();
+  }
+
+  if (bvh == nullptr) {
+    for (size_t si = 0; si < num_solids; ++si) {
+      CPT(CollisionSolid) solid = cnode->get_solid(si);
+      for (size_t i = 0; i < num_rays; ++i) {
+        int ri = bundle._index[i];
+        PN_stdfloat t;
+        LVector3 normal;
+        if (solid->intersect_ray(t, normal, bundle.get_origin(i), bundle.get_direction(i))) {
+          record_hit(ri, t, normal, net_mat, cnode, (int)si);
+        }
+      }
+    }
+
+  } else {
+    for (size_t i = 0; i < num_rays; ++i) {
+      int ri = bundle._index[i];
+      LPoint3 origin = bundle.get_origin(i);
+      LVector3 direction = bundle.get_direction(i);
+      bvh->find_ray_overlaps(origin, direction, _hits[ri]._t, _indices);
+      for (int si : _indices) {
+        PN_stdfloat t;
+        LVector3 normal;
+        if (cnode->get_solid(si)->intersect_ray(t, normal, origin, direction)) {
+          record_hit(ri, t, normal, net_mat, cnode, si);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Records the indicated intersection of the rith ray, if it is nearer than
+ * any hit found for it so far.  The normal is given in the space of the node,
+ * and is converted to the space of the root.
+ */
+void CollisionRayBatch::
+record_hit(int ri, PN_stdfloat t, const LVector3 &normal,
+           const LMatrix4 &net_mat, PandaNode *node, int solid_index) {
+  Hit &hit = _hits[ri];
+  if (t < 0 || t > hit._t || (t == hit._t && hit._node != nullptr)) {
+    return;
+  }
+  if (hit._node == nullptr) {
+    ++_num_hits;
+  }
+  hit._t = t;
+  hit._normal = net_mat.xform_vec_general(normal);
+  hit._normal.normalize();
+  hit._node = node;
+  hit._solid_index = solid_index;
+}
+
+/**
+ * Returns the bundle with the indicated index, allocating it if necessary.
+ */
+CollisionRayBatch::Bundle &CollisionRayBatch::
+get_bundle(int index) {
+  while ((int)_bundles.size() <= index) {
+    _bundles.push_back(new Bundle);
+  }
+  return *_bundles[index];
+}
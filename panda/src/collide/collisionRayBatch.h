@@ -0,0 +1,117 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionRayBatch.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef COLLISIONRAYBATCH_H
+#define COLLISIONRAYBATCH_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "collideMask.h"
+#include "nodePath.h"
+#include "luse.h"
+#include "pvector.h"
+
+class CollisionNode;
+class CollisionSolid;
+
+/**
+ * A set of rays and line segments that may be tested against the
+ * CollisionNodes in a subgraph all at once, for applications that need to
+ * cast a large number of rays each frame, such as line-of-sight tests.
+ *
+ * This is much cheaper than setting up a CollisionRay in a CollisionNode for
+ * each query and running a CollisionTraverser, since no nodes or
+ * CollisionEntry objects are created: only the nearest hit of each ray is
+ * recorded, in a compact table that is reused from one traversal to the
+ * next.  Rays and segments that miss the bounding volume of a node are
+ * discarded for the whole subgraph below it, several rays at a time.
+ *
+ * Only CollisionNodes are considered; visible geometry is not.  Clip planes
+ * are not taken into account.
+ */
+class EXPCL_PANDA_COLLIDE CollisionRayBatch : public ReferenceCount {
+PUBLISHED:
+  CollisionRayBatch();
+
+  INLINE void set_collide_mask(CollideMask mask);
+  INLINE CollideMask get_collide_mask() const;
+  MAKE_PROPERTY(collide_mask, get_collide_mask, set_collide_mask);
+
+  void clear();
+  void reserve(size_t num_rays);
+  size_t add_ray(const LPoint3 &origin, const LVector3 &direction);
+  size_t add_segment(const LPoint3 &point_a, const LPoint3 &point_b);
+  void set_ray(size_t n, const LPoint3 &origin, const LVector3 &direction);
+  void set_segment(size_t n, const LPoint3 &point_a, const LPoint3 &point_b);
+  INLINE size_t get_num_rays() const;
+
+  BLOCKING int traverse(const NodePath &root);
+
+  INLINE int get_num_hits() const;
+  INLINE bool has_hit(size_t n) const;
+  INLINE PN_stdfloat get_hit_t(size_t n) const;
+  INLINE LPoint3 get_hit_pos(size_t n) const;
+  INLINE LVector3 get_hit_normal(size_t n) const;
+  INLINE PandaNode *get_hit_node(size_t n) const;
+  INLINE int get_hit_solid_index(size_t n) const;
+
+private:
+  class Bundle;
+  void r_traverse(PandaNode *node, const LMatrix4 &net_mat, int depth,
+                  const Bundle &bundle, Thread *current_thread);
+  const Bundle *clip_bundle(const BoundingVolume *bounds, const Bundle &in,
+                            Bundle &out) const;
+  void test_collision_node(CollisionNode *cnode, const LMatrix4 &net_mat,
+                           const Bundle &bundle, Thread *current_thread);
+  void record_hit(int ri, PN_stdfloat t, const LVector3 &normal,
+                  const LMatrix4 &net_mat, PandaNode *node, int solid_index);
+  Bundle &get_bundle(int index);
+
+private:
+  CollideMask _collide_mask;
+
+  class Ray {
+  public:
+    LPoint3 _origin;
+    LVector3 _direction;
+    PN_stdfloat _max_t;
+  };
+  typedef pvector<Ray> Rays;
+  Rays _rays;
+
+  // The nearest hit of each ray so far.  _t is the ray's _max_t if it has
+  // not hit anything.
+  class Hit {
+  public:
+    PN_stdfloat _t;
+    LVector3 _normal;
+    PandaNode *_node;
+    int _solid_index;
+  };
+  typedef pvector<Hit> Hits;
+  Hits _hits;
+  int _num_hits;
+
+  // The rays that are still of interest at each level of the traversal, in
+  // the local space of the node at that level.  These are kept around to
+  // avoid reallocating them each time.
+  pvector<Bundle *> _bundles;
+  pvector<int> _indices;
+
+public:
+  ~CollisionRayBatch();
+};
+
+#include "collisionRayBatch.I"
+
+#endif
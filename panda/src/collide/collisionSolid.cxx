@@ -111,6 +111,47 @@ test_intersection(const CollisionEntry &) const {
   return nullptr;
 }
 
+/**
+ * Tests the ray with the indicated origin and direction, which are given in
+ * the solid's own coordinate space, against this solid.  If the ray hits the
+ * solid, fills in t with the parametric distance along the ray to the first
+ * point of intersection, as well as the surface normal at that point, and
+ * returns true.
+ *
+ * This is used by the CollisionRayBatch.  This default implementation falls
+ * back to the general test_intersection_from_ray(), which is slower, since it
+ * requires a temporary CollisionRay and CollisionEntry; solids that are
+ * commonly used as obstacles should override it.
+ */
+bool CollisionSolid::
+intersect_ray(PN_stdfloat &t, LVector3 &normal, const LPoint3 &origin,
+              const LVector3 &direction) const {
+  // The ray is already in our coordinate space, so we test it from a node
+  // into the same node.
+  static const NodePath space("ray-space");
+
+  CollisionEntry entry;
+  entry._from = new CollisionRay(origin, direction);
+  entry._into = this;
+  entry._from_node_path = space;
+  entry._into_node_path = space;
+
+  PT(CollisionEntry) result = test_intersection_from_ray(entry);
+  if (result == nullptr || !result->has_surface_point()) {
+    return false;
+  }
+
+  LVector3 offset = result->_surface_point - origin;
+  t = offset.dot(direction) / direction.length_squared();
+  if (result->has_surface_normal()) {
+    normal = result->_surface_normal;
+  } else {
+    normal = -direction;
+    normal.normalize();
+  }
+  return true;
+}
+
 /**
  * Transforms the solid by the indicated matrix.
  */
@@ -393,6 +393,34 @@ test_intersection_from_ray(const CollisionEntry &entry) const {
   return new_entry;
 }
 
+/**
+ * Tests the indicated ray, given in the sphere's coordinate space, against
+ * the sphere.  See CollisionSolid::intersect_ray().
+ */
+bool CollisionSphere::
+intersect_ray(PN_stdfloat &t, LVector3 &normal, const LPoint3 &origin,
+              const LVector3 &direction) const {
+  double t1, t2;
+  if (!intersects_line(t1, t2, origin, direction, 0.0f)) {
+    return false;
+  }
+
+  if (t2 < 0.0) {
+    // Both intersection points are before the start of the ray.
+    return false;
+  }
+
+  t = (PN_stdfloat)max(t1, 0.0);
+
+  if (has_effective_normal()) {
+    normal = get_effective_normal();
+  } else {
+    normal = (origin + t * direction) - get_center();
+    normal.normalize();
+  }
+  return true;
+}
+
 /**
  *
  */
@@ -39,6 +39,10 @@ public:
   virtual PT(CollisionEntry)
   test_intersection(const CollisionEntry &entry) const;
 
+  virtual bool intersect_ray(PN_stdfloat &t, LVector3 &normal,
+                             const LPoint3 &origin,
+                             const LVector3 &direction) const;
+
   virtual void xform(const LMatrix4 &mat);
 
   virtual PStatCollector &get_volume_pcollector();
@@ -35,6 +35,8 @@
 #include "nodePath.h"
 #include "pStatTimer.h"
 #include "indent.h"
+#include "asyncParallelJob.h"
+#include "collisionBVH.h"
 
 #include <algorithm>
 
@@ -48,6 +50,58 @@ PStatCollector CollisionTraverser::_geom_volume_pcollector("Collision Volumes:Ge
 
 TypeHandle CollisionTraverser::_type_handle;
 
+/**
+ * A parallel traversal.  Each pass covers a different subset of the
+ * colliders, and is one item of the job.
+ */
+class CollisionTraverser::ParallelJob : public AsyncParallelJob {
+public:
+  ParallelJob() : AsyncParallelJob("collide", TP_high) {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+
+public:
+  CollisionTraverser *_trav;
+  LevelStatesSingle *_level_states;
+};
+
+/**
+ * A CollisionHandler that holds on to the entries detected during one pass of
+ * a parallel traversal, along with the handler each was meant for, so that
+ * they may be passed on to those handlers afterwards, in the same order.
+ */
+class CollisionTraverser::PassBuffer : public CollisionHandler {
+public:
+  void set_target(CollisionHandler *handler) {
+    _target = handler;
+    _wants_all_potential_collidees = handler->wants_all_potential_collidees();
+  }
+
+  virtual void add_entry(CollisionEntry *entry) {
+    Record record;
+    record._handler = _target;
+    record._entry = entry;
+    _records.push_back(std::move(record));
+  }
+
+  void flush() {
+    for (Record &record : _records) {
+      record._handler->add_entry(record._entry);
+    }
+    _records.clear();
+  }
+
+private:
+  class Record {
+  public:
+    CollisionHandler *_handler;
+    PT(CollisionEntry) _entry;
+  };
+  pvector<Record> _records;
+  CollisionHandler *_target = nullptr;
+};
+
 // This function object class is used in prepare_colliders(), below.
 class SortByColliderSort {
 public:
@@ -272,12 +326,21 @@ traverse(const NodePath &root) {
   }
 
   bool traversal_done = false;
-  if ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
-      !allow_collider_multiple) {
+  if (collision_num_threads > 0 && _colliders.size() > 1 && !has_recorder() &&
+      Thread::is_threading_supported()) {
+    // Divide the colliders up among several threads.
+    traverse_parallel(root, collision_num_threads);
+    traversal_done = true;
+  }
+
+  if (!traversal_done &&
+      ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
+       !allow_collider_multiple)) {
     // Use the single-word-at-a-time traverser, which might need to make lots
     // of passes.
     LevelStatesSingle level_states;
-    prepare_colliders_single(level_states, root);
+    prepare_colliders_single(level_states, root,
+                             CollisionLevelStateSingle::get_max_colliders());
 
     if (level_states.size() == 1 || !allow_collider_multiple) {
       traversal_done = true;
@@ -486,13 +549,13 @@ write(std::ostream &out, int indent_level) const {
  * use.
  *
  * This flavor uses a CollisionLevelStateSingle, which is limited to a certain
- * number of colliders per pass (typically 32).
+ * number of colliders per pass (typically 32).  The passes are made to hold
+ * no more than max_colliders colliders, which may not exceed that number.
  */
 void CollisionTraverser::
 prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
-                         const NodePath &root) {
+                         const NodePath &root, int max_colliders) {
   int num_colliders = _colliders.size();
-  int max_colliders = CollisionLevelStateSingle::get_max_colliders();
 
   CollisionLevelStateSingle level_state(root);
   // This reserve() call is only correct if there is exactly one solid per
@@ -603,7 +666,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -648,7 +711,7 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -814,7 +877,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -859,7 +922,7 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -1025,7 +1088,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -1070,7 +1133,7 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv, pass);
         }
       }
     }
@@ -1114,6 +1177,83 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
   }
 }
 
+/**
+ * Performs the traversal by dividing the colliders into a number of passes,
+ * which are traversed in parallel by the threads of the "collide" task chain
+ * as well as by the current thread.  The entries detected in each pass are
+ * held back and passed to the handlers afterwards, pass by pass, so that the
+ * order in which the handlers see them does not depend on the timing of the
+ * threads.
+ */
+void CollisionTraverser::
+traverse_parallel(const NodePath &root, int num_threads) {
+  int num_colliders = (int)_colliders.size();
+  int max_colliders = (num_colliders + num_threads) / (num_threads + 1);
+  max_colliders = std::max(max_colliders, 1);
+  max_colliders = std::min(max_colliders, CollisionLevelStateSingle::get_max_colliders());
+
+  LevelStatesSingle level_states;
+  prepare_colliders_single(level_states, root, max_colliders);
+
+  int num_passes = (int)level_states.size();
+  if (num_passes < 2) {
+    for (size_t pass = 0; pass < level_states.size(); ++pass) {
+#ifdef DO_PSTATS
+      PStatTimer pass_timer(get_pass_collector(pass));
+#endif
+      r_traverse_single(level_states[pass], pass);
+    }
+    return;
+  }
+
+  // Create the collectors up front, since the threads can't safely do it.
+  get_pass_collector(num_passes - 1);
+
+  pvector<PT(PassBuffer)> buffers;
+  buffers.reserve(num_passes);
+  for (int i = 0; i < num_passes; ++i) {
+    buffers.push_back(new PassBuffer);
+    _pass_buffers.push_back(buffers.back());
+  }
+
+  ParallelJob job;
+  job._trav = this;
+  job._level_states = &level_states;
+  job.run(num_passes, num_threads);
+
+  _pass_buffers.clear();
+  for (PassBuffer *buffer : buffers) {
+    buffer->flush();
+  }
+}
+
+/**
+ * Traverses the nth pass.  Called from each thread that takes part in the
+ * job.
+ */
+void CollisionTraverser::ParallelJob::
+do_item(int n, Thread *) {
+#ifdef DO_PSTATS
+  PStatTimer pass_timer(_trav->_pass_collectors[n]);
+#endif
+  _trav->r_traverse_single((*_level_states)[n], n);
+}
+
+/**
+ * Returns the handler that should be given the entries detected for a
+ * collider served by the indicated handler, during the indicated pass.  This
+ * is the handler itself, except during a parallel traversal.
+ */
+CollisionHandler *CollisionTraverser::
+get_pass_handler(CollisionHandler *handler, size_t pass) {
+  if (_pass_buffers.empty()) {
+    return handler;
+  }
+  PassBuffer *buffer = _pass_buffers[pass];
+  buffer->set_target(handler);
+  return buffer;
+}
+
 /**
  *
  */
@@ -1121,7 +1261,8 @@ void CollisionTraverser::
 compare_collider_to_node(CollisionEntry &entry,
                          const GeometricBoundingVolume *from_parent_gbv,
                          const GeometricBoundingVolume *from_node_gbv,
-                         const GeometricBoundingVolume *into_node_gbv) {
+                         const GeometricBoundingVolume *into_node_gbv,
+                         size_t pass) {
   bool within_node_bounds = true;
   if (from_parent_gbv != nullptr &&
       into_node_gbv != nullptr) {
@@ -1151,11 +1292,23 @@ compare_collider_to_node(CollisionEntry &entry,
       Colliders::const_iterator ci;
       ci = _colliders.find(entry.get_from_node_path());
       nassertv(ci != _colliders.end());
-      entry.test_intersection((*ci).second, this);
+      entry.test_intersection(get_pass_handler((*ci).second, pass), this);
     } else {
-      CollisionNode::Solids::const_iterator si;
-      for (si = cnode->_solids.begin(); si != cnode->_solids.end(); ++si) {
-        entry._into = (*si).get_read_pointer(current_thread);
+      // If the node has many solids, ask its bounding-volume hierarchy which
+      // of them we might possibly intersect, rather than testing them all.
+      pvector<int> indices;
+      bool use_bvh = false;
+      if (collision_bvh_min_solids > 0 &&
+          num_solids >= collision_bvh_min_solids &&
+          from_node_gbv != nullptr) {
+        CPT(CollisionBVH) bvh = cnode->get_solid_bvh();
+        use_bvh = bvh->find_overlaps(from_node_gbv, indices);
+      }
+
+      int num_tests = use_bvh ? (int)indices.size() : num_solids;
+      for (int i = 0; i < num_tests; ++i) {
+        int si = use_bvh ? indices[i] : i;
+        entry._into = cnode->_solids[si].get_read_pointer(current_thread);
 
         // We should allow a collision test for solid into itself, because the
         // solid might be simply instanced into multiple different
@@ -1167,7 +1320,7 @@ compare_collider_to_node(CollisionEntry &entry,
           solid_gbv = (const GeometricBoundingVolume *)solid_bv.p();
         }
 
-        compare_collider_to_solid(entry, from_node_gbv, solid_gbv);
+        compare_collider_to_solid(entry, from_node_gbv, solid_gbv, pass);
       }
     }
   }
@@ -1180,7 +1333,8 @@ void CollisionTraverser::
 compare_collider_to_geom_node(CollisionEntry &entry,
                               const GeometricBoundingVolume *from_parent_gbv,
                               const GeometricBoundingVolume *from_node_gbv,
-                              const GeometricBoundingVolume *into_node_gbv) {
+                              const GeometricBoundingVolume *into_node_gbv,
+                              size_t pass) {
   bool within_node_bounds = true;
   if (from_parent_gbv != nullptr &&
       into_node_gbv != nullptr) {
@@ -1208,7 +1362,7 @@ compare_collider_to_geom_node(CollisionEntry &entry,
           DCAST_INTO_V(geom_gbv, geom_bv);
         }
 
-        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv);
+        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv, pass);
       }
     }
   }
@@ -1220,7 +1374,8 @@ compare_collider_to_geom_node(CollisionEntry &entry,
 void CollisionTraverser::
 compare_collider_to_solid(CollisionEntry &entry,
                           const GeometricBoundingVolume *from_node_gbv,
-                          const GeometricBoundingVolume *solid_gbv) {
+                          const GeometricBoundingVolume *solid_gbv,
+                          size_t pass) {
   bool within_solid_bounds = true;
   if (from_node_gbv != nullptr &&
       solid_gbv != nullptr) {
@@ -1241,7 +1396,7 @@ compare_collider_to_solid(CollisionEntry &entry,
     Colliders::const_iterator ci;
     ci = _colliders.find(entry.get_from_node_path());
     nassertv(ci != _colliders.end());
-    entry.test_intersection((*ci).second, this);
+    entry.test_intersection(get_pass_handler((*ci).second, pass), this);
   }
 }
 
@@ -1251,7 +1406,8 @@ compare_collider_to_solid(CollisionEntry &entry,
 void CollisionTraverser::
 compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                          const GeometricBoundingVolume *from_node_gbv,
-                         const GeometricBoundingVolume *geom_gbv) {
+                         const GeometricBoundingVolume *geom_gbv,
+                         size_t pass) {
   bool within_geom_bounds = true;
   if (from_node_gbv != nullptr &&
       geom_gbv != nullptr) {
@@ -1302,7 +1458,7 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(get_pass_handler((*ci).second, pass), this);
               }
             }
           }
@@ -1332,7 +1488,7 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(get_pass_handler((*ci).second, pass), this);
               }
             }
           }
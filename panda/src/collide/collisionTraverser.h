@@ -85,7 +85,8 @@ PUBLISHED:
 
 private:
   typedef pvector<CollisionLevelStateSingle> LevelStatesSingle;
-  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root);
+  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root,
+                                int max_colliders);
   void r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass);
 
   typedef pvector<CollisionLevelStateDouble> LevelStatesDouble;
@@ -96,20 +97,30 @@ private:
   void prepare_colliders_quad(LevelStatesQuad &level_states, const NodePath &root);
   void r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass);
 
+  class ParallelJob;
+  friend class ParallelJob;
+  class PassBuffer;
+  void traverse_parallel(const NodePath &root, int num_threads);
+  CollisionHandler *get_pass_handler(CollisionHandler *handler, size_t pass);
+
   void compare_collider_to_node(CollisionEntry &entry,
                                 const GeometricBoundingVolume *from_parent_gbv,
                                 const GeometricBoundingVolume *from_node_gbv,
-                                const GeometricBoundingVolume *into_node_gbv);
+                                const GeometricBoundingVolume *into_node_gbv,
+                                size_t pass);
   void compare_collider_to_geom_node(CollisionEntry &entry,
                                      const GeometricBoundingVolume *from_parent_gbv,
                                      const GeometricBoundingVolume *from_node_gbv,
-                                     const GeometricBoundingVolume *into_node_gbv);
+                                     const GeometricBoundingVolume *into_node_gbv,
+                                     size_t pass);
   void compare_collider_to_solid(CollisionEntry &entry,
                                  const GeometricBoundingVolume *from_node_gbv,
-                                 const GeometricBoundingVolume *solid_gbv);
+                                 const GeometricBoundingVolume *solid_gbv,
+                                 size_t pass);
   void compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                                 const GeometricBoundingVolume *from_node_gbv,
-                                const GeometricBoundingVolume *solid_gbv);
+                                const GeometricBoundingVolume *solid_gbv,
+                                size_t pass);
 
   PStatCollector &get_pass_collector(int pass);
 
@@ -132,6 +143,9 @@ private:
 
   Handlers::iterator remove_handler(Handlers::iterator hi);
 
+  // These are only filled in during a parallel traversal.
+  pvector<PassBuffer *> _pass_buffers;
+
   bool _respect_prev_transform;
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder *_recorder;
@@ -111,6 +111,26 @@ ConfigVariableBool pushers_horizontal
           "set_horizontal() flag by default, false to let the move "
           "in three dimensions by default."));
 
+ConfigVariableInt collision_num_threads
+("collision-num-threads", 0,
+ PRC_DESC("Set this to a positive number to allow each CollisionTraverser to "
+          "divide its colliders into groups, which are traversed in parallel "
+          "by this many worker threads in addition to the thread that calls "
+          "traverse().  The detected collisions are passed to the handlers "
+          "afterwards, in an order that does not depend on the timing of the "
+          "threads.  This is not used while a CollisionRecorder is attached.  "
+          "Set this to 0 to perform all collision traversals on the calling "
+          "thread."));
+
+ConfigVariableInt collision_bvh_min_solids
+("collision-bvh-min-solids", 16,
+ PRC_DESC("A CollisionNode with at least this many solids will build a "
+          "bounding-volume hierarchy over its solids the first time a "
+          "collider enters its bounding volume, and keep it until its "
+          "solids are changed.  This avoids testing the bounding volume of "
+          "every solid in turn.  Set this to 0 to disable the use of these "
+          "hierarchies."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -7,6 +7,7 @@
 #include "collisionPolygon.cxx"
 #include "collisionFloorMesh.cxx"
 #include "collisionRay.cxx"
+#include "collisionRayBatch.cxx"
 #include "collisionRecorder.cxx"
 #include "collisionSegment.cxx"
 #include "collisionSolid.cxx"
@@ -108,6 +108,17 @@ ConfigVariableDouble subprocess_window_max_wait
           "having flipped the previous one.  This is designed to allow the Python "
           "process some time to run even when the parent window is offscreen or minimized."));
 
+ConfigVariableInt cull_region_num_threads
+("cull-region-num-threads", 0,
+ PRC_DESC("Set this to a positive number to cull the DisplayRegions of all "
+          "windows handled by a cull thread in parallel, on this many worker "
+          "threads in addition to the cull thread itself.  The culled "
+          "objects are still handed to the cull results in sort order on the "
+          "cull thread.  DisplayRegions with a cull callback are always "
+          "culled on the cull thread.  This requires that any cull callbacks "
+          "in the scene graph are safe to call from multiple threads.  Set "
+          "this to 0 to cull the DisplayRegions one at a time."));
+
 ConfigVariableString screenshot_filename
 ("screenshot-filename", "%~p-%a-%b-%d-%H-%M-%S-%Y-%~f.%~e",
  PRC_DESC("This specifies the filename pattern to be used to generate "
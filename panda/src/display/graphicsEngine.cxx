@@ -49,6 +49,8 @@
 #include "callbackGraphicsWindow.h"
 #include "depthTestAttrib.h"
 #include "unionBoundingVolume.h"
+#include "bufferedCullHandler.h"
+#include "asyncParallelJob.h"
 
 #if defined(_WIN32) && defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
 #include "winInputDeviceManager.h"
@@ -143,6 +145,41 @@ INLINE static bool operator < (const CullKey &a, const CullKey &b) {
   return a._lens_index < b._lens_index;
 }
 
+/**
+ * A DisplayRegion whose cull has been put off by cull_to_bins(), so that it
+ * may be culled in parallel with the others.
+ */
+class GraphicsEngine::PendingCull {
+public:
+  GraphicsOutput *_win;
+  GraphicsStateGuardian *_gsg;
+  PT(DisplayRegion) _dr;
+  PT(SceneSetup) _scene_setup;
+  PT(CullResult) _cull_result;
+  bool _has_cull_callback;
+};
+
+/**
+ * The culling of a set of DisplayRegions in parallel.  Each DisplayRegion is
+ * one item of the job, and the objects found in it are recorded in its own
+ * BufferedCullHandler.
+ *
+ * This uses a separate task chain from the one used by the CullTraverser to
+ * traverse a single scene in parallel, so that the two can be sized
+ * independently.
+ */
+class GraphicsEngine::CullRegionJob : public AsyncParallelJob {
+public:
+  CullRegionJob() : AsyncParallelJob("cull_region", TP_high) {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+
+public:
+  PendingCull *_pending;
+  BufferedCullHandler *_handlers;
+};
+
 /**
  * Creates a new GraphicsEngine object.  The Pipeline is normally left to
  * default to NULL, which indicates the global render pipeline, but it may be
@@ -1535,6 +1572,15 @@ cull_to_bins(GraphicsEngine::Windows wlist, Thread *current_thread) {
   pvector<PT(SceneSetup)> shadow_passes;
   pmap<NodePath, UnionBoundingVolume> non_shadow_bounds;
 
+  // If we may use multiple threads, we first collect all of the
+  // DisplayRegions that need to be culled, and cull them afterwards.
+#ifdef HAVE_THREADS
+  bool parallel = (cull_region_num_threads > 0);
+#else
+  bool parallel = false;
+#endif
+  pvector<PendingCull> pending;
+
   size_t wlist_size = wlist.size();
   for (size_t wi = 0; wi < wlist_size; ++wi) {
     GraphicsOutput *win = wlist[wi];
@@ -1594,7 +1640,12 @@ cull_to_bins(GraphicsEngine::Windows wlist, Thread *current_thread) {
               cull_result = new CullResult(gsg, dr->get_draw_region_pcollector());
             }
             (*aci).second = dr;
-            cull_to_bins(win, gsg, dr, scene_setup, cull_result, current_thread);
+            if (parallel) {
+              pending.push_back({win, gsg, dr, scene_setup, cull_result,
+                                 dr->get_cull_callback() != nullptr});
+            } else {
+              cull_to_bins(win, gsg, dr, scene_setup, cull_result, current_thread);
+            }
 
           } else {
             // We have already culled a scene using this camera in this
@@ -1636,7 +1687,12 @@ cull_to_bins(GraphicsEngine::Windows wlist, Thread *current_thread) {
         // This DisplayRegion has no cull results; draw it.
         cull_result = new CullResult(gsg, dr->get_draw_region_pcollector());
       }
-      cull_to_bins(win, gsg, dr, scene_setup, cull_result, current_thread);
+      if (parallel) {
+        pending.push_back({win, gsg, dr, scene_setup, cull_result,
+                           dr->get_cull_callback() != nullptr});
+      } else {
+        cull_to_bins(win, gsg, dr, scene_setup, cull_result, current_thread);
+      }
     }
     else if (display_cat.is_spam()) {
       display_cat.spam()
@@ -1648,6 +1704,10 @@ cull_to_bins(GraphicsEngine::Windows wlist, Thread *current_thread) {
     // to draw this at all.
     dr->set_cull_result(std::move(cull_result), std::move(scene_setup), current_thread);
   }
+
+  if (!pending.empty()) {
+    cull_regions_parallel(pending, current_thread);
+  }
 }
 
 /**
@@ -1676,6 +1736,77 @@ cull_to_bins(GraphicsOutput *win, GraphicsStateGuardian *gsg,
   cull_result->finish_cull(scene_setup, current_thread);
 }
 
+/**
+ * Called at the end of cull_to_bins(), above, to cull the DisplayRegions that
+ * it has collected.  The scene graph traversals are distributed across the
+ * threads of the cull-region task chain, and the objects they find are then
+ * handed to the cull results on this thread, in sort order.
+ */
+void GraphicsEngine::
+cull_regions_parallel(pvector<PendingCull> &pending, Thread *current_thread) {
+  int num_pending = (int)pending.size();
+  int num_parallel = 0;
+  for (const PendingCull &pc : pending) {
+    if (!pc._has_cull_callback) {
+      ++num_parallel;
+    }
+  }
+
+  if (num_parallel < 2) {
+    // Not worth the trouble.
+    for (PendingCull &pc : pending) {
+      cull_to_bins(pc._win, pc._gsg, pc._dr, pc._scene_setup, pc._cull_result,
+                   current_thread);
+    }
+    return;
+  }
+
+  CullRegionJob job;
+  job._pending = &pending[0];
+  job._handlers = new BufferedCullHandler[num_pending];
+  job.run(num_pending, cull_region_num_threads);
+
+  // Now hand the objects to the cull results, in the original order.  This
+  // is done here, rather than in the worker threads, because the GSG's
+  // munger caches are not safe to access from multiple threads at once.
+  for (int i = 0; i < num_pending; ++i) {
+    PendingCull &pc = pending[i];
+    if (pc._has_cull_callback) {
+      cull_to_bins(pc._win, pc._gsg, pc._dr, pc._scene_setup, pc._cull_result,
+                   current_thread);
+      continue;
+    }
+
+    // The traverser must be told again about the scene, so that it reports
+    // this thread rather than the worker thread to the cull result.
+    CullTraverser *trav = pc._dr->get_cull_traverser();
+    trav->set_scene(pc._scene_setup, pc._gsg, pc._dr->get_incomplete_render());
+
+    BinCullHandler cull_handler(pc._cull_result);
+    trav->set_cull_handler(&cull_handler);
+    job._handlers[i].flush(&cull_handler, trav);
+    trav->set_cull_handler(nullptr);
+
+    PStatTimer timer(_cull_sort_pcollector, current_thread);
+    pc._cull_result->finish_cull(pc._scene_setup, current_thread);
+  }
+
+  delete[] job._handlers;
+}
+
+/**
+ * Culls the nth DisplayRegion, unless it has a cull callback, in which case
+ * it is culled afterwards by the calling thread.  Called from each thread
+ * that takes part in the job.
+ */
+void GraphicsEngine::CullRegionJob::
+do_item(int n, Thread *current_thread) {
+  PendingCull &pc = _pending[n];
+  if (!pc._has_cull_callback) {
+    pc._dr->do_cull(&_handlers[n], pc._scene_setup, pc._gsg, current_thread);
+  }
+}
+
 /**
  * This is called in the draw thread by individual RenderThread objects during
  * the frame rendering.  It issues the graphics commands to draw the objects
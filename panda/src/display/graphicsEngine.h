@@ -154,6 +154,12 @@ private:
   void cull_to_bins(GraphicsOutput *win, GraphicsStateGuardian *gsg,
                     DisplayRegion *dr, SceneSetup *scene_setup,
                     CullResult *cull_result, Thread *current_thread);
+
+  class PendingCull;
+  class CullRegionJob;
+  void cull_regions_parallel(pvector<PendingCull> &pending,
+                             Thread *current_thread);
+
   void draw_bins(const Windows &wlist, Thread *current_thread);
   void make_contexts(const Windows &wlist, Thread *current_thread);
 
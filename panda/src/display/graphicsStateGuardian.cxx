@@ -58,6 +58,7 @@
 #include "clipPlaneAttrib.h"
 #include "fogAttrib.h"
 #include "config_pstatclient.h"
+#include "reMutexHolder.h"
 
 #include <limits.h>
 
@@ -301,11 +302,14 @@ GraphicsStateGuardian::
   // Note that if uniquify-states is false, we can't iterate over all the
   // states, and some GSGs will linger.  Let's hope this isn't a problem.
   LightReMutexHolder holder(*RenderState::_states_lock);
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
-    state->_mungers.remove(_id);
-    state->_munged_states.remove(_id);
+  for (RenderState::StatesShard &shard : RenderState::_states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const RenderState *state = shard._states.get_key(si);
+      state->_mungers.remove(_id);
+      state->_munged_states.remove(_id);
+    }
   }
 }
 
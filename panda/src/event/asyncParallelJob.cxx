@@ -0,0 +1,264 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncParallelJob.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "asyncParallelJob.h"
+#include "asyncTaskManager.h"
+#include "mutexHolder.h"
+
+// This is a reference to an allocated Mutex, instead of just a static Mutex,
+// to protect against ordering issues when the application shuts down.
+Mutex &AsyncParallelJob::_chains_lock = *(new Mutex("AsyncParallelJob::_chains_lock"));
+AsyncParallelJob::ChainUsers *AsyncParallelJob::_chain_users = nullptr;
+
+/**
+ *
+ */
+AsyncParallelJob::
+AsyncParallelJob(const std::string &chain_name, ThreadPriority priority) :
+  _chain_name(chain_name),
+  _priority(priority)
+{
+}
+
+/**
+ *
+ */
+AsyncParallelJob::
+~AsyncParallelJob() {
+}
+
+/**
+ * Processes items 0 through num_items - 1 by calling do_item() on each, using
+ * up to num_threads threads of the task chain in addition to the calling
+ * thread.  Returns when all of the items have been processed.
+ *
+ * The items may be processed in any order, and the worker threads see the
+ * same pipeline stage as the calling thread.
+ */
+void AsyncParallelJob::
+run(int num_items, int num_threads) {
+  if (num_items <= 0) {
+    return;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+
+  int num_tasks = std::min(num_threads, num_items - 1);
+  if (num_tasks <= 0 || !Thread::is_threading_supported()) {
+    // Nothing to hand off; just do it all here.
+    for (int i = 0; i < num_items; ++i) {
+      do_item(i, current_thread);
+    }
+    return;
+  }
+
+  PT(State) state =
+    new State(this, num_items, current_thread->get_pipeline_stage(), false);
+  queue_tasks(state, num_tasks, num_threads);
+
+  state->do_items(current_thread);
+
+  // All of the items have now been claimed.  Wait for the tasks that are
+  // still working on one; any task that hasn't started yet will find nothing
+  // to do, so we don't wait for it.
+  {
+    MutexHolder holder(state->_lock);
+    state->_finished = true;
+    while (state->_num_running > 0) {
+      state->_cvar.wait();
+    }
+  }
+
+  release_chain();
+}
+
+/**
+ * Like run(), but leaves all of the items to the threads of the task chain,
+ * and returns right away.  At least one thread is used, even if num_threads
+ * is 0.  When all of the items have been processed, finished() is called
+ * from the thread that processed the last one.
+ *
+ * If threading is not available, the items are processed, and finished() is
+ * called, before this returns.
+ */
+void AsyncParallelJob::
+start(int num_items, int num_threads) {
+  Thread *current_thread = Thread::get_current_thread();
+
+  if (num_items <= 0 || !Thread::is_threading_supported()) {
+    for (int i = 0; i < num_items; ++i) {
+      do_item(i, current_thread);
+    }
+    finished(current_thread);
+    return;
+  }
+
+  num_threads = std::max(num_threads, 1);
+  PT(State) state =
+    new State(this, num_items, current_thread->get_pipeline_stage(), true);
+  queue_tasks(state, std::min(num_threads, num_items), num_threads);
+}
+
+/**
+ * Called by start() when all of the items have been processed.  The job may
+ * delete itself here.
+ */
+void AsyncParallelJob::
+finished(Thread *) {
+}
+
+/**
+ * The task function that runs in each of the chain's threads.
+ */
+AsyncTask::DoneStatus AsyncParallelJob::
+st_do_items(GenericAsyncTask *, void *user_data) {
+  State *state = (State *)user_data;
+  {
+    MutexHolder holder(state->_lock);
+    if (state->_finished) {
+      // Too late; run() has already returned, or is about to.
+      return AsyncTask::DS_done;
+    }
+    ++state->_num_running;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+  current_thread->set_pipeline_stage(state->_pipeline_stage);
+  state->do_items(current_thread);
+
+  {
+    MutexHolder holder(state->_lock);
+    --state->_num_running;
+    if (state->_num_running == 0) {
+      state->_cvar.notify_all();
+    }
+  }
+  return AsyncTask::DS_done;
+}
+
+/**
+ * Releases the task's reference to the shared state.
+ */
+void AsyncParallelJob::
+st_upon_death(GenericAsyncTask *, bool, void *user_data) {
+  State *state = (State *)user_data;
+  unref_delete(state);
+}
+
+/**
+ * Adds the indicated number of tasks to the task chain, each of which helps
+ * with the indicated job.
+ */
+void AsyncParallelJob::
+queue_tasks(State *state, int num_tasks, int num_threads) {
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+  AsyncTaskChain *chain = acquire_chain(num_threads);
+
+  for (int i = 0; i < num_tasks; ++i) {
+    PT(GenericAsyncTask) task =
+      new GenericAsyncTask(_chain_name, &st_do_items, state);
+    task->set_upon_death(&st_upon_death);
+    task->set_task_chain(chain->get_name());
+
+    // Each task holds a reference to the state until it is removed from the
+    // manager.
+    state->ref();
+    task_mgr->add(task);
+  }
+}
+
+/**
+ * Returns the task chain, creating it if necessary.  If no other job is
+ * currently using the chain, it is also resized to the indicated number of
+ * threads.  Each call must be balanced by a call to release_chain().
+ */
+AsyncTaskChain *AsyncParallelJob::
+acquire_chain(int num_threads) {
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+
+  MutexHolder holder(_chains_lock);
+  if (_chain_users == nullptr) {
+    _chain_users = new ChainUsers;
+  }
+  int &num_users = (*_chain_users)[_chain_name];
+
+  AsyncTaskChain *chain = task_mgr->find_task_chain(_chain_name);
+  if (chain == nullptr) {
+    chain = task_mgr->make_task_chain(_chain_name);
+    chain->set_thread_priority(_priority);
+  }
+  if (num_users == 0 && chain->get_num_threads() != num_threads) {
+    // Nobody else is using the chain, so it is safe to stop and restart its
+    // threads now, unless we are running in one of them.
+    AsyncTask *task = (AsyncTask *)Thread::get_current_thread()->get_current_task();
+    if (task == nullptr || task->get_task_chain() != _chain_name) {
+      chain->set_num_threads(num_threads);
+    }
+  }
+  ++num_users;
+  return chain;
+}
+
+/**
+ * Indicates that the job no longer needs the task chain returned by
+ * acquire_chain().
+ */
+void AsyncParallelJob::
+release_chain() {
+  MutexHolder holder(_chains_lock);
+  nassertv(_chain_users != nullptr);
+  --(*_chain_users)[_chain_name];
+}
+
+/**
+ *
+ */
+AsyncParallelJob::State::
+State(AsyncParallelJob *job, int num_items, int pipeline_stage, bool async) :
+  _cvar(_lock),
+  _job(job),
+  _num_items(num_items),
+  _pipeline_stage(pipeline_stage),
+  _async(async),
+  _next_item(0),
+  _num_left(num_items),
+  _num_running(0),
+  _finished(false)
+{
+}
+
+/**
+ * Claims and processes items until there are none left.  If the job was
+ * started with start(), the thread that completes the last item also
+ * finishes the job.
+ */
+void AsyncParallelJob::State::
+do_items(Thread *current_thread) {
+  while (true) {
+    int n = (int)AtomicAdjust::add(_next_item, 1) - 1;
+    if (n >= _num_items) {
+      return;
+    }
+    _job->do_item(n, current_thread);
+
+    if (!AtomicAdjust::dec(_num_left) && _async) {
+      // The job may delete itself in finished(), so we must not touch it
+      // again afterwards.
+      AsyncParallelJob *job = _job;
+      _job = nullptr;
+      job->release_chain();
+      job->finished(current_thread);
+      return;
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncParallelJob.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef ASYNCPARALLELJOB_H
+#define ASYNCPARALLELJOB_H
+
+#include "pandabase.h"
+
+#include "genericAsyncTask.h"
+#include "asyncTaskChain.h"
+#include "referenceCount.h"
+#include "atomicAdjust.h"
+#include "pmutex.h"
+#include "conditionVar.h"
+#include "pmap.h"
+
+/**
+ * A set of independent work items, numbered 0 through n - 1, that are
+ * processed by the calling thread together with the threads of a named
+ * AsyncTaskChain.  Subclass this and override do_item(), then call run(),
+ * which returns when every item has been processed.
+ *
+ * The task chain is created the first time it is needed, and is resized to
+ * the requested number of threads whenever no job is using it.  If threading
+ * is not available, or zero threads are requested, run() simply processes all
+ * of the items in the calling thread.
+ *
+ * It is safe to call run() from within do_item(), even on the same chain: the
+ * calling thread always works through the items itself, and never waits for
+ * a task that has not yet started.
+ *
+ * Alternatively, start() hands all of the items to the chain and returns
+ * right away; finished() is then called by whichever thread completes the
+ * last item.  The caller must keep the job alive until then.
+ */
+class EXPCL_PANDA_EVENT AsyncParallelJob {
+public:
+  AsyncParallelJob(const std::string &chain_name,
+                   ThreadPriority priority = TP_normal);
+  virtual ~AsyncParallelJob();
+
+  void run(int num_items, int num_threads);
+  void start(int num_items, int num_threads);
+
+  INLINE const std::string &get_chain_name() const;
+
+protected:
+  virtual void do_item(int n, Thread *current_thread)=0;
+  virtual void finished(Thread *current_thread);
+
+private:
+  // This is the part of the job that is shared with the tasks.  It is
+  // reference-counted, since a task that starts late may outlive run().
+  class State : public ReferenceCount {
+  public:
+    State(AsyncParallelJob *job, int num_items, int pipeline_stage,
+          bool async);
+
+    void do_items(Thread *current_thread);
+
+    Mutex _lock;
+    ConditionVar _cvar;
+    AsyncParallelJob *_job;
+    int _num_items;
+    int _pipeline_stage;
+    bool _async;
+    AtomicAdjust::Integer _next_item;
+    AtomicAdjust::Integer _num_left;
+    int _num_running;
+    bool _finished;
+  };
+
+  static AsyncTask::DoneStatus st_do_items(GenericAsyncTask *task, void *user_data);
+  static void st_upon_death(GenericAsyncTask *task, bool clean_exit, void *user_data);
+
+  void queue_tasks(State *state, int num_tasks, int num_threads);
+  AsyncTaskChain *acquire_chain(int num_threads);
+  void release_chain();
+
+  std::string _chain_name;
+  ThreadPriority _priority;
+
+  // The number of jobs currently running on each chain.  A chain is only
+  // resized while this is zero.
+  typedef pmap<std::string, int> ChainUsers;
+  static Mutex &_chains_lock;
+  static ChainUsers *_chain_users;
+};
+
+#include "asyncParallelJob.I"
+
+#endif
@@ -1,4 +1,5 @@
 #include "asyncFuture.cxx"
+#include "asyncParallelJob.cxx"
 #include "asyncTask.cxx"
 #include "asyncTaskChain.cxx"
 #include "asyncTaskCollection.cxx"
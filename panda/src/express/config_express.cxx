@@ -77,6 +77,14 @@ ConfigVariableBool multifile_always_binary
           "or extracted in either binary or text mode, according to the "
           "set_binary() or set_text() flag on the Filename."));
 
+ConfigVariableBool multifile_mmap
+("multifile-mmap", true,
+ PRC_DESC("When this is true, a Multifile that is opened read-only from a "
+          "file on disk is mapped into memory.  Subfiles that are neither "
+          "compressed nor encrypted are then read directly out of the "
+          "mapping, so that several threads may read from the same "
+          "Multifile at once without contending for its file pointer."));
+
 ConfigVariableBool collect_tcp
 ("collect-tcp", false,
  PRC_DESC("Set this true to enable accumulation of several small consecutive "
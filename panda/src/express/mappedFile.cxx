@@ -0,0 +1,189 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "mappedFile.h"
+#include "config_express.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ *
+ */
+MappedFile::
+MappedFile() :
+  _start(0),
+  _size(0),
+  _data(nullptr),
+  _map_base(nullptr),
+  _map_size(0)
+{
+}
+
+/**
+ *
+ */
+MappedFile::
+~MappedFile() {
+  close();
+}
+
+/**
+ * Maps size bytes of the indicated file on disk into memory, beginning at the
+ * indicated offset within the file.  The offset need not be aligned to any
+ * particular boundary.  Returns true on success, false on failure.
+ */
+bool MappedFile::
+open(const Filename &filename, std::streampos start, size_t size) {
+  close();
+
+  if (size == 0) {
+    return false;
+  }
+
+#ifdef _WIN32
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  uint64_t granularity = sysinfo.dwAllocationGranularity;
+#else
+  uint64_t granularity = (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+
+  uint64_t offset = (uint64_t)start;
+  uint64_t map_offset = offset - (offset % granularity);
+  size_t map_size = (size_t)(offset - map_offset) + size;
+
+#ifdef _WIN32
+  std::wstring os_filename = filename.to_os_specific_w();
+  HANDLE handle = CreateFileW(os_filename.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    express_cat.error()
+      << "Unable to open " << filename << " for mapping.\n";
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(handle);
+  if (mapping == nullptr) {
+    express_cat.error()
+      << "Unable to map " << filename << ", error " << GetLastError() << "\n";
+    return false;
+  }
+
+  void *base = MapViewOfFile(mapping, FILE_MAP_READ,
+                             (DWORD)(map_offset >> 32), (DWORD)map_offset,
+                             map_size);
+  CloseHandle(mapping);
+  if (base == nullptr) {
+    express_cat.error()
+      << "Unable to map " << filename << ", error " << GetLastError() << "\n";
+    return false;
+  }
+
+#else
+  std::string os_filename = filename.to_os_specific();
+  int fd = ::open(os_filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    express_cat.error()
+      << "Unable to open " << filename << " for mapping.\n";
+    return false;
+  }
+
+  // The mapping is private, so that even if the file is changed on disk while
+  // we hold it, we don't write to it ourselves.
+  void *base = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, (off_t)map_offset);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    express_cat.error()
+      << "Unable to map " << filename << ".\n";
+    return false;
+  }
+#endif
+
+  _filename = filename;
+  _start = start;
+  _size = size;
+  _map_base = base;
+  _map_size = map_size;
+  _data = (const unsigned char *)base + (size_t)(offset - map_offset);
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << size << " bytes of " << filename << " at offset "
+      << offset << "\n";
+  }
+  return true;
+}
+
+/**
+ * Makes this object a view of size bytes of an already-open MappedFile,
+ * beginning offset bytes past parent->get_data().  No new mapping is made;
+ * the parent's mapping is shared, and is kept open for as long as this view
+ * is.  Returns true on success, false on failure.
+ */
+bool MappedFile::
+open(const MappedFile *parent, size_t offset, size_t size) {
+  close();
+
+  nassertr(parent != nullptr && parent->is_open(), false);
+  if (size == 0 || offset > parent->_size || size > parent->_size - offset) {
+    return false;
+  }
+
+  _filename = parent->_filename;
+  _start = parent->_start + (std::streamoff)offset;
+  _size = size;
+  _data = parent->_data + offset;
+
+  // Always refer to the object that owns the mapping, so that views of views
+  // don't form a chain.
+  if (parent->_parent != nullptr) {
+    _parent = parent->_parent;
+  } else {
+    _parent = parent;
+  }
+  return true;
+}
+
+/**
+ * Unmaps the file.  Any pointers previously returned by get_data() become
+ * invalid.
+ */
+void MappedFile::
+close() {
+  _parent.clear();
+
+  if (_map_base != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(_map_base);
+#else
+    munmap(_map_base, _map_size);
+#endif
+    _map_base = nullptr;
+  }
+
+  _map_size = 0;
+  _data = nullptr;
+  _size = 0;
+  _start = 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "filename.h"
+#include "subfileInfo.h"
+#include "pointerTo.h"
+
+/**
+ * A read-only view of a range of bytes of a file on disk, mapped directly
+ * into memory by the operating system.  The pages of the file are read in on
+ * demand as they are accessed, and may be shared between processes.
+ *
+ * The mapping remains valid for as long as this object exists, so any object
+ * that holds a pointer into the data should also hold a reference to the
+ * MappedFile.  A MappedFile may also be a view of part of another MappedFile,
+ * in which case it shares the parent's mapping and keeps it alive.  The mapped memory may never be written to; a copy should be
+ * made of any data that needs to be modified.
+ */
+class EXPCL_PANDA_EXPRESS MappedFile : public ReferenceCount {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  bool open(const Filename &filename, std::streampos start, size_t size);
+  INLINE bool open(const SubfileInfo &info);
+  bool open(const MappedFile *parent, size_t offset, size_t size);
+  void close();
+
+  INLINE bool is_open() const;
+  INLINE const Filename &get_filename() const;
+  INLINE std::streampos get_start() const;
+  INLINE size_t get_size() const;
+  INLINE const unsigned char *get_data() const;
+
+private:
+  Filename _filename;
+  std::streampos _start;
+  size_t _size;
+  const unsigned char *_data;
+
+  // The actual mapping begins at the page boundary at or before _start.
+  void *_map_base;
+  size_t _map_size;
+
+  // If this is a view of another MappedFile, this is the owner of the
+  // mapping, and _map_base is NULL.
+  CPT(MappedFile) _parent;
+};
+
+#include "mappedFile.I"
+
+#endif
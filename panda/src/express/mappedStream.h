@@ -0,0 +1,44 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStream.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDSTREAM_H
+#define MAPPEDSTREAM_H
+
+#include "pandabase.h"
+#include "mappedStreamBuf.h"
+
+/**
+ * An istream object that reads a range of bytes directly out of a
+ * MappedFile.  Unlike ISubStream, it does not share a file pointer (or a
+ * lock) with any other stream, so any number of these may be read
+ * concurrently from different threads.  The stream supports arbitrary seeks.
+ */
+class EXPCL_PANDA_EXPRESS IMappedStream : public std::istream {
+public:
+  INLINE IMappedStream();
+  INLINE explicit IMappedStream(const MappedFile *mapping, size_t start, size_t size);
+
+#if _MSC_VER >= 1800
+  INLINE IMappedStream(const IMappedStream &copy) = delete;
+#endif
+
+  INLINE IMappedStream &open(const MappedFile *mapping, size_t start, size_t size);
+  INLINE IMappedStream &close();
+
+private:
+  MappedStreamBuf _buf;
+};
+
+#include "mappedStream.I"
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "mappedStreamBuf.h"
+
+/**
+ *
+ */
+MappedStreamBuf::
+MappedStreamBuf() :
+  _begin(nullptr),
+  _end(nullptr)
+{
+}
+
+/**
+ *
+ */
+MappedStreamBuf::
+~MappedStreamBuf() {
+  close();
+}
+
+/**
+ * Begins reading size bytes of the indicated mapping, starting at the
+ * indicated offset from mapping->get_data().  A reference to the mapping is
+ * held until close() is called.
+ */
+void MappedStreamBuf::
+open(const MappedFile *mapping, size_t start, size_t size) {
+  close();
+  nassertv(mapping != nullptr && mapping->is_open());
+  nassertv(start <= mapping->get_size() && size <= mapping->get_size() - start);
+
+  _mapping = mapping;
+
+  // The streambuf interface wants a non-const pointer, but since we never
+  // set up a put area, the mapped memory is never written to.
+  _begin = (char *)mapping->get_data() + start;
+  _end = _begin + size;
+  setg(_begin, _begin, _end);
+}
+
+/**
+ * Releases the mapping.
+ */
+void MappedStreamBuf::
+close() {
+  setg(nullptr, nullptr, nullptr);
+  _begin = nullptr;
+  _end = nullptr;
+  _mapping.clear();
+}
+
+/**
+ * Implements seeking within the stream.
+ */
+std::streampos MappedStreamBuf::
+seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which) {
+  if ((which & std::ios::in) == 0 || _begin == nullptr) {
+    return -1;
+  }
+
+  std::streamoff size = (std::streamoff)(_end - _begin);
+  std::streamoff pos;
+  switch (dir) {
+  case std::ios::beg:
+    pos = off;
+    break;
+
+  case std::ios::cur:
+    pos = (std::streamoff)(gptr() - _begin) + off;
+    break;
+
+  case std::ios::end:
+    pos = size + off;
+    break;
+
+  default:
+    return -1;
+  }
+
+  if (pos < 0 || pos > size) {
+    return -1;
+  }
+
+  setg(_begin, _begin + (size_t)pos, _end);
+  return pos;
+}
+
+/**
+ * Implements seeking within the stream.  The default implementation of
+ * seekpos() does not necessarily call seekoff(), so we must redefine it.
+ */
+std::streampos MappedStreamBuf::
+seekpos(std::streampos pos, ios_openmode which) {
+  return seekoff(pos, std::ios::beg, which);
+}
+
+/**
+ * Returns the number of characters that remain to be read.
+ */
+std::streamsize MappedStreamBuf::
+showmanyc() {
+  return (std::streamsize)(egptr() - gptr());
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.  Since the entire range is already available, this only
+ * happens at the end of the stream.
+ */
+int MappedStreamBuf::
+underflow() {
+  if (gptr() < egptr()) {
+    return (unsigned char)*gptr();
+  }
+  return EOF;
+}
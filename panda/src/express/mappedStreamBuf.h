@@ -0,0 +1,48 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedStreamBuf.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef MAPPEDSTREAMBUF_H
+#define MAPPEDSTREAMBUF_H
+
+#include "pandabase.h"
+#include "mappedFile.h"
+#include "pointerTo.h"
+
+/**
+ * The streambuf object that implements IMappedStream.  The get area is set
+ * directly to the mapped memory, so no data is ever copied into an
+ * intermediate buffer, and no lock is needed to read it.
+ */
+class EXPCL_PANDA_EXPRESS MappedStreamBuf : public std::streambuf {
+public:
+  MappedStreamBuf();
+  MappedStreamBuf(const MappedStreamBuf &copy) = delete;
+  virtual ~MappedStreamBuf();
+
+  void open(const MappedFile *mapping, size_t start, size_t size);
+  void close();
+
+protected:
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+  virtual std::streamsize showmanyc();
+  virtual int underflow();
+
+private:
+  CPT(MappedFile) _mapping;
+  char *_begin;
+  char *_end;
+};
+
+#endif
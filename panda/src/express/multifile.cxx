@@ -21,6 +21,7 @@
 #include "encryptStream.h"
 #include "virtualFileSystem.h"
 #include "virtualFile.h"
+#include "mappedStream.h"
 
 #include <algorithm>
 #include <iterator>
@@ -115,6 +116,7 @@ Multifile() :
               "be loaded quickly, without paying the cost of an expensive hash on "
               "each subfile in order to decrypt it."));
 
+  _mapping.clear();
   _read = nullptr;
   _write = nullptr;
   _offset = 0;
@@ -179,7 +181,14 @@ open_read(const Filename &multifile_name, const streampos &offset) {
   _owns_stream = true;
   _multifile_name = multifile_name;
   _offset = offset;
-  return read_index();
+  if (!read_index()) {
+    return false;
+  }
+
+  if (multifile_mmap) {
+    map_multifile(vfile);
+  }
+  return true;
 }
 
 /**
@@ -344,6 +353,10 @@ close() {
 
   _read = nullptr;
   _write = nullptr;
+
+  // Any streams still open on a subfile keep their own reference to the
+  // mapping.
+  _mapping.clear();
   _offset = 0;
   _owns_stream = false;
   _next_index = 0;
@@ -1917,6 +1930,7 @@ read_subfile(int index, vector_uchar &result) {
   result.reserve(subfile->_uncompressed_length);
 
   bool success = true;
+  size_t mapped_start;
   if (subfile->_flags & (SF_encrypted | SF_compressed)) {
     // If the subfile is encrypted or compressed, we can't read it directly.
     // Fall back to the generic implementation.
@@ -1928,6 +1942,12 @@ read_subfile(int index, vector_uchar &result) {
     success = VirtualFile::simple_read_file(in, result);
     close_read_subfile(in);
 
+  } else if (find_mapped_subfile(subfile, mapped_start)) {
+    // If the Multifile is mapped, we can copy the data straight out of
+    // memory, without touching the shared istream at all.
+    const unsigned char *data = _mapping->get_data() + mapped_start;
+    result.assign(data, data + subfile->_data_length);
+
   } else {
     // But if the subfile is just a plain file, we can just read the data
     // directly from the Multifile, without paying the cost of an ISubStream.
@@ -1966,6 +1986,35 @@ read_subfile(int index, vector_uchar &result) {
   return true;
 }
 
+/**
+ * Returns a MappedFile that views the data of the indicated subfile directly
+ * within the mapped Multifile, without copying it.  This is only possible
+ * for subfiles that are neither compressed nor encrypted, and only if the
+ * Multifile has been mapped (see is_mapped()); otherwise, returns NULL.
+ *
+ * The returned view shares the mapping of the whole Multifile, and keeps it
+ * open even after the Multifile is closed.
+ */
+PT(MappedFile) Multifile::
+map_subfile(int index) {
+  nassertr(is_read_valid(), nullptr);
+  nassertr(index >= 0 && index < (int)_subfiles.size(), nullptr);
+  Subfile *subfile = _subfiles[index];
+
+  size_t start;
+  if ((subfile->_flags & (SF_encrypted | SF_compressed)) != 0 ||
+      subfile->_source != nullptr || !subfile->_source_filename.empty() ||
+      !find_mapped_subfile(subfile, start)) {
+    return nullptr;
+  }
+
+  PT(MappedFile) view = new MappedFile;
+  if (!view->open(_mapping, start, subfile->_data_length)) {
+    return nullptr;
+  }
+  return view;
+}
+
 /**
  * Assumes the _write pointer is at the indicated fpos, rounds the fpos up to
  * the next legitimate address (using normalize_streampos()), and writes
@@ -2047,12 +2096,22 @@ open_read_subfile(Subfile *subfile) {
   nassertr(subfile->_source == nullptr &&
            subfile->_source_filename.empty(), nullptr);
 
-  // Return an ISubStream object that references into the open Multifile
-  // istream.
   nassertr(subfile->_data_start != (streampos)0, nullptr);
-  istream *stream =
-    new ISubStream(_read, _offset + subfile->_data_start,
-                   _offset + subfile->_data_start + (streampos)subfile->_data_length);
+  istream *stream;
+  size_t start;
+  if (find_mapped_subfile(subfile, start)) {
+    // The Multifile is mapped into memory, so we can read the subfile
+    // directly out of the mapping.  This stream doesn't share the file
+    // pointer of the Multifile istream, so it needn't lock it.
+    stream = new IMappedStream(_mapping, start, subfile->_data_length);
+
+  } else {
+    // Return an ISubStream object that references into the open Multifile
+    // istream.
+    stream =
+      new ISubStream(_read, _offset + subfile->_data_start,
+                     _offset + subfile->_data_start + (streampos)subfile->_data_length);
+  }
 
   if ((subfile->_flags & SF_encrypted) != 0) {
 #ifndef HAVE_OPENSSL
@@ -2100,6 +2159,52 @@ open_read_subfile(Subfile *subfile) {
   return stream;
 }
 
+/**
+ * If the Multifile is mapped into memory, and the data of the indicated
+ * subfile lies entirely within the mapping, fills in start with the offset of
+ * the data from the beginning of the mapping and returns true.  Otherwise,
+ * returns false.
+ */
+bool Multifile::
+find_mapped_subfile(const Subfile *subfile, size_t &start) const {
+  if (_mapping == nullptr || subfile->_data_length == 0) {
+    return false;
+  }
+
+  uint64_t offset = (uint64_t)(_offset + subfile->_data_start);
+  uint64_t mapped_size = _mapping->get_size();
+  if (offset > mapped_size || subfile->_data_length > mapped_size - offset) {
+    return false;
+  }
+
+  start = (size_t)offset;
+  return true;
+}
+
+/**
+ * Maps the Multifile file on disk into memory, if possible, so that subfiles
+ * may be read without going through the shared istream.  Called by
+ * open_read() after the index has been read.
+ */
+void Multifile::
+map_multifile(VirtualFile *vfile) {
+  SubfileInfo info;
+  if (!vfile->get_system_info(info)) {
+    return;
+  }
+
+  PT(MappedFile) mapping = new MappedFile;
+  if (!mapping->open(info)) {
+    return;
+  }
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped multifile " << _multifile_name << "\n";
+  }
+  _mapping = mapping;
+}
+
 /**
  * Returns the standard form of the subfile name.
  */
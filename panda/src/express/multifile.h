@@ -19,6 +19,7 @@
 #include "config_express.h"
 #include "streamWrapper.h"
 #include "subStream.h"
+#include "mappedFile.h"
 #include "filename.h"
 #include "ordered_vector.h"
 #include "indirectLess.h"
@@ -26,6 +27,8 @@
 #include "pvector.h"
 #include "vector_uchar.h"
 
+class VirtualFile;
+
 #ifdef HAVE_OPENSSL
 typedef struct x509_st X509;
 typedef struct evp_pkey_st EVP_PKEY;
@@ -56,6 +59,7 @@ PUBLISHED:
 
   INLINE bool is_read_valid() const;
   INLINE bool is_write_valid() const;
+  INLINE bool is_mapped() const;
   INLINE bool needs_repack() const;
 
   INLINE time_t get_timestamp() const;
@@ -162,6 +166,8 @@ public:
   bool read_subfile(int index, std::string &result);
   bool read_subfile(int index, vector_uchar &result);
 
+  PT(MappedFile) map_subfile(int index);
+
 private:
   enum SubfileFlags {
     SF_deleted        = 0x0001,
@@ -214,6 +220,8 @@ private:
 
   void add_new_subfile(Subfile *subfile, int compression_level);
   std::istream *open_read_subfile(Subfile *subfile);
+  bool find_mapped_subfile(const Subfile *subfile, size_t &start) const;
+  void map_multifile(VirtualFile *vfile);
   std::string standardize_subfile_name(const std::string &subfile_name) const;
 
   void clear_subfiles();
@@ -238,6 +246,10 @@ private:
 
   std::streampos _offset;
   IStreamWrapper *_read;
+
+  // If the Multifile was opened read-only from a file on disk, this maps the
+  // whole file into memory.  All subfile reads share this one mapping.
+  PT(MappedFile) _mapping;
   std::ostream *_write;
   bool _owns_stream;
   std::streampos _next_index;
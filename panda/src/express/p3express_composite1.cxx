@@ -13,6 +13,9 @@
 #include "fileReference.cxx"
 #include "hashGeneratorBase.cxx"
 #include "hashVal.cxx"
+#include "mappedFile.cxx"
+#include "mappedStream.cxx"
+#include "mappedStreamBuf.cxx"
 #include "memoryInfo.cxx"
 #include "memoryUsage.cxx"
 #include "memoryUsagePointerCounts.cxx"
@@ -330,6 +330,25 @@ get_system_info(SubfileInfo &info) {
   return false;
 }
 
+/**
+ * Maps the contents of the file into memory, if it resides directly on disk
+ * (see get_system_info()), and returns the mapping.  Returns NULL if the file
+ * cannot be mapped, in which case it must be read normally instead.
+ */
+PT(MappedFile) VirtualFile::
+map_file() {
+  SubfileInfo info;
+  if (!get_system_info(info)) {
+    return nullptr;
+  }
+
+  PT(MappedFile) mapping = new MappedFile;
+  if (!mapping->open(info)) {
+    return nullptr;
+  }
+  return mapping;
+}
+
 /**
  * See Filename::atomic_compare_and_exchange_contents().
  */
@@ -18,6 +18,7 @@
 
 #include "filename.h"
 #include "subfileInfo.h"
+#include "mappedFile.h"
 #include "pointerTo.h"
 #include "typedReferenceCount.h"
 #include "ordered_vector.h"
@@ -88,6 +89,8 @@ public:
   virtual bool read_file(vector_uchar &result, bool auto_unwrap) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
+  virtual PT(MappedFile) map_file();
+
   static bool simple_read_file(std::istream *stream, vector_uchar &result);
   static bool simple_read_file(std::istream *stream, vector_uchar &result, size_t max_bytes);
 
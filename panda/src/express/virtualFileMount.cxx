@@ -310,6 +310,26 @@ get_system_info(const Filename &file, SubfileInfo &info) {
   return false;
 }
 
+/**
+ * Maps the contents of the indicated file into memory, if it resides
+ * directly on disk, and returns the mapping.  Returns NULL if the file cannot
+ * be mapped.  The default implementation maps the range returned by
+ * get_system_info().
+ */
+PT(MappedFile) VirtualFileMount::
+map_file(const Filename &file) {
+  SubfileInfo info;
+  if (!get_system_info(file, info)) {
+    return nullptr;
+  }
+
+  PT(MappedFile) mapping = new MappedFile;
+  if (!mapping->open(info)) {
+    return nullptr;
+  }
+  return mapping;
+}
+
 /**
  * See Filename::atomic_compare_and_exchange_contents().
  */
@@ -174,6 +174,24 @@ get_system_info(const Filename &file, SubfileInfo &info) {
   return true;
 }
 
+/**
+ * Maps the indicated subfile into memory.  If the Multifile is already
+ * mapped, this returns a view into the existing mapping, so that all of the
+ * subfiles share a single mapping of the archive.
+ */
+PT(MappedFile) VirtualFileMountMultifile::
+map_file(const Filename &file) {
+  if (_multifile->is_mapped()) {
+    int subfile_index = _multifile->find_subfile(file);
+    if (subfile_index < 0) {
+      return nullptr;
+    }
+    return _multifile->map_subfile(subfile_index);
+  }
+
+  return VirtualFileMount::map_file(file);
+}
+
 /**
  * Fills the given vector up with the list of filenames that are local to this
  * directory, if the filename is a directory.  Returns true if successful, or
@@ -43,6 +43,7 @@ public:
   virtual std::streamsize get_file_size(const Filename &file) const;
   virtual time_t get_timestamp(const Filename &file) const;
   virtual bool get_system_info(const Filename &file, SubfileInfo &info);
+  virtual PT(MappedFile) map_file(const Filename &file);
 
   virtual bool scan_directory(vector_string &contents,
                               const Filename &dir) const;
@@ -354,6 +354,18 @@ get_system_info(SubfileInfo &info) {
   return _mount->get_system_info(_local_filename, info);
 }
 
+/**
+ * See VirtualFile::map_file().
+ */
+PT(MappedFile) VirtualFileSimple::
+map_file() {
+  if (_implicit_pz_file) {
+    // The contents on disk are compressed.
+    return nullptr;
+  }
+  return _mount->map_file(_local_filename);
+}
+
 /**
  * See Filename::atomic_compare_and_exchange_contents().
  */
@@ -66,6 +66,8 @@ public:
   virtual bool read_file(vector_uchar &result, bool auto_unwrap) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
+  virtual PT(MappedFile) map_file();
+
 protected:
   virtual bool scan_local_directory(VirtualFileList *file_list,
                                     const ov_set<std::string> &mount_points) const;
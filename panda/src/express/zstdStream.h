@@ -0,0 +1,98 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStream.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef ZSTDSTREAM_H
+#define ZSTDSTREAM_H
+
+#include "pandabase.h"
+
+// This module is not compiled if Zstandard is not available.
+#ifdef HAVE_ZSTD
+
+#include "zstdStreamBuf.h"
+
+/**
+ * An input stream object that uses Zstandard to decompress the input from
+ * another source stream on-the-fly.  This is the Zstandard counterpart of
+ * IDecompressStream; it decompresses several times faster than zlib, at a
+ * similar ratio.
+ *
+ * Seeking is not supported, except back to the beginning of the stream.
+ */
+class EXPCL_PANDA_EXPRESS IZstdDecompressStream : public std::istream {
+PUBLISHED:
+  INLINE IZstdDecompressStream();
+  INLINE explicit IZstdDecompressStream(std::istream *source, bool owns_source,
+                                        std::streamsize source_length = -1);
+
+#if _MSC_VER >= 1800
+  INLINE IZstdDecompressStream(const IZstdDecompressStream &copy) = delete;
+#endif
+
+  INLINE IZstdDecompressStream &open(std::istream *source, bool owns_source,
+                                     std::streamsize source_length = -1);
+  INLINE IZstdDecompressStream &close();
+
+public:
+  INLINE explicit IZstdDecompressStream(std::istream *source, bool owns_source,
+                                        std::streamsize source_length,
+                                        const ZstdDictionary *dictionary);
+  INLINE IZstdDecompressStream &open(std::istream *source, bool owns_source,
+                                     std::streamsize source_length,
+                                     const ZstdDictionary *dictionary);
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+/**
+ * An output stream object that uses Zstandard to compress data to another
+ * destination stream on-the-fly.  This is the Zstandard counterpart of
+ * OCompressStream.
+ *
+ * Seeking is not supported.
+ */
+class EXPCL_PANDA_EXPRESS OZstdCompressStream : public std::ostream {
+PUBLISHED:
+  INLINE OZstdCompressStream();
+  INLINE explicit OZstdCompressStream(std::ostream *dest, bool owns_dest,
+                                      int compression_level = 6);
+
+#if _MSC_VER >= 1800
+  INLINE OZstdCompressStream(const OZstdCompressStream &copy) = delete;
+#endif
+
+  INLINE OZstdCompressStream &open(std::ostream *dest, bool owns_dest,
+                                   int compression_level = 6);
+  INLINE OZstdCompressStream &close();
+
+public:
+  INLINE explicit OZstdCompressStream(std::ostream *dest, bool owns_dest,
+                                      int compression_level,
+                                      const ZstdDictionary *dictionary,
+                                      int num_threads = 0);
+  INLINE OZstdCompressStream &open(std::ostream *dest, bool owns_dest,
+                                   int compression_level,
+                                   const ZstdDictionary *dictionary,
+                                   int num_threads = 0);
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+#include "zstdStream.I"
+
+#endif  // HAVE_ZSTD
+
+
+#endif
@@ -0,0 +1,491 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "zstdStreamBuf.h"
+
+#ifdef HAVE_ZSTD
+
+#include "pnotify.h"
+#include "config_express.h"
+
+#include <zdict.h>
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+
+// The size of the get and put areas of the streambuf.  This is larger than
+// the one used by ZStreamBuf, since Zstandard is fast enough that the
+// per-call overhead would otherwise show up.
+static const size_t zstd_buffer_size = 16384;
+
+/**
+ * Makes a copy of the indicated dictionary data, and digests it for
+ * decompression.
+ */
+ZstdDictionary::
+ZstdDictionary(const vector_uchar &data) : _data(data) {
+  _ddict = ZSTD_createDDict(_data.data(), _data.size());
+  if (_ddict == nullptr) {
+    express_cat.warning()
+      << "Invalid Zstandard dictionary of " << _data.size() << " bytes.\n";
+  }
+}
+
+/**
+ *
+ */
+ZstdDictionary::
+~ZstdDictionary() {
+  if (_ddict != nullptr) {
+    ZSTD_freeDDict(_ddict);
+  }
+}
+
+/**
+ * Trains a new dictionary of up to max_size bytes from the indicated samples,
+ * which are concatenated in the samples buffer; sample_sizes lists the length
+ * of each one.  Returns the dictionary data, or an empty vector if there are
+ * too few samples to train a useful dictionary.
+ */
+vector_uchar ZstdDictionary::
+train(const vector_uchar &samples, const pvector<size_t> &sample_sizes,
+      size_t max_size) {
+  vector_uchar result;
+  if (sample_sizes.empty() || max_size == 0) {
+    return result;
+  }
+
+  result.resize(max_size);
+  size_t dict_size =
+    ZDICT_trainFromBuffer(result.data(), max_size, samples.data(),
+                          sample_sizes.data(), (unsigned)sample_sizes.size());
+  if (ZDICT_isError(dict_size)) {
+    express_cat.info()
+      << "Unable to train Zstandard dictionary from " << sample_sizes.size()
+      << " samples: " << ZDICT_getErrorName(dict_size) << "\n";
+    result.clear();
+    return result;
+  }
+
+  result.resize(dict_size);
+  return result;
+}
+
+/**
+ *
+ */
+ZstdStreamBuf::
+ZstdStreamBuf() {
+  _source = nullptr;
+  _source_bytes_left = -1;
+  _owns_source = false;
+  _source_eof = false;
+  _dest = nullptr;
+  _owns_dest = false;
+  _dctx = nullptr;
+  _cctx = nullptr;
+  _total_out = 0;
+
+  _in_buffer_size = ZSTD_DStreamInSize();
+  _in_buffer = (char *)PANDA_MALLOC_ARRAY(_in_buffer_size);
+  _in.src = _in_buffer;
+  _in.size = 0;
+  _in.pos = 0;
+
+  _buffer = (char *)PANDA_MALLOC_ARRAY(zstd_buffer_size);
+  char *ebuf = _buffer + zstd_buffer_size;
+  setg(_buffer, ebuf, ebuf);
+  setp(_buffer, ebuf);
+}
+
+/**
+ *
+ */
+ZstdStreamBuf::
+~ZstdStreamBuf() {
+  close_read();
+  close_write();
+  PANDA_FREE_ARRAY(_buffer);
+  PANDA_FREE_ARRAY(_in_buffer);
+}
+
+/**
+ * Prepares to decompress the data read from the indicated source stream.  If
+ * source_length is not -1, no more than that many bytes are read from the
+ * source.  The dictionary, if any, must be the one the data was compressed
+ * with.
+ */
+void ZstdStreamBuf::
+open_read(std::istream *source, bool owns_source, std::streamsize source_length,
+          const ZstdDictionary *dictionary) {
+  _source = source;
+  _source_bytes_left = source_length;
+  _owns_source = owns_source;
+  _source_eof = false;
+  _total_out = 0;
+  _in.size = 0;
+  _in.pos = 0;
+
+  _dctx = ZSTD_createDCtx();
+  if (_dctx == nullptr) {
+    express_cat.warning()
+      << "Unable to create Zstandard decompression context.\n";
+    close_read();
+    return;
+  }
+
+  _dictionary = (ZstdDictionary *)dictionary;
+  if (dictionary != nullptr && dictionary->get_ddict() != nullptr) {
+    if (check_zstd_error("ZSTD_DCtx_refDDict",
+                         ZSTD_DCtx_refDDict(_dctx, dictionary->get_ddict()))) {
+      close_read();
+    }
+  }
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_read() {
+  _source_bytes_left = 0;
+
+  if (_source != nullptr) {
+    if (_dctx != nullptr) {
+      ZSTD_freeDCtx(_dctx);
+      _dctx = nullptr;
+    }
+    _dictionary.clear();
+    thread_consider_yield();
+
+    if (_owns_source) {
+      delete _source;
+      _owns_source = false;
+    }
+    _source = nullptr;
+  }
+}
+
+/**
+ * Prepares to compress data to the indicated dest stream.  If num_threads is
+ * greater than zero, and the Zstandard library was built with multithreading
+ * support, the compression of large streams is split across that many
+ * threads of Zstandard's own.
+ */
+void ZstdStreamBuf::
+open_write(std::ostream *dest, bool owns_dest, int compression_level,
+           const ZstdDictionary *dictionary, int num_threads) {
+  _dest = dest;
+  _owns_dest = owns_dest;
+
+  _cctx = ZSTD_createCCtx();
+  if (_cctx == nullptr) {
+    express_cat.warning()
+      << "Unable to create Zstandard compression context.\n";
+    close_write();
+    return;
+  }
+
+  if (check_zstd_error("ZSTD_CCtx_setParameter",
+        ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, compression_level)) ||
+      check_zstd_error("ZSTD_CCtx_setParameter",
+        ZSTD_CCtx_setParameter(_cctx, ZSTD_c_checksumFlag, 1))) {
+    close_write();
+    return;
+  }
+
+  if (num_threads > 0) {
+    size_t result = ZSTD_CCtx_setParameter(_cctx, ZSTD_c_nbWorkers, num_threads);
+    if (ZSTD_isError(result) && express_cat.is_debug()) {
+      // This library wasn't built with ZSTD_MULTITHREAD.  We just compress on
+      // this thread instead.
+      express_cat.debug()
+        << "Zstandard cannot compress with " << num_threads << " threads: "
+        << ZSTD_getErrorName(result) << "\n";
+    }
+  }
+
+  if (dictionary != nullptr && !dictionary->get_data().empty()) {
+    const vector_uchar &data = dictionary->get_data();
+    if (check_zstd_error("ZSTD_CCtx_loadDictionary",
+                         ZSTD_CCtx_loadDictionary(_cctx, data.data(), data.size()))) {
+      close_write();
+      return;
+    }
+  }
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_write() {
+  if (_dest != nullptr) {
+    if (_cctx != nullptr) {
+      size_t n = pptr() - pbase();
+      write_chars(pbase(), n, ZSTD_e_end);
+      pbump(-(int)n);
+
+      ZSTD_freeCCtx(_cctx);
+      _cctx = nullptr;
+    }
+    thread_consider_yield();
+
+    if (_owns_dest) {
+      delete _dest;
+      _owns_dest = false;
+    }
+    _dest = nullptr;
+  }
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if (which != ios::in || _dctx == nullptr) {
+    // We can only do this with the input stream.
+    return -1;
+  }
+
+  // Determine the current position.
+  size_t n = egptr() - gptr();
+  streampos gpos = _total_out - n;
+
+  // Implement tellg() and seeks to current position.
+  if ((dir == ios::cur && off == 0) ||
+      (dir == ios::beg && off == gpos)) {
+    return gpos;
+  }
+
+  if (off != 0 || dir != ios::beg) {
+    // We only know how to reposition to the beginning.
+    return -1;
+  }
+
+  gbump(n);
+
+  if (_source->rdbuf()->pubseekpos(0, ios::in) == (streampos)0) {
+    _source->clear();
+    _source_eof = false;
+    _total_out = 0;
+    _in.size = 0;
+    _in.pos = 0;
+
+    // This keeps the dictionary that was referenced.
+    ZSTD_DCtx_reset(_dctx, ZSTD_reset_session_only);
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Called by the system ostream implementation when its internal buffer is
+ * filled, plus one character.
+ */
+int ZstdStreamBuf::
+overflow(int ch) {
+  size_t n = pptr() - pbase();
+  if (n != 0) {
+    write_chars(pbase(), n, ZSTD_e_continue);
+    pbump(-(int)n);
+  }
+
+  if (ch != EOF) {
+    // Write one more character.
+    char c = ch;
+    write_chars(&c, 1, ZSTD_e_continue);
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system iostream implementation to implement a flush
+ * operation.
+ */
+int ZstdStreamBuf::
+sync() {
+  if (_source != nullptr) {
+    size_t n = egptr() - gptr();
+    gbump(n);
+  }
+
+  if (_dest != nullptr) {
+    size_t n = pptr() - pbase();
+    write_chars(pbase(), n, ZSTD_e_flush);
+    pbump(-(int)n);
+    _dest->flush();
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.
+ */
+int ZstdStreamBuf::
+underflow() {
+  // Sometimes underflow() is called even if the buffer is not empty.
+  if (gptr() >= egptr()) {
+    size_t buffer_size = egptr() - eback();
+    gbump(-(int)buffer_size);
+
+    size_t num_bytes = buffer_size;
+    size_t read_count = read_chars(gptr(), buffer_size);
+
+    if (read_count != num_bytes) {
+      // Oops, we didn't read what we thought we would.
+      if (read_count == 0) {
+        gbump(num_bytes);
+        return EOF;
+      }
+
+      // Slide what we did read to the top of the buffer.
+      nassertr(read_count < num_bytes, EOF);
+      size_t delta = num_bytes - read_count;
+      memmove(gptr() + delta, gptr(), read_count);
+      gbump(delta);
+    }
+  }
+
+  return (unsigned char)*gptr();
+}
+
+/**
+ * Gets some characters from the source stream.
+ */
+size_t ZstdStreamBuf::
+read_chars(char *start, size_t length) {
+  if (_dctx == nullptr) {
+    return 0;
+  }
+
+  ZSTD_outBuffer out;
+  out.dst = start;
+  out.size = length;
+  out.pos = 0;
+
+  while (out.pos < out.size) {
+    if (_in.pos >= _in.size && !_source_eof) {
+      size_t read_count = 0;
+      if (_source_bytes_left >= 0) {
+        // Don't read more than the specified limit.
+        _source->read(_in_buffer,
+          std::min(_source_bytes_left, (std::streamsize)_in_buffer_size));
+        read_count = _source->gcount();
+        _source_bytes_left -= read_count;
+      } else {
+        _source->read(_in_buffer, _in_buffer_size);
+        read_count = _source->gcount();
+      }
+      _source_eof = (read_count == 0);
+      _in.size = read_count;
+      _in.pos = 0;
+    }
+
+    // Once the input runs out, keep calling the decompressor for as long as
+    // it is still producing output from what it has buffered internally.
+    size_t prev_pos = out.pos;
+    size_t result = ZSTD_decompressStream(_dctx, &out, &_in);
+    thread_consider_yield();
+    if (check_zstd_error("ZSTD_decompressStream", result)) {
+      break;
+    }
+    if (_source_eof && _in.pos >= _in.size && out.pos == prev_pos) {
+      // Here's the end of the file.
+      if (result != 0) {
+        express_cat.warning()
+          << "Zstandard stream is truncated.\n";
+      }
+      break;
+    }
+  }
+
+  _total_out += out.pos;
+  return out.pos;
+}
+
+/**
+ * Sends some characters to the dest stream.  The mode is passed to
+ * ZSTD_compressStream2().
+ */
+void ZstdStreamBuf::
+write_chars(const char *start, size_t length, ZSTD_EndDirective mode) {
+  if (_cctx == nullptr) {
+    return;
+  }
+
+  static const size_t compress_buffer_size = 16384;
+  char compress_buffer[compress_buffer_size];
+
+  ZSTD_inBuffer in;
+  in.src = start;
+  in.size = length;
+  in.pos = 0;
+
+  bool finished;
+  do {
+    ZSTD_outBuffer out;
+    out.dst = compress_buffer;
+    out.size = compress_buffer_size;
+    out.pos = 0;
+
+    size_t remaining = ZSTD_compressStream2(_cctx, &out, &in, mode);
+    thread_consider_yield();
+    if (check_zstd_error("ZSTD_compressStream2", remaining)) {
+      return;
+    }
+    _dest->write(compress_buffer, out.pos);
+
+    if (mode == ZSTD_e_continue) {
+      finished = (in.pos == in.size);
+    } else {
+      finished = (remaining == 0);
+    }
+  } while (!finished);
+}
+
+/**
+ * Reports the indicated return code from Zstandard, if it is an error code.
+ * Returns true if it was an error, false otherwise.
+ */
+bool ZstdStreamBuf::
+check_zstd_error(const char *function, size_t code) {
+  if (!ZSTD_isError(code)) {
+    return false;
+  }
+
+  express_cat.warning()
+    << "Zstandard error in " << function << ": "
+    << ZSTD_getErrorName(code) << "\n";
+  return true;
+}
+
+#endif  // HAVE_ZSTD
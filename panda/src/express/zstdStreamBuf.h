@@ -0,0 +1,116 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef ZSTDSTREAMBUF_H
+#define ZSTDSTREAMBUF_H
+
+#include "pandabase.h"
+
+// This module is not compiled if Zstandard is not available.
+#ifdef HAVE_ZSTD
+
+#include "referenceCount.h"
+#include "vector_uchar.h"
+
+#include <zstd.h>
+
+/**
+ * A Zstandard dictionary, which may be shared by any number of compression
+ * and decompression streams.  A dictionary trained on a set of similar small
+ * files greatly improves both the ratio and the speed with which each of them
+ * is compressed individually.
+ *
+ * The dictionary is digested for decompression once, when it is created.
+ */
+class EXPCL_PANDA_EXPRESS ZstdDictionary : public ReferenceCount {
+public:
+  explicit ZstdDictionary(const vector_uchar &data);
+  ~ZstdDictionary();
+
+  INLINE const vector_uchar &get_data() const;
+  INLINE unsigned int get_id() const;
+  INLINE ZSTD_DDict *get_ddict() const;
+
+  static vector_uchar train(const vector_uchar &samples,
+                            const pvector<size_t> &sample_sizes,
+                            size_t max_size);
+
+private:
+  vector_uchar _data;
+  ZSTD_DDict *_ddict;
+};
+
+/**
+ * The streambuf object that implements IZstdDecompressStream and
+ * OZstdCompressStream.
+ */
+class EXPCL_PANDA_EXPRESS ZstdStreamBuf : public std::streambuf {
+public:
+  ZstdStreamBuf();
+  virtual ~ZstdStreamBuf();
+
+  void open_read(std::istream *source, bool owns_source,
+                 std::streamsize source_length = -1,
+                 const ZstdDictionary *dictionary = nullptr);
+  void close_read();
+
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level,
+                  const ZstdDictionary *dictionary = nullptr,
+                  int num_threads = 0);
+  void close_write();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+protected:
+  virtual int overflow(int c);
+  virtual int sync();
+  virtual int underflow();
+
+private:
+  size_t read_chars(char *start, size_t length);
+  void write_chars(const char *start, size_t length, ZSTD_EndDirective mode);
+  static bool check_zstd_error(const char *function, size_t code);
+
+private:
+  std::istream *_source;
+  std::streamsize _source_bytes_left;
+  bool _owns_source;
+  bool _source_eof;
+
+  std::ostream *_dest;
+  bool _owns_dest;
+
+  ZSTD_DCtx *_dctx;
+  ZSTD_CCtx *_cctx;
+  PT(ZstdDictionary) _dictionary;
+
+  // The number of bytes returned by the decompressor so far, which is the
+  // current read position within the uncompressed stream.
+  size_t _total_out;
+
+  char *_buffer;
+
+  // Zstandard may not consume all of the input at each call, so the
+  // compressed input is held here between calls to read_chars().  It is
+  // sized as recommended by ZSTD_DStreamInSize().
+  char *_in_buffer;
+  size_t _in_buffer_size;
+  ZSTD_inBuffer _in;
+};
+
+#include "zstdStreamBuf.I"
+
+#endif  // HAVE_ZSTD
+
+#endif
@@ -30,6 +30,8 @@
 #include "sceneGraphAnalyzer.h"
 #include "transformState.h"
 #include "renderState.h"
+#include "partBundle.h"
+#include "config_chan.h"
 
 #ifdef LINK_ALL_STATIC
 #ifdef HAVE_EGG
@@ -132,6 +134,12 @@ open_framework() {
     _task_mgr.add(task);
   }
 
+  if (anim_update_num_threads > 0) {
+    PT(GenericAsyncTask) task = new GenericAsyncTask("updatePartBundles", task_update_part_bundles, this);
+    task->set_sort(40);
+    _task_mgr.add(task);
+  }
+
   if (garbage_collect_states) {
     PT(GenericAsyncTask) task = new GenericAsyncTask("garbageCollectStates", task_garbage_collect, this);
     task->set_sort(46);
@@ -1457,6 +1465,17 @@ task_clear_text(GenericAsyncTask *task, void *data) {
   return AsyncTask::DS_cont;
 }
 
+/**
+ * This task is created automatically if anim-update-num-threads is nonzero.
+ * It updates all of the animated characters in parallel before the frame is
+ * rendered.
+ */
+AsyncTask::DoneStatus PandaFramework::
+task_update_part_bundles(GenericAsyncTask *task, void *data) {
+  PartBundle::update_all();
+  return AsyncTask::DS_cont;
+}
+
 /**
  * This task is created automatically if garbage_collect_states is true.  It
  * calls the needed TransformState::garbage_collect() and
@@ -133,6 +133,24 @@ ConfigVariableBool driver_compress_textures
           "and will always be handed to the graphics driver, regardless "
           "of this setting."));
 
+ConfigVariableInt texture_compress_num_threads
+("texture-compress-num-threads", 0,
+ PRC_DESC("Set this to a positive number to split the in-memory compression "
+          "of texture images into rows of blocks of each mipmap level, which "
+          "are compressed on this many worker threads in addition to the "
+          "thread requesting the compression.  Set this to 0 to compress "
+          "each image on the requesting thread alone.  "
+          "Texture::async_compress_ram_image() always uses at least one "
+          "worker thread."));
+
+ConfigVariableInt texture_mipmap_num_threads
+("texture-mipmap-num-threads", 0,
+ PRC_DESC("Set this to a positive number to split the generation of large "
+          "mipmap levels in RAM into chunks of rows, which are filtered on "
+          "this many worker threads in addition to the thread generating "
+          "the mipmaps.  Set this to 0 to generate all mipmap levels on the "
+          "calling thread."));
+
 ConfigVariableBool driver_generate_mipmaps
 ("driver-generate-mipmaps", true,
  PRC_DESC("Set this true to use the hardware to generate mipmaps "
@@ -188,6 +206,30 @@ ConfigVariableBool hardware_animated_vertices
           "necessary on your computer's bus.  However, in some cases it "
           "may actually reduce performance."));
 
+ConfigVariableInt animate_vertices_num_threads
+("animate-vertices-num-threads", 0,
+ PRC_DESC("Set this to a positive number to allow the software skinning of "
+          "large vertex tables to be split up among this many worker "
+          "threads, in addition to the thread that requested the animated "
+          "vertices.  Set this to 0 to perform all of the skinning on the "
+          "requesting thread."));
+
+ConfigVariableInt animate_vertices_parallel_threshold
+("animate-vertices-parallel-threshold", 8192,
+ PRC_DESC("The minimum number of animated vertices in a single vertex table "
+          "before the skinning is split up among the threads specified by "
+          "animate-vertices-num-threads.  Smaller tables are skinned on a "
+          "single thread, since the cost of waking the worker threads "
+          "would outweigh the benefit."));
+
+ConfigVariableBool animate_vertices_simd
+("animate-vertices-simd", true,
+ PRC_DESC("Set this true to use the optimized path for software skinning of "
+          "vertex tables whose animated columns are stored as 32-bit "
+          "floats, which computes each blend matrix only once and uses SIMD "
+          "instructions where they are available.  Set this false to always "
+          "use the general-purpose path, e.g. to compare the two."));
+
 ConfigVariableBool hardware_point_sprites
 ("hardware-point-sprites", true,
  PRC_DESC("Set this true to allow the use of hardware extensions when "
@@ -463,6 +505,14 @@ ConfigVariableInt vertex_data_page_threads
           "is 0, this work will be done in the main thread, which may "
           "introduce occasional random chugs in rendering."));
 
+ConfigVariableBool vertex_data_prefetch
+("vertex-data-prefetch", true,
+ PRC_DESC("When this is true, and vertex-data-page-threads is nonzero, the "
+          "cull traversal asks the paging threads to start expanding any "
+          "evicted vertex data for the Geoms of a visible GeomNode before "
+          "they are drawn, so that the draw thread is less likely to stall "
+          "waiting for a page to be decompressed or read from disk."));
+
 ConfigVariableInt graphics_memory_limit
 ("graphics-memory-limit", -1,
  PRC_DESC("This is a default limit that is imposed on each GSG at "
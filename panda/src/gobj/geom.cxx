@@ -1005,12 +1005,10 @@ get_num_bytes() const {
 }
 
 /**
- * Returns true if all the primitive arrays are currently resident in memory.
- * If this returns false, the data will be brought back into memory shortly;
- * try again later.
- *
- * This does not also test the Geom's associated GeomVertexData.  That must be
- * tested separately.
+ * Returns true if all the primitive arrays, as well as the arrays of the
+ * Geom's associated GeomVertexData, are currently resident in memory.  If
+ * this returns false, the data will be brought back into memory shortly; try
+ * again later.
  */
 bool Geom::
 request_resident() const {
@@ -1029,6 +1027,11 @@ request_resident() const {
     }
   }
 
+  if (cdata->_data != nullptr &&
+      !cdata->_data.get_read_pointer(current_thread)->request_resident()) {
+    resident = false;
+  }
+
   return resident;
 }
 
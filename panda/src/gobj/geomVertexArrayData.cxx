@@ -530,18 +530,29 @@ write_datagram(BamWriter *manager, Datagram &dg, void *extra_data) const {
   GeomVertexArrayData *array_data = (GeomVertexArrayData *)extra_data;
   dg.add_uint8(_usage_hint);
 
-  dg.add_uint32(_buffer.get_size());
-
-  if (manager->get_file_endian() == BamWriter::BE_native) {
-    // For native endianness, we only have to write the data directly.
-    dg.append_data(_buffer.get_read_pointer(true), _buffer.get_size());
+  size_t size = _buffer.get_size();
+  dg.add_uint32(size);
+
+  const unsigned char *data = _buffer.get_read_pointer(true);
+  pvector<unsigned char> new_data;
+  if (manager->get_file_endian() != BamWriter::BE_native) {
+    // For non-native endianness, we have to convert the data first.
+    new_data.resize(size);
+    array_data->reverse_data_endianness(new_data.data(), data, size);
+    data = new_data.data();
+  }
 
-  } else {
-    // Otherwise, we have to convert it.
-    unsigned char *new_data = (unsigned char *)alloca(_buffer.get_size());
-    array_data->reverse_data_endianness(new_data, _buffer.get_read_pointer(true), _buffer.get_size());
-    dg.append_data(new_data, _buffer.get_size());
+  if (manager->get_file_minor_ver() >= 46) {
+    // Large arrays may be written to their own page-aligned block, so that
+    // they can be mapped directly into memory when the file is loaded.
+    bool aligned = manager->write_aligned_data(data, size);
+    dg.add_bool(aligned);
+    if (aligned) {
+      return;
+    }
   }
+
+  dg.append_data(data, size);
 }
 
 /**
@@ -564,13 +575,46 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
   } else {
     // Now, the array data is just stored directly.
     size_t size = scan.get_uint32();
-    _buffer.unclean_realloc(size);
-    _buffer.set_size(size);
 
-    const unsigned char *source_data =
-      (const unsigned char *)scan.get_datagram().get_data();
-    memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
-    scan.skip_bytes(size);
+    bool aligned = false;
+    if (manager->get_file_minor_ver() >= 46) {
+      aligned = scan.get_bool();
+    }
+
+    if (aligned) {
+      // It was written as a separate aligned block, which may have been
+      // mapped into memory.  If so, we can reference it in place.
+      CPT(MappedFile) mapping;
+      const unsigned char *source_data;
+      size_t source_size;
+      if (!manager->read_aligned_data(mapping, source_data, source_size) ||
+          source_size != size) {
+        gobj_cat.error()
+          << "Could not read vertex data from bam file.\n";
+        _buffer.clear();
+
+      } else if (mapping != nullptr &&
+                 ((uintptr_t)source_data % MEMORY_HOOK_ALIGNMENT) == 0) {
+        _buffer.set_mapped_data(mapping, source_data, size);
+
+      } else {
+        _buffer.unclean_realloc(size);
+        _buffer.set_size(size);
+        memcpy(_buffer.get_write_pointer(), source_data, size);
+      }
+
+    } else {
+      _buffer.unclean_realloc(size);
+      _buffer.set_size(size);
+
+      if (manager->get_file_endian() == BamReader::BE_native) {
+        // The copy may be deferred to a decode thread, since nothing will
+        // look at the data until the BamReader is resolved.
+        manager->extract_bytes(_buffer.get_write_pointer(), scan, size, array_data);
+      } else {
+        scan.extract_bytes(_buffer.get_write_pointer(), size);
+      }
+    }
   }
 
   bool endian_reversed = false;
@@ -21,6 +21,125 @@
 #include "bamWriter.h"
 #include "pset.h"
 #include "indent.h"
+#include "asyncParallelJob.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define GVD_SKIN_SSE 1
+#endif
+
+/**
+ * The skinning of a single vertex table.  The rows are divided into a number
+ * of contiguous chunks, which are the items of the job.
+ */
+class GeomVertexData::SkinJob : public AsyncParallelJob {
+public:
+  SkinJob() : AsyncParallelJob("skinning", TP_high) {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+
+public:
+  enum ColumnType {
+    CT_point3,
+    CT_vector3,
+    CT_normal3,
+    CT_vecbase4,
+  };
+  struct Column {
+    unsigned char *_data;
+    size_t _stride;
+    ColumnType _type;
+  };
+
+  pvector<Column> _columns;
+  pvector<LMatrix4f> _mats;
+  pvector<LMatrix4f> _normal_mats;
+  pvector<unsigned char> _normalize;
+  const unsigned short *_blendt;
+
+  pvector<std::pair<int, int> > _chunks;
+};
+
+namespace {
+/**
+ * A skinning matrix, kept in the form that is most convenient for
+ * transforming one vertex at a time by the same matrix.  The vertices may not
+ * be aligned, and the 3-component ones may be at the very end of the buffer,
+ * so we don't load more than we need from them.
+ */
+class SkinMatrix {
+public:
+  INLINE void load(const LMatrix4f &mat) {
+    const float *m = mat.get_data();
+#ifdef GVD_SKIN_SSE
+    _r0 = _mm_loadu_ps(m);
+    _r1 = _mm_loadu_ps(m + 4);
+    _r2 = _mm_loadu_ps(m + 8);
+    _r3 = _mm_loadu_ps(m + 12);
+#else
+    memcpy(_m, m, sizeof(_m));
+#endif
+  }
+
+  INLINE void xform_point3(float *v) const {
+#ifdef GVD_SKIN_SSE
+    __m128 r = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), _r0),
+                 _mm_mul_ps(_mm_set1_ps(v[1]), _r1)),
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[2]), _r2), _r3));
+    _mm_storel_pi((__m64 *)v, r);
+    _mm_store_ss(v + 2, _mm_movehl_ps(r, r));
+#else
+    float x = v[0], y = v[1], z = v[2];
+    v[0] = x * _m[0] + y * _m[4] + z * _m[8] + _m[12];
+    v[1] = x * _m[1] + y * _m[5] + z * _m[9] + _m[13];
+    v[2] = x * _m[2] + y * _m[6] + z * _m[10] + _m[14];
+#endif
+  }
+
+  INLINE void xform_vector3(float *v) const {
+#ifdef GVD_SKIN_SSE
+    __m128 r = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), _r0),
+                 _mm_mul_ps(_mm_set1_ps(v[1]), _r1)),
+      _mm_mul_ps(_mm_set1_ps(v[2]), _r2));
+    _mm_storel_pi((__m64 *)v, r);
+    _mm_store_ss(v + 2, _mm_movehl_ps(r, r));
+#else
+    float x = v[0], y = v[1], z = v[2];
+    v[0] = x * _m[0] + y * _m[4] + z * _m[8];
+    v[1] = x * _m[1] + y * _m[5] + z * _m[9];
+    v[2] = x * _m[2] + y * _m[6] + z * _m[10];
+#endif
+  }
+
+  INLINE void xform_vecbase4(float *v) const {
+#ifdef GVD_SKIN_SSE
+    __m128 a = _mm_loadu_ps(v);
+    __m128 r = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), _r0),
+                 _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), _r1)),
+      _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, 0xaa), _r2),
+                 _mm_mul_ps(_mm_shuffle_ps(a, a, 0xff), _r3)));
+    _mm_storeu_ps(v, r);
+#else
+    float x = v[0], y = v[1], z = v[2], w = v[3];
+    v[0] = x * _m[0] + y * _m[4] + z * _m[8] + w * _m[12];
+    v[1] = x * _m[1] + y * _m[5] + z * _m[9] + w * _m[13];
+    v[2] = x * _m[2] + y * _m[6] + z * _m[10] + w * _m[14];
+    v[3] = x * _m[3] + y * _m[7] + z * _m[11] + w * _m[15];
+#endif
+  }
+
+private:
+#ifdef GVD_SKIN_SSE
+  __m128 _r0, _r1, _r2, _r3;
+#else
+  float _m[16];
+#endif
+};
+}
 
 using std::ostream;
 
@@ -1605,6 +1724,11 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
         new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
       const unsigned short *blendt = (const unsigned short *)blend_array_handle->get_read_pointer(true);
 
+      if (animate_vertices_simd &&
+          do_skin_float32(new_data, new_format, tb_table, blendt, current_thread)) {
+        return;
+      }
+
       size_t ci;
       for (ci = 0; ci < new_format->get_num_points(); ci++) {
         GeomVertexRewriter data(new_data, new_format->get_point(ci));
@@ -1838,30 +1962,7 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   LMatrix4 xform;
   bool normalize = false;
   if (data_column->get_contents() == C_normal) {
-    // This is to preserve perpendicularity to the surface.
-    LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
-                       mat.get_row3(1).length_squared(),
-                       mat.get_row3(2).length_squared());
-    if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
-        IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
-      // There is a uniform scale.
-      LVecBase3 scale, shear, hpr;
-      if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
-        // No scale to worry about.
-        xform = mat;
-      } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
-        // Make a new matrix with scale/translate taken out of the equation.
-        compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
-      } else {
-        normalize = true;
-      }
-    } else {
-      // There is a non-uniform scale, so we need to do all this to preserve
-      // orthogonality to the surface.
-      xform.invert_from(mat);
-      xform.transpose_in_place();
-      normalize = true;
-    }
+    normalize = calc_normal_xform(xform, mat);
   } else {
     xform = mat;
   }
@@ -1906,6 +2007,42 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   }
 }
 
+/**
+ * Computes the matrix that should be applied to normals that are animated by
+ * the indicated matrix, in order to keep them perpendicular to the surface.
+ * Returns true if the normals will need to be renormalized afterwards, or
+ * false if the matrix preserves their length.
+ */
+bool GeomVertexData::
+calc_normal_xform(LMatrix4 &xform, const LMatrix4 &mat) {
+  LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
+                     mat.get_row3(1).length_squared(),
+                     mat.get_row3(2).length_squared());
+  if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
+      IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
+    // There is a uniform scale.
+    LVecBase3 scale, shear, hpr;
+    if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
+      // No scale to worry about.
+      xform = mat;
+      return false;
+    } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
+      // Make a new matrix with scale/translate taken out of the equation.
+      compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
+      return false;
+    } else {
+      xform = mat;
+      return true;
+    }
+  } else {
+    // There is a non-uniform scale, so we need to do all this to preserve
+    // orthogonality to the surface.
+    xform.invert_from(mat);
+    xform.transpose_in_place();
+    return true;
+  }
+}
+
 /**
  * Transforms each of the LPoint3f objects in the indicated table by the
  * indicated matrix.
@@ -1982,6 +2119,184 @@ table_xform_vecbase4f(unsigned char *datat, size_t num_rows, size_t stride,
   }
 }
 
+/**
+ * The fast path of update_animated_vertices(), used when the blend indices
+ * are a table of ushorts and all of the point and vector columns are stored
+ * as 3- or 4-component 32-bit floats, which is by far the most common case.
+ * The matrix for each blend is computed only once, and the vertices are
+ * transformed using SIMD instructions where these are available.  Large
+ * tables may also be split up among the threads of the "skinning" task
+ * chain.
+ *
+ * Returns true if the vertices have been animated, or false if the format is
+ * not suitable, in which case nothing has been modified.
+ */
+bool GeomVertexData::
+do_skin_float32(GeomVertexData *new_data, const GeomVertexFormat *format,
+                const TransformBlendTable *tb_table,
+                const unsigned short *blendt, Thread *current_thread) {
+  // First make sure that we can handle all of the columns.
+  size_t num_points = format->get_num_points();
+  size_t num_vectors = format->get_num_vectors();
+  size_t ci;
+  for (ci = 0; ci < num_points + num_vectors; ++ci) {
+    const InternalName *name = (ci < num_points)
+      ? format->get_point(ci) : format->get_vector(ci - num_points);
+    const GeomVertexColumn *column = format->get_column(name);
+    if (column == nullptr ||
+        column->get_numeric_type() != NT_float32 ||
+        (column->get_num_values() != 3 && column->get_num_values() != 4)) {
+      return false;
+    }
+  }
+
+  SkinJob job;
+  job._blendt = blendt;
+
+  // Get a write pointer to each array that holds one of the columns.  We
+  // keep the handles around until we are done writing to them.
+  pvector<PT(GeomVertexArrayDataHandle)> handles(format->get_num_arrays());
+  bool any_normals = false;
+
+  for (ci = 0; ci < num_points + num_vectors; ++ci) {
+    const InternalName *name = (ci < num_points)
+      ? format->get_point(ci) : format->get_vector(ci - num_points);
+    const GeomVertexColumn *column = format->get_column(name);
+    int array_index = format->get_array_with(name);
+    nassertr(array_index >= 0, false);
+
+    if (handles[array_index] == nullptr) {
+      handles[array_index] = new_data->modify_array_handle(array_index);
+    }
+
+    SkinJob::Column col;
+    col._data = handles[array_index]->get_write_pointer() + column->get_start();
+    col._stride = handles[array_index]->get_array_format()->get_stride();
+    if (ci < num_points) {
+      col._type = (column->get_num_values() == 3)
+        ? SkinJob::CT_point3 : SkinJob::CT_vecbase4;
+    } else if (column->get_contents() == C_normal) {
+      col._type = SkinJob::CT_normal3;
+      any_normals = true;
+    } else {
+      col._type = (column->get_num_values() == 3)
+        ? SkinJob::CT_vector3 : SkinJob::CT_vecbase4;
+    }
+    job._columns.push_back(col);
+  }
+
+  // Now compute the matrix for each blend, just once.
+  int num_blends = tb_table->get_num_blends();
+  job._mats.reserve(num_blends);
+  if (any_normals) {
+    job._normal_mats.reserve(num_blends);
+    job._normalize.reserve(num_blends);
+  }
+  for (int bi = 0; bi < num_blends; ++bi) {
+    LMatrix4 mat;
+    tb_table->get_blend(bi).get_blend(mat, current_thread);
+    job._mats.push_back(LCAST(float, mat));
+
+    if (any_normals) {
+      LMatrix4 xform;
+      bool normalize = calc_normal_xform(xform, mat);
+      job._normal_mats.push_back(LCAST(float, xform));
+      job._normalize.push_back(normalize);
+    }
+  }
+
+  // Divide the rows into chunks.  If we are going to use the worker threads,
+  // we make several chunks per thread, so that a thread that gets delayed
+  // doesn't hold up the others.
+  const SparseArray &rows = tb_table->get_rows();
+  int num_subranges = rows.get_num_subranges();
+  int total_rows = 0;
+  int i;
+  for (i = 0; i < num_subranges; ++i) {
+    int begin = rows.get_subrange_begin(i);
+    int end = rows.get_subrange_end(i);
+    nassertr(begin < end, false);
+    nassertr(end <= new_data->get_num_rows(), false);
+    total_rows += end - begin;
+  }
+
+  int num_threads = animate_vertices_num_threads;
+  bool parallel = (num_threads > 0 && total_rows >= animate_vertices_parallel_threshold);
+
+  int chunk_rows = total_rows;
+  if (parallel) {
+    chunk_rows = std::max((total_rows + (num_threads + 1) * 4 - 1) / ((num_threads + 1) * 4), 256);
+  }
+  for (i = 0; i < num_subranges; ++i) {
+    int begin = rows.get_subrange_begin(i);
+    int end = rows.get_subrange_end(i);
+    while (begin < end) {
+      int chunk_end = std::min(begin + chunk_rows, end);
+      job._chunks.push_back(std::pair<int, int>(begin, chunk_end));
+      begin = chunk_end;
+    }
+  }
+
+  job.run((int)job._chunks.size(), parallel ? num_threads : 0);
+  return true;
+}
+
+/**
+ * Transforms the nth chunk of rows.  Called from each thread that takes part
+ * in the job.
+ */
+void GeomVertexData::SkinJob::
+do_item(int n, Thread *) {
+  int begin = _chunks[n].first;
+  int end = _chunks[n].second;
+
+  for (const SkinJob::Column &col : _columns) {
+    const pvector<LMatrix4f> &mats =
+      (col._type == SkinJob::CT_normal3) ? _normal_mats : _mats;
+
+    // Reload the matrix only when the blend index changes; consecutive
+    // vertices very often share the same blend.
+    int last_bi = -1;
+    SkinMatrix xform;
+    bool normalize = false;
+    unsigned char *datat = col._data + begin * col._stride;
+
+    for (int j = begin; j < end; ++j, datat += col._stride) {
+      int bi = _blendt[j];
+      if (bi != last_bi) {
+        nassertv(bi < (int)mats.size());
+        xform.load(mats[bi]);
+        if (col._type == SkinJob::CT_normal3) {
+          normalize = (_normalize[bi] != 0);
+        }
+        last_bi = bi;
+      }
+
+      float *v = (float *)datat;
+      switch (col._type) {
+      case SkinJob::CT_point3:
+        xform.xform_point3(v);
+        break;
+
+      case SkinJob::CT_vector3:
+        xform.xform_vector3(v);
+        break;
+
+      case SkinJob::CT_normal3:
+        xform.xform_vector3(v);
+        if (normalize) {
+          ((LVector3f *)v)->normalize();
+        }
+        break;
+
+      case SkinJob::CT_vecbase4:
+        xform.xform_vecbase4(v);
+        break;
+      }
+    }
+  }
+}
+
 /**
  * Tells the BamReader how to create objects of type GeomVertexData.
  */
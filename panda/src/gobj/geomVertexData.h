@@ -341,6 +341,12 @@ private:
                                  const LMatrix4 &mat, int begin_row, int end_row);
   void do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &data,
                                   const LMatrix4 &mat, int begin_row, int end_row);
+  static bool calc_normal_xform(LMatrix4 &xform, const LMatrix4 &mat);
+
+  class SkinJob;
+  bool do_skin_float32(GeomVertexData *new_data, const GeomVertexFormat *format,
+                       const TransformBlendTable *tb_table,
+                       const unsigned short *blendt, Thread *current_thread);
   static void table_xform_point3f(unsigned char *datat, size_t num_rows,
                                   size_t stride, const LMatrix4f &matf);
   static void table_xform_normal3f(unsigned char *datat, size_t num_rows,
@@ -42,6 +42,7 @@
 #include "streamReader.h"
 #include "texturePeeker.h"
 #include "convert_srgb.h"
+#include "asyncParallelJob.h"
 
 #ifdef HAVE_SQUISH
 #include <squish.h>
@@ -49,6 +50,28 @@
 
 #include <stddef.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TEXTURE_FILTER_SSE2 1
+
+// The SSE4.1 and AVX2 versions of the mipmap filters are compiled regardless
+// of the target architecture, and are chosen at runtime if the CPU supports
+// them.  This requires a compiler that allows these instruction sets to be
+// enabled on individual functions.
+#if defined(_MSC_VER) || defined(__clang__) || \
+  (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#include <smmintrin.h>
+#include <immintrin.h>
+#define TEXTURE_FILTER_AVX2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TEXTURE_FILTER_TARGET(isa)
+#else
+#define TEXTURE_FILTER_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+#endif
+
 using std::endl;
 using std::istream;
 using std::max;
@@ -67,11 +90,155 @@ ConfigVariableEnum<Texture::QualityLevel> texture_quality_level
           "it has little or no effect on normal, hardware-accelerated "
           "renderers.  See Texture::set_quality_level()."));
 
+ConfigVariableEnum<Texture::MipmapFilter> texture_mipmap_filter
+("texture-mipmap-filter", Texture::MF_box,
+ PRC_DESC("Specifies the filter used to compute each mipmap level from the "
+          "one above it, when the mipmaps are generated on the CPU.  The "
+          "default, box, averages each 2x2 block of pixels, and is by far "
+          "the fastest.  kaiser and lanczos are windowed sinc filters that "
+          "keep more detail in the smaller levels, at several times the "
+          "cost.  3-d textures are always box filtered."));
+
+static ConfigVariableString texture_mipmap_simd
+("texture-mipmap-simd", "auto",
+ PRC_DESC("Limits the instruction set extensions used to generate mipmaps "
+          "on the CPU.  The default, auto, uses the best that the CPU "
+          "supports.  Set it to avx2, sse4.1, sse2 or none to use no more "
+          "than that; this is mainly useful for testing and benchmarking."));
+
 PStatCollector Texture::_texture_read_pcollector("*:Texture:Read");
 TypeHandle Texture::_type_handle;
 TypeHandle Texture::CData::_type_handle;
 AutoTextureScale Texture::_textures_power_2 = ATS_unspecified;
 
+/**
+ * The state of an in-memory compression of the RAM images of a texture.  The
+ * pages of each mipmap level are divided into chunks of a few rows of 4x4
+ * blocks each, which are the items of the job.
+ */
+class Texture::CompressJob : public ReferenceCount, public AsyncParallelJob {
+public:
+  CompressJob() : AsyncParallelJob("texture_compress") {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+  virtual void finished(Thread *current_thread);
+
+public:
+  class Chunk {
+  public:
+    int _n;
+    int _z;
+    int _row_begin;
+    int _row_end;
+  };
+  typedef pvector<Chunk> Chunks;
+
+  CompressionMode _compression;
+  int _squish_flags;
+  int _num_components;
+
+  // The uncompressed images, padded to a multiple of the block size where
+  // necessary, and the compressed images being filled in.
+  RamImages _src_images;
+  RamImages _dest_images;
+  pvector<int> _x_sizes;
+  pvector<int> _y_sizes;
+
+  Chunks _chunks;
+
+  // These are only set by async_compress_ram_image().
+  PT(Texture) _texture;
+  PT(AsyncFuture) _future;
+  UpdateSeq _image_modified;
+};
+
+// The number of rows of 4x4 blocks in each chunk of a CompressJob.
+static const int compress_chunk_rows = 16;
+
+// The instruction set extensions that the mipmap filters may use.
+enum MipmapSimdLevel {
+  MSL_none,
+  MSL_sse2,
+  MSL_sse41,
+  MSL_avx2
+};
+
+/**
+ * The state of the generation of a single mipmap level from the level above
+ * it.  The rows of the new level, counted across all of its pages, are
+ * divided into chunks, which are the items of the job.
+ */
+class Texture::MipmapJob : public AsyncParallelJob {
+public:
+  MipmapJob() : AsyncParallelJob("texture_mipmap"), _filter(MF_box) {}
+
+  bool set_filter(const CData *cdata);
+
+  // For the kernel filters, the source pixels that contribute to each pixel
+  // of the new level along one axis, and their weights.  There are _num_taps
+  // entries per pixel; indices outside the level have already been wrapped
+  // or clamped according to the texture's wrap mode.
+  class Axis {
+  public:
+    void compute(MipmapFilter filter, int from_size, int to_size,
+                 SamplerState::WrapMode wrap_mode);
+
+    int _num_taps;
+    pvector<int> _index;
+    pvector<float> _weight;
+  };
+
+  FilterRow *_filter_row;
+  MipmapFilter _filter;
+  MipmapSimdLevel _simd_level;
+  ComponentType _component_type;
+  bool _is_srgb;
+  Axis _x_axis;
+  Axis _y_axis;
+  unsigned char *_to;
+  const unsigned char *_from;
+
+  int _num_components;
+  int _num_color_components;
+  size_t _component_width;
+
+  // The byte offsets between the source values that are averaged together.
+  // These are 0 along any axis on which the source level is only one pixel
+  // in size.
+  size_t _pixel_step;
+  size_t _row_step;
+  size_t _page_step;
+
+  // The number of source rows that contribute to each destination row: 2 for
+  // a 2-D filter, 4 for a 3-D filter.
+  int _num_q;
+
+  int _x_size;
+  size_t _row_size;
+  size_t _page_size;
+  size_t _view_size;
+  size_t _to_row_size;
+  size_t _to_page_size;
+  int _to_x_size;
+  int _to_y_size;
+  int _to_z_size;
+  int _num_rows;
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+};
+
+// The number of destination rows in each chunk of a MipmapJob.
+static const int mipmap_chunk_rows = 16;
+
+// Mipmap levels smaller than this many bytes are always generated on the
+// calling thread, since it is not worth waking up the worker threads.
+static const size_t mipmap_parallel_min_size = 128 * 1024;
+
+// The radius of the windowed sinc mipmap filters, in pixels of the new level.
+static const double mipmap_filter_radius = 3.0;
+
 // Stuff to read and write DDS files.
 
 // little-endian, of course
@@ -1472,6 +1639,45 @@ prepare(PreparedGraphicsObjects *prepared_objects) {
   return prepared_objects->enqueue_texture_future(this);
 }
 
+/**
+ * Starts compressing the texture's RAM image on the texture-compress worker
+ * threads, as compress_ram_image() would, and returns right away.  The
+ * returned future is resolved with this texture when the compression has
+ * finished; check get_ram_image_compression() to see whether it succeeded.
+ * If the RAM image is modified while it is being compressed, the compressed
+ * image is thrown away.
+ *
+ * If the texture was loaded from disk and model-cache-compressed-textures is
+ * set, the compressed image is also stored in the BamCache, so that it need
+ * not be compressed again the next time the texture is loaded.
+ */
+PT(AsyncFuture) Texture::
+async_compress_ram_image(Texture::CompressionMode compression,
+                         Texture::QualityLevel quality_level,
+                         GraphicsStateGuardianBase *gsg) {
+  PT(AsyncFuture) future = new AsyncFuture;
+  PT(CompressJob) job = new CompressJob;
+  {
+    CDWriter cdata(_cycler, false);
+    size_t num_levels = cdata->_ram_images.size();
+    if (compression == CM_off ||
+        !do_make_compress_job(cdata, *job, compression, quality_level, gsg)) {
+      future->set_result(this);
+      return future;
+    }
+    if (cdata->_ram_images.size() != num_levels) {
+      // The mipmap levels were generated along the way.
+      cdata->inc_image_modified();
+    }
+    job->_image_modified = cdata->_image_modified;
+  }
+
+  job->_texture = this;
+  job->_future = future;
+  do_run_compress_job(job, false);
+  return future;
+}
+
 /**
  * Returns true if the texture has already been prepared or enqueued for
  * preparation on the indicated GSG, false otherwise.
@@ -2574,6 +2780,42 @@ string_quality_level(const string &str) {
   return QL_default;
 }
 
+/**
+ * Returns the indicated MipmapFilter converted to a string word.
+ */
+string Texture::
+format_mipmap_filter(MipmapFilter mf) {
+  switch (mf) {
+  case MF_box:
+    return "box";
+  case MF_kaiser:
+    return "kaiser";
+  case MF_lanczos:
+    return "lanczos";
+  }
+
+  return "**invalid**";
+}
+
+/**
+ * Returns the MipmapFilter value associated with the given string
+ * representation.
+ */
+Texture::MipmapFilter Texture::
+string_mipmap_filter(const string &str) {
+  if (cmp_nocase(str, "box") == 0) {
+    return MF_box;
+  } else if (cmp_nocase(str, "kaiser") == 0) {
+    return MF_kaiser;
+  } else if (cmp_nocase(str, "lanczos") == 0) {
+    return MF_lanczos;
+  }
+
+  gobj_cat->error()
+    << "Invalid Texture::MipmapFilter value: " << str << "\n";
+  return MF_box;
+}
+
 /**
  * This method is called by the GraphicsEngine at the beginning of the frame
  * *after* a texture has been successfully uploaded to graphics memory.  It is
@@ -5932,6 +6174,28 @@ bool Texture::
 do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
                       Texture::QualityLevel quality_level,
                       GraphicsStateGuardianBase *gsg) {
+  PT(CompressJob) job = new CompressJob;
+  if (!do_make_compress_job(cdata, *job, compression, quality_level, gsg)) {
+    return false;
+  }
+
+  do_run_compress_job(job, true);
+
+  cdata->_ram_images.swap(job->_dest_images);
+  cdata->_ram_image_compression = job->_compression;
+  return true;
+}
+
+/**
+ * Prepares the indicated job to compress the RAM images of the texture, after
+ * choosing the actual compression mode and quality level to use.  Returns
+ * false if the image cannot be compressed in-memory that way.
+ */
+bool Texture::
+do_make_compress_job(CData *cdata, CompressJob &job,
+                     Texture::CompressionMode compression,
+                     Texture::QualityLevel quality_level,
+                     GraphicsStateGuardianBase *gsg) {
   nassertr(compression != CM_off, false);
 
   if (cdata->_ram_images.empty() || cdata->_ram_image_compression != CM_off) {
@@ -6008,128 +6272,254 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
     quality_level = texture_quality_level;
   }
 
+  int squish_flags = 0;
   if (compression == CM_rgtc) {
     // We should compress RGTC ourselves, as squish does not support it.
-    if (cdata->_component_type != T_unsigned_byte) {
+    if (cdata->_component_type != T_unsigned_byte ||
+        cdata->_num_components < 1 || cdata->_num_components > 2) {
       return false;
     }
 
-    if (!do_has_all_ram_mipmap_images(cdata)) {
-      // If we're about to compress the RAM image, we should ensure that we
-      // have all of the mipmap levels first.
-      do_generate_ram_mipmap_images(cdata, false);
+  } else {
+#ifdef HAVE_SQUISH
+    if (cdata->_texture_type == TT_3d_texture ||
+        cdata->_texture_type == TT_2d_texture_array ||
+        cdata->_component_type != T_unsigned_byte) {
+      return false;
     }
 
-    RamImages compressed_ram_images;
-    compressed_ram_images.resize(cdata->_ram_images.size());
+    switch (compression) {
+    case CM_dxt1:
+      squish_flags |= squish::kDxt1;
+      break;
 
-    for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-      const RamImage *uncompressed_image = &cdata->_ram_images[n];
+    case CM_dxt3:
+      squish_flags |= squish::kDxt3;
+      break;
 
-      int x_size = do_get_expected_mipmap_x_size(cdata, n);
-      int y_size = do_get_expected_mipmap_y_size(cdata, n);
-      int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+    case CM_dxt5:
+      squish_flags |= squish::kDxt5;
+      break;
+
+    default:
+      break;
+    }
+
+    if (squish_flags == 0) {
+      // This compression mode is not supported by squish.
+      return false;
+    }
+
+    switch (quality_level) {
+    case QL_fastest:
+      squish_flags |= squish::kColourRangeFit;
+      break;
+
+    case QL_normal:
+      // ColourClusterFit is just too slow for everyday use.
+      squish_flags |= squish::kColourRangeFit;
+      // squish_flags |= squish::kColourClusterFit;
+      break;
+
+    case QL_best:
+      squish_flags |= squish::kColourIterativeClusterFit;
+      break;
+
+    default:
+      break;
+    }
+#else  // HAVE_SQUISH
+    return false;
+#endif  // HAVE_SQUISH
+  }
+
+  if (!do_has_all_ram_mipmap_images(cdata)) {
+    // If we're about to compress the RAM image, we should ensure that we
+    // have all of the mipmap levels first.
+    do_generate_ram_mipmap_images(cdata, false);
+  }
+
+  int num_components = cdata->_num_components;
+  job._compression = compression;
+  job._squish_flags = squish_flags;
+  job._num_components = num_components;
+
+  size_t num_levels = cdata->_ram_images.size();
+  job._src_images.resize(num_levels);
+  job._dest_images.resize(num_levels);
+  job._x_sizes.resize(num_levels);
+  job._y_sizes.resize(num_levels);
+
+  for (size_t n = 0; n < num_levels; ++n) {
+    const RamImage &uncompressed_image = cdata->_ram_images[n];
+    RamImage &src_image = job._src_images[n];
+    RamImage &dest_image = job._dest_images[n];
+
+    int x_size = do_get_expected_mipmap_x_size(cdata, n);
+    int y_size = do_get_expected_mipmap_y_size(cdata, n);
+    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
+
+    if (compression == CM_rgtc) {
+      nassertr((size_t)x_size * (size_t)y_size * num_components == uncompressed_image._page_size, false);
 
       // It is important that we handle image sizes that aren't a multiple of
       // the block size, since this method may be used to compress mipmaps,
       // which go all the way to 1x1.  Pad the image if necessary.
-      RamImage temp_image;
       if ((x_size | y_size) & 0x3) {
         int virtual_x_size = x_size;
         int virtual_y_size = y_size;
         x_size = (x_size + 3) & ~0x3;
         y_size = (y_size + 3) & ~0x3;
 
-        temp_image._page_size = x_size * y_size * cdata->_num_components;
-        temp_image._image = PTA_uchar::empty_array(temp_image._page_size * num_pages);
+        src_image._page_size = x_size * y_size * num_components;
+        src_image._image = PTA_uchar::empty_array(src_image._page_size * num_pages);
 
         for (int z = 0; z < num_pages; ++z) {
-          unsigned char *dest = temp_image._image.p() + z * temp_image._page_size;
-          unsigned const char *src = uncompressed_image->_image.p() + z * uncompressed_image->_page_size;
+          unsigned char *dest = src_image._image.p() + z * src_image._page_size;
+          unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
 
           for (int y = 0; y < virtual_y_size; ++y) {
-            memcpy(dest, src, virtual_x_size);
-            src += virtual_x_size;
-            dest += x_size;
+            memcpy(dest, src, virtual_x_size * num_components);
+            src += virtual_x_size * num_components;
+            dest += x_size * num_components;
           }
         }
-
-        uncompressed_image = &temp_image;
+      } else {
+        src_image = uncompressed_image;
       }
 
-      // Create a new image to hold the compressed texture pages.
-      RamImage &compressed_image = compressed_ram_images[n];
-      compressed_image._page_size = (x_size * y_size * cdata->_num_components) >> 1;
-      compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
+      dest_image._page_size = (x_size * y_size * num_components) >> 1;
 
-      if (cdata->_num_components == 1) {
-        do_compress_ram_image_bc4(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else if (cdata->_num_components == 2) {
-        do_compress_ram_image_bc5(*uncompressed_image, compressed_image,
-                                  x_size, y_size, num_pages);
-      } else {
-        // Invalid.
-        return false;
-      }
+    } else {
+      src_image = uncompressed_image;
+#ifdef HAVE_SQUISH
+      dest_image._page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
+#endif  // HAVE_SQUISH
     }
 
-    cdata->_ram_images.swap(compressed_ram_images);
-    cdata->_ram_image_compression = CM_rgtc;
-    return true;
-  }
+    // Create a new image to hold the compressed texture pages.
+    dest_image._image = PTA_uchar::empty_array(dest_image._page_size * num_pages);
+    job._x_sizes[n] = x_size;
+    job._y_sizes[n] = y_size;
 
-#ifdef HAVE_SQUISH
-  if (cdata->_texture_type != TT_3d_texture &&
-      cdata->_texture_type != TT_2d_texture_array &&
-      cdata->_component_type == T_unsigned_byte) {
-    int squish_flags = 0;
-    switch (compression) {
-    case CM_dxt1:
-      squish_flags |= squish::kDxt1;
-      break;
+    int num_rows = (y_size + 3) >> 2;
+    for (int z = 0; z < num_pages; ++z) {
+      for (int row = 0; row < num_rows; row += compress_chunk_rows) {
+        CompressJob::Chunk chunk;
+        chunk._n = (int)n;
+        chunk._z = z;
+        chunk._row_begin = row;
+        chunk._row_end = min(row + compress_chunk_rows, num_rows);
+        job._chunks.push_back(chunk);
+      }
+    }
+  }
 
-    case CM_dxt3:
-      squish_flags |= squish::kDxt3;
-      break;
+  return true;
+}
 
-    case CM_dxt5:
-      squish_flags |= squish::kDxt5;
-      break;
+/**
+ * Compresses all of the chunks of the indicated job.  If wait is true, the
+ * calling thread works on the job as well, and returns when it is finished.
+ * Otherwise, the job is left to the worker threads entirely, and whichever of
+ * them finishes it calls finish_async_compress().
+ */
+void Texture::
+do_run_compress_job(CompressJob *job, bool wait) {
+  if (wait) {
+    job->run((int)job->_chunks.size(), texture_compress_num_threads);
+  } else {
+    // The job keeps itself alive until it is finished.
+    job->ref();
+    job->start((int)job->_chunks.size(), texture_compress_num_threads);
+  }
+}
 
-    default:
-      break;
-    }
+/**
+ * Compresses the nth chunk.  Called from each of the threads that take part
+ * in the job.
+ */
+void Texture::CompressJob::
+do_item(int n, Thread *) {
+  do_compress_chunk(*this, (size_t)n);
+}
 
-    if (squish_flags != 0) {
-      // This compression mode is supported by squish; use it.
-      switch (quality_level) {
-      case QL_fastest:
-        squish_flags |= squish::kColourRangeFit;
-        break;
+/**
+ * Called when all of the chunks of a job started by
+ * async_compress_ram_image() have been compressed.
+ */
+void Texture::CompressJob::
+finished(Thread *) {
+  if (_texture != nullptr) {
+    _texture->finish_async_compress(*this);
+  }
+  unref_delete(this);
+}
 
-      case QL_normal:
-        // ColourClusterFit is just too slow for everyday use.
-        squish_flags |= squish::kColourRangeFit;
-        // squish_flags |= squish::kColourClusterFit;
-        break;
+/**
+ * Compresses the indicated chunk of the job.
+ */
+void Texture::
+do_compress_chunk(const CompressJob &job, size_t ci) {
+  const CompressJob::Chunk &chunk = job._chunks[ci];
+
+  if (job._compression == CM_rgtc) {
+    const RamImage &src_image = job._src_images[chunk._n];
+    const RamImage &dest_image = job._dest_images[chunk._n];
+    unsigned const char *src = src_image._image.p() + chunk._z * src_image._page_size;
+    unsigned char *dest = dest_image._image.p() + chunk._z * dest_image._page_size;
+    int x_size = job._x_sizes[chunk._n];
+
+    if (job._num_components == 1) {
+      do_compress_ram_image_bc4(src, dest, x_size, chunk._row_begin, chunk._row_end);
+    } else {
+      do_compress_ram_image_bc5(src, dest, x_size, chunk._row_begin, chunk._row_end);
+    }
+  } else {
+    do_squish(job, ci);
+  }
+}
 
-      case QL_best:
-        squish_flags |= squish::kColourIterativeClusterFit;
-        break;
+/**
+ * Called by the thread that finishes a job started by
+ * async_compress_ram_image(), to store the compressed images on the texture
+ * and resolve the future.
+ */
+void Texture::
+finish_async_compress(CompressJob &job) {
+  Filename store_fullpath;
+  {
+    CDWriter cdata(_cycler, true);
+
+    // If the image was changed in the meantime, we have compressed the wrong
+    // thing, and the result is of no use.
+    if (cdata->_image_modified == job._image_modified &&
+        cdata->_ram_image_compression == CM_off) {
+      cdata->_ram_images.swap(job._dest_images);
+      cdata->_ram_image_compression = job._compression;
+      cdata->inc_image_modified();
 
-      default:
-        break;
+      // If the texture came from disk, keep the compressed version in the
+      // cache, so that we don't have to compress it again next time.
+      BamCache *cache = BamCache::get_global_ptr();
+      if (cdata->_loaded_from_image && !cdata->_fullpath.empty() &&
+          (cdata->_post_load_store_cache || cache->get_cache_compressed_textures())) {
+        store_fullpath = cdata->_fullpath;
+        cdata->_post_load_store_cache = false;
       }
+    }
+  }
 
-      if (do_squish(cdata, compression, squish_flags)) {
-        return true;
-      }
+  if (!store_fullpath.empty()) {
+    BamCache *cache = BamCache::get_global_ptr();
+    PT(BamCacheRecord) record = cache->lookup(store_fullpath, "txo");
+    if (record != nullptr) {
+      record->set_data(this, this);
+      cache->store(record);
     }
   }
-#endif  // HAVE_SQUISH
 
-  return false;
+  job._future->set_result(this);
 }
 
 /**
@@ -6205,261 +6595,249 @@ do_uncompress_ram_image(CData *cdata) {
 }
 
 /**
- * Compresses a RAM image using BC4 compression.
+ * Compresses the indicated rows of 4x4 blocks of one page of a RAM image
+ * using BC4 compression.
  */
 void Texture::
-do_compress_ram_image_bc4(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
+do_compress_ram_image_bc4(const unsigned char *src, unsigned char *dest,
+                          int x_size, int row_begin, int row_end) {
   int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
 
   // NB. This algorithm isn't fully optimal, since it doesn't try to make use
   // of the secondary interpolation mode supported by BC4.  This is not
   // important for most textures, but it may be added in the future.
 
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 <= uncompressed_image._page_size);
-  nassertv((size_t)x_size * (size_t)y_size == uncompressed_image._page_size);
-
   static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-        blk += x_size;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[1], minv); maxv = max(blk[1], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[3], minv); maxv = max(blk[3], maxv);
-
-        // Now calculate the index for each pixel.
-        blk = src;
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-        blk += x_size;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[1] * fac + add)] << 3)
-          | (remap[(int)(blk[2] * fac + add)] << 6)
-          | (remap[(int)(blk[3] * fac + add)] << 9);
-        blk += x_size;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[1] * fac + add)] << 7)
-          | (remap[(int)(blk[2] * fac + add)] << 10)
-          | (remap[(int)(blk[3] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 4;
-      }
-      src += x_size * 3;
-    }
-    Thread::consider_yield();
+  src += (size_t)row_begin * 4 * x_size;
+  dest += (size_t)row_begin * x_blocks * 8;
+
+  // Convert one 4 x 4 block at a time.
+  for (int y = row_begin; y < row_end; ++y) {
+    for (int x = 0; x < x_blocks; ++x) {
+      int a, b, c, d;
+      float fac, add;
+      unsigned char minv, maxv;
+      unsigned const char *blk = src;
+
+      // Find the minimum and maximum value in the block.
+      minv = blk[0];
+      maxv = blk[0];
+      minv = min(blk[1], minv); maxv = max(blk[1], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[3], minv); maxv = max(blk[3], maxv);
+      blk += x_size;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[1], minv); maxv = max(blk[1], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[3], minv); maxv = max(blk[3], maxv);
+      blk += x_size;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[1], minv); maxv = max(blk[1], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[3], minv); maxv = max(blk[3], maxv);
+      blk += x_size;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[1], minv); maxv = max(blk[1], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[3], minv); maxv = max(blk[3], maxv);
+
+      // Now calculate the index for each pixel.
+      blk = src;
+      if (maxv > minv) {
+        fac = 7.5f / (maxv - minv);
+      } else {
+        fac = 0;
+      }
+      add = -minv * fac;
+      a = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[1] * fac + add)] << 3)
+        | (remap[(int)(blk[2] * fac + add)] << 6)
+        | (remap[(int)(blk[3] * fac + add)] << 9);
+      blk += x_size;
+      b = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[1] * fac + add)] << 7)
+        | (remap[(int)(blk[2] * fac + add)] << 10)
+        | (remap[(int)(blk[3] * fac + add)] << 13);
+      blk += x_size;
+      c = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[1] * fac + add)] << 3)
+        | (remap[(int)(blk[2] * fac + add)] << 6)
+        | (remap[(int)(blk[3] * fac + add)] << 9);
+      blk += x_size;
+      d = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[1] * fac + add)] << 7)
+        | (remap[(int)(blk[2] * fac + add)] << 10)
+        | (remap[(int)(blk[3] * fac + add)] << 13);
+
+      *(dest++) = maxv;
+      *(dest++) = minv;
+      *(dest++) = a & 0xff;
+      *(dest++) = (a >> 8) | (b & 0xf0);
+      *(dest++) = b >> 8;
+      *(dest++) = c & 0xff;
+      *(dest++) = (c >> 8) | (d & 0xf0);
+      *(dest++) = d >> 8;
+
+      // Advance to the beginning of the next 4x4 block.
+      src += 4;
+    }
+    src += x_size * 3;
   }
+  Thread::consider_yield();
 }
 
 /**
- * Compresses a RAM image using BC5 compression.
+ * Compresses the indicated rows of 4x4 blocks of one page of a RAM image
+ * using BC5 compression.
  */
 void Texture::
-do_compress_ram_image_bc5(const RamImage &uncompressed_image,
-                          RamImage &compressed_image,
-                          int x_size, int y_size, int num_pages) {
+do_compress_ram_image_bc5(const unsigned char *src, unsigned char *dest,
+                          int x_size, int row_begin, int row_end) {
   int x_blocks = (x_size >> 2);
-  int y_blocks = (y_size >> 2);
   int stride = x_size * 2;
 
   // BC5 uses the same compression algorithm as BC4, except repeated for two
   // channels.
 
-  nassertv((size_t)x_blocks * (size_t)y_blocks * 4 * 4 * 2 <= uncompressed_image._page_size);
-  nassertv((size_t)stride * (size_t)y_size == uncompressed_image._page_size);
-
   static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
 
-  for (int z = 0; z < num_pages; ++z) {
-    unsigned char *dest = compressed_image._image.p() + z * compressed_image._page_size;
-    unsigned const char *src = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-
-    // Convert one 4 x 4 block at a time.
-    for (int y = 0; y < y_blocks; ++y) {
-      for (int x = 0; x < x_blocks; ++x) {
-        int a, b, c, d;
-        float fac, add;
-        unsigned char minv, maxv;
-        unsigned const char *blk = src;
-
-        // Find the minimum and maximum red value in the block.
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Find the minimum and maximum green value in the block.
-        blk = src + 1;
-        minv = blk[0];
-        maxv = blk[0];
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-        blk += stride;
-        minv = min(blk[0], minv); maxv = max(blk[0], maxv);
-        minv = min(blk[2], minv); maxv = max(blk[2], maxv);
-        minv = min(blk[4], minv); maxv = max(blk[4], maxv);
-        minv = min(blk[6], minv); maxv = max(blk[6], maxv);
-
-        // Now calculate the index for each pixel.
-        if (maxv > minv) {
-          fac = 7.5f / (maxv - minv);
-        } else {
-          fac = 0;
-        }
-        add = -minv * fac;
-        blk = src + 1;
-        a = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        b = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-        blk += stride;
-        c = (remap[(int)(blk[0] * fac + add)])
-          | (remap[(int)(blk[2] * fac + add)] << 3)
-          | (remap[(int)(blk[4] * fac + add)] << 6)
-          | (remap[(int)(blk[6] * fac + add)] << 9);
-        blk += stride;
-        d = (remap[(int)(blk[0] * fac + add)] << 4)
-          | (remap[(int)(blk[2] * fac + add)] << 7)
-          | (remap[(int)(blk[4] * fac + add)] << 10)
-          | (remap[(int)(blk[6] * fac + add)] << 13);
-
-        *(dest++) = maxv;
-        *(dest++) = minv;
-        *(dest++) = a & 0xff;
-        *(dest++) = (a >> 8) | (b & 0xf0);
-        *(dest++) = b >> 8;
-        *(dest++) = c & 0xff;
-        *(dest++) = (c >> 8) | (d & 0xf0);
-        *(dest++) = d >> 8;
-
-        // Advance to the beginning of the next 4x4 block.
-        src += 8;
-      }
-      src += stride * 3;
-    }
-    Thread::consider_yield();
+  src += (size_t)row_begin * 4 * stride;
+  dest += (size_t)row_begin * x_blocks * 16;
+
+  // Convert one 4 x 4 block at a time.
+  for (int y = row_begin; y < row_end; ++y) {
+    for (int x = 0; x < x_blocks; ++x) {
+      int a, b, c, d;
+      float fac, add;
+      unsigned char minv, maxv;
+      unsigned const char *blk = src;
+
+      // Find the minimum and maximum red value in the block.
+      minv = blk[0];
+      maxv = blk[0];
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+
+      // Now calculate the index for each pixel.
+      if (maxv > minv) {
+        fac = 7.5f / (maxv - minv);
+      } else {
+        fac = 0;
+      }
+      add = -minv * fac;
+      blk = src;
+      a = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[2] * fac + add)] << 3)
+        | (remap[(int)(blk[4] * fac + add)] << 6)
+        | (remap[(int)(blk[6] * fac + add)] << 9);
+      blk += stride;
+      b = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[2] * fac + add)] << 7)
+        | (remap[(int)(blk[4] * fac + add)] << 10)
+        | (remap[(int)(blk[6] * fac + add)] << 13);
+      blk += stride;
+      c = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[2] * fac + add)] << 3)
+        | (remap[(int)(blk[4] * fac + add)] << 6)
+        | (remap[(int)(blk[6] * fac + add)] << 9);
+      blk += stride;
+      d = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[2] * fac + add)] << 7)
+        | (remap[(int)(blk[4] * fac + add)] << 10)
+        | (remap[(int)(blk[6] * fac + add)] << 13);
+
+      *(dest++) = maxv;
+      *(dest++) = minv;
+      *(dest++) = a & 0xff;
+      *(dest++) = (a >> 8) | (b & 0xf0);
+      *(dest++) = b >> 8;
+      *(dest++) = c & 0xff;
+      *(dest++) = (c >> 8) | (d & 0xf0);
+      *(dest++) = d >> 8;
+
+      // Find the minimum and maximum green value in the block.
+      blk = src + 1;
+      minv = blk[0];
+      maxv = blk[0];
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+      blk += stride;
+      minv = min(blk[0], minv); maxv = max(blk[0], maxv);
+      minv = min(blk[2], minv); maxv = max(blk[2], maxv);
+      minv = min(blk[4], minv); maxv = max(blk[4], maxv);
+      minv = min(blk[6], minv); maxv = max(blk[6], maxv);
+
+      // Now calculate the index for each pixel.
+      if (maxv > minv) {
+        fac = 7.5f / (maxv - minv);
+      } else {
+        fac = 0;
+      }
+      add = -minv * fac;
+      blk = src + 1;
+      a = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[2] * fac + add)] << 3)
+        | (remap[(int)(blk[4] * fac + add)] << 6)
+        | (remap[(int)(blk[6] * fac + add)] << 9);
+      blk += stride;
+      b = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[2] * fac + add)] << 7)
+        | (remap[(int)(blk[4] * fac + add)] << 10)
+        | (remap[(int)(blk[6] * fac + add)] << 13);
+      blk += stride;
+      c = (remap[(int)(blk[0] * fac + add)])
+        | (remap[(int)(blk[2] * fac + add)] << 3)
+        | (remap[(int)(blk[4] * fac + add)] << 6)
+        | (remap[(int)(blk[6] * fac + add)] << 9);
+      blk += stride;
+      d = (remap[(int)(blk[0] * fac + add)] << 4)
+        | (remap[(int)(blk[2] * fac + add)] << 7)
+        | (remap[(int)(blk[4] * fac + add)] << 10)
+        | (remap[(int)(blk[6] * fac + add)] << 13);
+
+      *(dest++) = maxv;
+      *(dest++) = minv;
+      *(dest++) = a & 0xff;
+      *(dest++) = (a >> 8) | (b & 0xf0);
+      *(dest++) = b >> 8;
+      *(dest++) = c & 0xff;
+      *(dest++) = (c >> 8) | (d & 0xf0);
+      *(dest++) = d >> 8;
+
+      // Advance to the beginning of the next 4x4 block.
+      src += 8;
+    }
+    src += stride * 3;
   }
+  Thread::consider_yield();
 }
 
 /**
@@ -9266,661 +9644,1099 @@ void Texture::
 do_filter_2d_mipmap_pages(const CData *cdata,
                           Texture::RamImage &to, const Texture::RamImage &from,
                           int x_size, int y_size) const {
-  Filter2DComponent *filter_component;
-  Filter2DComponent *filter_alpha;
-
-  if (is_srgb(cdata->_format)) {
-    // We currently only support sRGB mipmap generation for unsigned byte
-    // textures, due to our use of a lookup table.
-    nassertv(cdata->_component_type == T_unsigned_byte);
-
-    if (has_sse2_sRGB_encode()) {
-      filter_component = &filter_2d_unsigned_byte_srgb_sse2;
-    } else {
-      filter_component = &filter_2d_unsigned_byte_srgb;
-    }
+  MipmapJob job;
+  if (!job.set_filter(cdata)) {
+    return;
+  }
 
-    // Alpha is always linear.
-    filter_alpha = &filter_2d_unsigned_byte;
+  size_t pixel_size = cdata->_num_components * cdata->_component_width;
+  job._x_size = x_size;
+  job._row_size = (size_t)x_size * pixel_size;
+  job._page_size = (size_t)y_size * job._row_size;
+  job._view_size = job._page_size;
+  job._pixel_step = (x_size != 1) ? pixel_size : 0;
+  job._row_step = (y_size != 1) ? job._row_size : 0;
+  job._page_step = 0;
+  job._num_q = 2;
+
+  job._to_x_size = max(x_size >> 1, 1);
+  job._to_y_size = max(y_size >> 1, 1);
+  job._to_z_size = 1;
+
+  job._to_row_size = (size_t)job._to_x_size * pixel_size;
+  job._to_page_size = (size_t)job._to_y_size * job._to_row_size;
+  to._page_size = job._to_page_size;
+  to._image = PTA_uchar::empty_array(to._page_size * cdata->_z_size * cdata->_num_views, get_class_type());
 
-  } else {
-    switch (cdata->_component_type) {
-    case T_unsigned_byte:
-      filter_component = &filter_2d_unsigned_byte;
-      break;
+  nassertv(from._image.size() >= job._page_size * cdata->_z_size * cdata->_num_views);
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._num_rows = job._to_y_size * cdata->_z_size * cdata->_num_views;
 
-    case T_unsigned_short:
-      filter_component = &filter_2d_unsigned_short;
-      break;
+  job._filter = texture_mipmap_filter;
+  if (job._filter != MF_box) {
+    job._x_axis.compute(job._filter, x_size, job._to_x_size,
+                        cdata->_default_sampler.get_wrap_u());
+    job._y_axis.compute(job._filter, y_size, job._to_y_size,
+                        cdata->_default_sampler.get_wrap_v());
+  }
 
-    case T_float:
-      filter_component = &filter_2d_float;
-      break;
+  do_run_mipmap_job(job);
+}
 
-    default:
-      gobj_cat.error()
-        << "Unable to generate mipmaps for 2D texture with component type "
-        << cdata->_component_type << "!";
-      return;
-    }
-    filter_alpha = filter_component;
+/**
+ * Generates the next mipmap level from the previous one, treating all the
+ * pages of the level as a single 3-d block of pixels.
+ *
+ * x_size, y_size, and z_size are the size of the previous level.  They need
+ * not be a power of 2, or even a multiple of 2.
+ *
+ * Assumes the lock is already held.
+ */
+void Texture::
+do_filter_3d_mipmap_level(const CData *cdata,
+                          Texture::RamImage &to, const Texture::RamImage &from,
+                          int x_size, int y_size, int z_size) const {
+  MipmapJob job;
+  if (!job.set_filter(cdata)) {
+    return;
   }
 
   size_t pixel_size = cdata->_num_components * cdata->_component_width;
-  size_t row_size = (size_t)x_size * pixel_size;
+  job._x_size = x_size;
+  job._row_size = (size_t)x_size * pixel_size;
+  job._page_size = (size_t)y_size * job._row_size;
+  job._view_size = (size_t)z_size * job._page_size;
+  job._pixel_step = (x_size != 1) ? pixel_size : 0;
+  job._row_step = (y_size != 1) ? job._row_size : 0;
+  job._page_step = (z_size != 1) ? job._page_size : 0;
+  job._num_q = 4;
 
-  int to_x_size = max(x_size >> 1, 1);
-  int to_y_size = max(y_size >> 1, 1);
+  job._to_x_size = max(x_size >> 1, 1);
+  job._to_y_size = max(y_size >> 1, 1);
+  job._to_z_size = max(z_size >> 1, 1);
 
-  size_t to_row_size = (size_t)to_x_size * pixel_size;
-  to._page_size = (size_t)to_y_size * to_row_size;
-  to._image = PTA_uchar::empty_array(to._page_size * cdata->_z_size * cdata->_num_views, get_class_type());
+  job._to_row_size = (size_t)job._to_x_size * pixel_size;
+  job._to_page_size = (size_t)job._to_y_size * job._to_row_size;
+  to._page_size = job._to_page_size;
+  to._image = PTA_uchar::empty_array(to._page_size * job._to_z_size * cdata->_num_views, get_class_type());
 
-  bool alpha = has_alpha(cdata->_format);
-  int num_color_components = cdata->_num_components;
-  if (alpha) {
-    --num_color_components;
-  }
+  nassertv(from._image.size() >= job._view_size * cdata->_num_views);
+  job._to = to._image.p();
+  job._from = from._image.p();
+  job._num_rows = job._to_y_size * job._to_z_size * cdata->_num_views;
 
-  int num_pages = cdata->_z_size * cdata->_num_views;
-  for (int z = 0; z < num_pages; ++z) {
-    // For each level.
-    unsigned char *p = to._image.p() + z * to._page_size;
-    nassertv(p <= to._image.p() + to._image.size() + to._page_size);
-    const unsigned char *q = from._image.p() + z * from._page_size;
-    nassertv(q <= from._image.p() + from._image.size() + from._page_size);
-    if (y_size != 1) {
-      int y;
-      for (y = 0; y < y_size - 1; y += 2) {
-        // For each row.
-        nassertv(p == to._image.p() + z * to._page_size + (y / 2) * to_row_size);
-        nassertv(q == from._image.p() + z * from._page_size + y * row_size);
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, row_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, row_size);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, row_size);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, row_size);
-          }
-        }
-        q += row_size;
-        Thread::consider_yield();
-      }
-      if (y < y_size) {
-        // Skip the last odd row.
-        q += row_size;
-      }
-    } else {
-      // Just one row.
-      if (x_size != 1) {
-        int x;
-        for (x = 0; x < x_size - 1; x += 2) {
-          // For each pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, pixel_size, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, pixel_size, 0);
-          }
-          q += pixel_size;
-        }
-        if (x < x_size) {
-          // Skip the last odd pixel.
-          q += pixel_size;
-        }
-      } else {
-        // Just one pixel.
-        for (int c = 0; c < num_color_components; ++c) {
-          // For each component.
-          filter_component(p, q, 0, 0);
-        }
-        if (alpha) {
-          filter_alpha(p, q, pixel_size, 0);
-        }
-      }
+  do_run_mipmap_job(job);
+}
+
+/**
+ * Returns the best instruction set extensions, among those that the mipmap
+ * filters have been written for, that this CPU supports.
+ */
+static MipmapSimdLevel
+detect_mipmap_simd_level() {
+#if defined(TEXTURE_FILTER_AVX2) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  int max_leaf = info[0];
+  __cpuid(info, 1);
+  bool has_sse41 = (info[2] & (1 << 19)) != 0;
+
+  // AVX2 also needs the OS to save the upper halves of the ymm registers.
+  if (max_leaf >= 7 && (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+      (_xgetbv(0) & 6) == 6) {
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 5)) != 0) {
+      return MSL_avx2;
     }
+  }
+  return has_sse41 ? MSL_sse41 : MSL_sse2;
 
-    nassertv(p == to._image.p() + (z + 1) * to._page_size);
-    nassertv(q == from._image.p() + (z + 1) * from._page_size);
+#elif defined(TEXTURE_FILTER_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return MSL_avx2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return MSL_sse41;
   }
+  return MSL_sse2;
+
+#elif defined(TEXTURE_FILTER_SSE2)
+  return MSL_sse2;
+
+#else
+  return MSL_none;
+#endif
 }
 
 /**
- * Generates the next mipmap level from the previous one, treating all the
- * pages of the level as a single 3-d block of pixels.
- *
- * x_size, y_size, and z_size are the size of the previous level.  They need
- * not be a power of 2, or even a multiple of 2.
- *
- * Assumes the lock is already held.
+ * Returns the instruction set extensions that the mipmap filters may use,
+ * which are those supported by the CPU, limited by texture-mipmap-simd.
  */
-void Texture::
-do_filter_3d_mipmap_level(const CData *cdata,
-                          Texture::RamImage &to, const Texture::RamImage &from,
-                          int x_size, int y_size, int z_size) const {
-  Filter3DComponent *filter_component;
-  Filter3DComponent *filter_alpha;
+static MipmapSimdLevel
+get_mipmap_simd_level() {
+  static const MipmapSimdLevel cpu_level = detect_mipmap_simd_level();
+
+  const string &limit = texture_mipmap_simd.get_value();
+  MipmapSimdLevel max_level = MSL_avx2;
+  if (cmp_nocase(limit, "none") == 0) {
+    max_level = MSL_none;
+  } else if (cmp_nocase(limit, "sse2") == 0) {
+    max_level = MSL_sse2;
+  } else if (cmp_nocase(limit, "sse4.1") == 0) {
+    max_level = MSL_sse41;
+  }
+  return (cpu_level < max_level) ? cpu_level : max_level;
+}
 
-  if (is_srgb(cdata->_format)) {
+/**
+ * Chooses the function that filters each row of the mipmap level, according
+ * to the format of the texture.  Returns false if mipmaps cannot be generated
+ * for this kind of texture.
+ */
+bool Texture::MipmapJob::
+set_filter(const Texture::CData *cdata) {
+  _simd_level = get_mipmap_simd_level();
+  _component_type = cdata->_component_type;
+  _is_srgb = is_srgb(cdata->_format);
+
+  if (_is_srgb) {
     // We currently only support sRGB mipmap generation for unsigned byte
     // textures, due to our use of a lookup table.
-    nassertv(cdata->_component_type == T_unsigned_byte);
+    nassertr(cdata->_component_type == T_unsigned_byte, false);
 
-    if (has_sse2_sRGB_encode()) {
-      filter_component = &filter_3d_unsigned_byte_srgb_sse2;
+    if (_simd_level >= MSL_sse2 && has_sse2_sRGB_encode()) {
+      _filter_row = &filter_row_unsigned_byte_srgb_sse2;
     } else {
-      filter_component = &filter_3d_unsigned_byte_srgb;
+      _filter_row = &filter_row_unsigned_byte_srgb;
     }
 
-    // Alpha is always linear.
-    filter_alpha = &filter_3d_unsigned_byte;
-
   } else {
     switch (cdata->_component_type) {
     case T_unsigned_byte:
-      filter_component = &filter_3d_unsigned_byte;
+      _filter_row = &filter_row_unsigned_byte;
       break;
 
     case T_unsigned_short:
-      filter_component = &filter_3d_unsigned_short;
+      _filter_row = &filter_row_unsigned_short;
       break;
 
     case T_float:
-      filter_component = &filter_3d_float;
+      _filter_row = &filter_row_float;
       break;
 
     default:
       gobj_cat.error()
-        << "Unable to generate mipmaps for 3D texture with component type "
+        << "Unable to generate mipmaps for texture with component type "
         << cdata->_component_type << "!";
-      return;
+      return false;
     }
-    filter_alpha = filter_component;
   }
 
-  size_t pixel_size = cdata->_num_components * cdata->_component_width;
-  size_t row_size = (size_t)x_size * pixel_size;
-  size_t page_size = (size_t)y_size * row_size;
-  size_t view_size = (size_t)z_size * page_size;
-
-  int to_x_size = max(x_size >> 1, 1);
-  int to_y_size = max(y_size >> 1, 1);
-  int to_z_size = max(z_size >> 1, 1);
-
-  size_t to_row_size = (size_t)to_x_size * pixel_size;
-  size_t to_page_size = (size_t)to_y_size * to_row_size;
-  size_t to_view_size = (size_t)to_z_size * to_page_size;
-  to._page_size = to_page_size;
-  to._image = PTA_uchar::empty_array(to_page_size * to_z_size * cdata->_num_views, get_class_type());
-
-  bool alpha = has_alpha(cdata->_format);
-  int num_color_components = cdata->_num_components;
-  if (alpha) {
-    --num_color_components;
-  }
-
-  for (int view = 0; view < cdata->_num_views; ++view) {
-    unsigned char *start_to = to._image.p() + view * to_view_size;
-    const unsigned char *start_from = from._image.p() + view * view_size;
-    nassertv(start_to + to_view_size <= to._image.p() + to._image.size());
-    nassertv(start_from + view_size <= from._image.p() + from._image.size());
-    unsigned char *p = start_to;
-    const unsigned char *q = start_from;
-    if (z_size != 1) {
-      int z;
-      for (z = 0; z < z_size - 1; z += 2) {
-        // For each level.
-        nassertv(p == start_to + (z / 2) * to_page_size);
-        nassertv(q == start_from + z * page_size);
-        if (y_size != 1) {
-          int y;
-          for (y = 0; y < y_size - 1; y += 2) {
-            // For each row.
-            nassertv(p == start_to + (z / 2) * to_page_size + (y / 2) * to_row_size);
-            nassertv(q == start_from + z * page_size + y * row_size);
-            if (x_size != 1) {
-              int x;
-              for (x = 0; x < x_size - 1; x += 2) {
-                // For each pixel.
-                for (int c = 0; c < num_color_components; ++c) {
-                  // For each component.
-                  filter_component(p, q, pixel_size, row_size, page_size);
-                }
-                if (alpha) {
-                  filter_alpha(p, q, pixel_size, row_size, page_size);
-                }
-                q += pixel_size;
-              }
-              if (x < x_size) {
-                // Skip the last odd pixel.
-                q += pixel_size;
-              }
-            } else {
-              // Just one pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, 0, row_size, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, 0, row_size, page_size);
-              }
-            }
-            q += row_size;
-            Thread::consider_yield();
+  _num_components = cdata->_num_components;
+  _num_color_components = cdata->_num_components;
+  if (has_alpha(cdata->_format)) {
+    // Alpha is always filtered linearly, even for sRGB textures.
+    --_num_color_components;
+  }
+  _component_width = cdata->_component_width;
+  return true;
+}
+
+/**
+ * Filters all of the rows of the indicated mipmap job, and returns when it is
+ * finished.  Large levels are shared with the threads of the texture_mipmap
+ * task chain, if texture-mipmap-num-threads is set.
+ */
+void Texture::
+do_run_mipmap_job(MipmapJob &job) {
+  int num_chunks = (job._num_rows + mipmap_chunk_rows - 1) / mipmap_chunk_rows;
+  int num_threads = 0;
+  if ((size_t)job._num_rows * job._to_row_size >= mipmap_parallel_min_size) {
+    num_threads = texture_mipmap_num_threads;
+  }
+  job.run(num_chunks, num_threads);
+}
+
+/**
+ * Filters the nth chunk of rows.  Called from each of the threads that take
+ * part in the job.
+ */
+void Texture::MipmapJob::
+do_item(int n, Thread *) {
+  int row_begin = n * mipmap_chunk_rows;
+  int row_end = min(row_begin + mipmap_chunk_rows, _num_rows);
+  if (_filter != MF_box) {
+    do_filter_mipmap_rows_kernel(*this, row_begin, row_end);
+  } else {
+    do_filter_mipmap_rows(*this, row_begin, row_end);
+  }
+}
+
+/**
+ * Fills in the indicated range of rows of the new mipmap level.  The rows are
+ * counted consecutively across all of the pages and views of the level.
+ */
+void Texture::
+do_filter_mipmap_rows(const MipmapJob &job, int row_begin, int row_end) {
+  for (int row = row_begin; row < row_end; ++row) {
+    int to_page = row / job._to_y_size;
+    int y = row - to_page * job._to_y_size;
+    int view = to_page / job._to_z_size;
+    int z = to_page - view * job._to_z_size;
+
+    unsigned char *p = job._to + to_page * job._to_page_size + y * job._to_row_size;
+    const unsigned char *q0 = job._from + view * job._view_size
+      + (size_t)(z * 2) * job._page_size + (size_t)(y * 2) * job._row_size;
+
+    // These are the source rows in the order in which their values are
+    // summed; any odd last row or page of the source level is skipped.
+    const unsigned char *q[4];
+    q[0] = q0;
+    q[1] = q0 + job._row_step;
+    q[2] = q0 + job._page_step;
+    q[3] = q0 + job._page_step + job._row_step;
+
+    job._filter_row(job, p, q);
+    Thread::consider_yield();
+  }
+}
+
+/**
+ * Fills in the indicated range of rows of the new mipmap level with one of
+ * the windowed sinc filters.  Each row is first filtered vertically into a
+ * row of floats, which is then filtered horizontally into the new level.
+ * This is only used for 2-d pages, so the rows of each page of the new level
+ * come from the same page of the source level.
+ */
+void Texture::
+do_filter_mipmap_rows_kernel(const MipmapJob &job, int row_begin, int row_end) {
+  int nc = job._num_components;
+  int num_color_components = job._is_srgb ? job._num_color_components : 0;
+  size_t num_values = (size_t)job._x_size * nc;
+  int x_taps = job._x_axis._num_taps;
+  int y_taps = job._y_axis._num_taps;
+
+  pvector<float> line(num_values);
+  for (int row = row_begin; row < row_end; ++row) {
+    int page = row / job._to_y_size;
+    int y = row - page * job._to_y_size;
+    const unsigned char *from_page = job._from + page * job._page_size;
+
+    std::fill(line.begin(), line.end(), 0.0f);
+    const int *yi = &job._y_axis._index[(size_t)y * y_taps];
+    const float *yw = &job._y_axis._weight[(size_t)y * y_taps];
+    for (int t = 0; t < y_taps; ++t) {
+      float w = yw[t];
+      if (w == 0.0f) {
+        continue;
+      }
+      const unsigned char *q = from_page + (size_t)yi[t] * job._row_size;
+
+      switch (job._component_type) {
+      case T_unsigned_byte:
+        for (size_t i = 0; i < num_values; i += nc) {
+          int c = 0;
+          for (; c < num_color_components; ++c) {
+            line[i + c] += decode_sRGB_float(q[i + c]) * w;
           }
-          if (y < y_size) {
-            // Skip the last odd row.
-            q += row_size;
+          for (; c < nc; ++c) {
+            line[i + c] += (float)q[i + c] * w;
           }
-        } else {
-          // Just one row.
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, 0, page_size);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, 0, page_size);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, 0, page_size);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, 0, page_size);
-            }
+        }
+        break;
+
+      case T_unsigned_short:
+        {
+          const unsigned short *qs = (const unsigned short *)q;
+          for (size_t i = 0; i < num_values; ++i) {
+            line[i] += (float)qs[i] * w;
           }
         }
-        q += page_size;
-      }
-      if (z < z_size) {
-        // Skip the last odd page.
-        q += page_size;
-      }
-    } else {
-      // Just one page.
-      if (y_size != 1) {
-        int y;
-        for (y = 0; y < y_size - 1; y += 2) {
-          // For each row.
-          nassertv(p == start_to + (y / 2) * to_row_size);
-          nassertv(q == start_from + y * row_size);
-          if (x_size != 1) {
-            int x;
-            for (x = 0; x < x_size - 1; x += 2) {
-              // For each pixel.
-              for (int c = 0; c < num_color_components; ++c) {
-                // For each component.
-                filter_component(p, q, pixel_size, row_size, 0);
-              }
-              if (alpha) {
-                filter_alpha(p, q, pixel_size, row_size, 0);
-              }
-              q += pixel_size;
-            }
-            if (x < x_size) {
-              // Skip the last odd pixel.
-              q += pixel_size;
-            }
-          } else {
-            // Just one pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, 0, row_size, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, 0, row_size, 0);
-            }
+        break;
+
+      case T_float:
+        {
+          const float *qf = (const float *)q;
+          for (size_t i = 0; i < num_values; ++i) {
+            line[i] += qf[i] * w;
           }
-          q += row_size;
-          Thread::consider_yield();
         }
-        if (y < y_size) {
-          // Skip the last odd row.
-          q += row_size;
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    unsigned char *p = job._to + page * job._to_page_size + y * job._to_row_size;
+    for (int x = 0; x < job._to_x_size; ++x) {
+      const int *xi = &job._x_axis._index[(size_t)x * x_taps];
+      const float *xw = &job._x_axis._weight[(size_t)x * x_taps];
+      for (int c = 0; c < nc; ++c) {
+        float result = 0.0f;
+        for (int t = 0; t < x_taps; ++t) {
+          result += line[(size_t)xi[t] * nc + c] * xw[t];
         }
-      } else {
-        // Just one row.
-        if (x_size != 1) {
-          int x;
-          for (x = 0; x < x_size - 1; x += 2) {
-            // For each pixel.
-            for (int c = 0; c < num_color_components; ++c) {
-              // For each component.
-              filter_component(p, q, pixel_size, 0, 0);
-            }
-            if (alpha) {
-              filter_alpha(p, q, pixel_size, 0, 0);
-            }
-            q += pixel_size;
-          }
-          if (x < x_size) {
-            // Skip the last odd pixel.
-            q += pixel_size;
-          }
-        } else {
-          // Just one pixel.
-          for (int c = 0; c < num_color_components; ++c) {
-            // For each component.
-            filter_component(p, q, 0, 0, 0);
-          }
-          if (alpha) {
-            filter_alpha(p, q, 0, 0, 0);
+
+        // The filters have negative lobes, so the integer formats need to be
+        // clamped.
+        size_t o = (size_t)x * nc + c;
+        switch (job._component_type) {
+        case T_unsigned_byte:
+          if (c < num_color_components) {
+            p[o] = encode_sRGB_uchar(result);
+          } else {
+            p[o] = (unsigned char)(max(0.0f, min(result, 255.0f)) + 0.5f);
           }
+          break;
+
+        case T_unsigned_short:
+          ((unsigned short *)p)[o] = (unsigned short)(max(0.0f, min(result, 65535.0f)) + 0.5f);
+          break;
+
+        case T_float:
+          ((float *)p)[o] = result;
+          break;
+
+        default:
+          break;
         }
       }
     }
+    Thread::consider_yield();
+  }
+}
 
-    nassertv(p == start_to + to_z_size * to_page_size);
-    nassertv(q == start_from + z_size * page_size);
+/**
+ * Returns the value of sin(pi x) / (pi x).
+ */
+static double
+mipmap_sinc(double x) {
+  if (x == 0.0) {
+    return 1.0;
   }
+  x *= MathNumbers::pi_d;
+  return sin(x) / x;
 }
 
 /**
- * Averages a 2x2 block of pixel components into a single pixel component, for
- * producing the next mipmap level.  Increments p and q to the next component.
+ * Returns the zeroth-order modified Bessel function of the first kind, which
+ * defines the shape of the Kaiser window.
  */
-void Texture::
-filter_2d_unsigned_byte(unsigned char *&p, const unsigned char *&q,
-                        size_t pixel_size, size_t row_size) {
-  unsigned int result = ((unsigned int)q[0] +
-                         (unsigned int)q[pixel_size] +
-                         (unsigned int)q[row_size] +
-                         (unsigned int)q[pixel_size + row_size]) >> 2;
-  *p = (unsigned char)result;
-  ++p;
-  ++q;
+static double
+mipmap_bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k) {
+    term *= (x * 0.5) / k;
+    sum += term * term;
+  }
+  return sum;
 }
 
 /**
- * Averages a 2x2 block of pixel components into a single pixel component, for
- * producing the next mipmap level.  Increments p and q to the next component.
+ * Returns the weight of the indicated filter at the distance x from the
+ * center of a pixel of the new level, measured in pixels of the new level.
  */
-void Texture::
-filter_2d_unsigned_byte_srgb(unsigned char *&p, const unsigned char *&q,
-                             size_t pixel_size, size_t row_size) {
-  float result = (decode_sRGB_float(q[0]) +
-                  decode_sRGB_float(q[pixel_size]) +
-                  decode_sRGB_float(q[row_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size]));
+static double
+mipmap_filter_weight(Texture::MipmapFilter filter, double x) {
+  x = fabs(x);
+  switch (filter) {
+  case Texture::MF_box:
+    return (x < 0.5) ? 1.0 : 0.0;
+
+  case Texture::MF_kaiser:
+    if (x < mipmap_filter_radius) {
+      static const double alpha = 4.0;
+      double t = x / mipmap_filter_radius;
+      return mipmap_sinc(x) * mipmap_bessel_i0(alpha * sqrt(1.0 - t * t)) /
+        mipmap_bessel_i0(alpha);
+    }
+    break;
+
+  case Texture::MF_lanczos:
+    if (x < mipmap_filter_radius) {
+      return mipmap_sinc(x) * mipmap_sinc(x / mipmap_filter_radius);
+    }
+    break;
+  }
 
-  *p = encode_sRGB_uchar(result * 0.25f);
-  ++p;
-  ++q;
+  return 0.0;
 }
 
 /**
- * Averages a 2x2 block of pixel components into a single pixel component, for
- * producing the next mipmap level.  Increments p and q to the next component.
+ * Maps the indicated pixel index, which may lie outside of the level, onto a
+ * pixel of the level, according to the wrap mode of the texture.
  */
-void Texture::
-filter_2d_unsigned_byte_srgb_sse2(unsigned char *&p, const unsigned char *&q,
-                                  size_t pixel_size, size_t row_size) {
-  float result = (decode_sRGB_float(q[0]) +
-                  decode_sRGB_float(q[pixel_size]) +
-                  decode_sRGB_float(q[row_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size]));
+static int
+wrap_mipmap_index(int i, int size, SamplerState::WrapMode wrap_mode) {
+  switch (wrap_mode) {
+  case SamplerState::WM_repeat:
+    i %= size;
+    return (i < 0) ? i + size : i;
+
+  case SamplerState::WM_mirror:
+    {
+      int period = size * 2;
+      i %= period;
+      if (i < 0) {
+        i += period;
+      }
+      return (i < size) ? i : period - 1 - i;
+    }
 
-  *p = encode_sRGB_uchar_sse2(result * 0.25f);
-  ++p;
-  ++q;
+  default:
+    return max(0, min(i, size - 1));
+  }
 }
 
 /**
- * Averages a 2x2 block of pixel components into a single pixel component, for
- * producing the next mipmap level.  Increments p and q to the next component.
+ * Computes the source pixels, and their weights, that contribute to each
+ * pixel of the new level along one axis.
  */
-void Texture::
-filter_2d_unsigned_short(unsigned char *&p, const unsigned char *&q,
-                         size_t pixel_size, size_t row_size) {
-  unsigned int result = ((unsigned int)*(unsigned short *)&q[0] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size] +
-                         (unsigned int)*(unsigned short *)&q[row_size] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size + row_size]) >> 2;
-  store_unscaled_short(p, result);
-  q += 2;
+void Texture::MipmapJob::Axis::
+compute(Texture::MipmapFilter filter, int from_size, int to_size,
+        SamplerState::WrapMode wrap_mode) {
+  if (from_size == to_size) {
+    // The level is only one pixel in size along this axis.
+    _num_taps = 1;
+    _index.assign((size_t)to_size, 0);
+    for (int j = 0; j < to_size; ++j) {
+      _index[j] = j;
+    }
+    _weight.assign((size_t)to_size, 1.0f);
+    return;
+  }
+
+  double scale = (double)from_size / (double)to_size;
+  double support = mipmap_filter_radius * scale;
+  _num_taps = (int)ceil(support * 2.0) + 2;
+  _index.resize((size_t)to_size * _num_taps);
+  _weight.resize((size_t)to_size * _num_taps);
+
+  pvector<double> weights(_num_taps);
+  for (int j = 0; j < to_size; ++j) {
+    double center = (j + 0.5) * scale;
+    int first = (int)floor(center - support);
+
+    double total = 0.0;
+    for (int t = 0; t < _num_taps; ++t) {
+      weights[t] = mipmap_filter_weight(filter, (first + t + 0.5 - center) / scale);
+      total += weights[t];
+    }
+
+    // Normalize the weights, so that a flat color is preserved exactly.
+    int *index = &_index[(size_t)j * _num_taps];
+    float *weight = &_weight[(size_t)j * _num_taps];
+    for (int t = 0; t < _num_taps; ++t) {
+      index[t] = wrap_mipmap_index(first + t, from_size, wrap_mode);
+      weight[t] = (float)(weights[t] / total);
+    }
+  }
 }
 
+#ifdef TEXTURE_FILTER_AVX2
+// For each number of components, the order in which to shuffle the bytes of
+// each 16 bytes of an unsigned byte source row, so that the two values that
+// are added together for each destination value are next to each other.
+static const unsigned char mipmap_byte_order[3][16] = {
+  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+  { 0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15 },
+  { 0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15 },
+};
+
+// The same, for unsigned short textures.
+static const unsigned char mipmap_short_order[3][16] = {
+  { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+  { 0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15 },
+  { 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15 },
+};
+
 /**
- * Averages a 2x2 block of pixel components into a single pixel component, for
- * producing the next mipmap level.  Increments p and q to the next component.
- */
-void Texture::
-filter_2d_float(unsigned char *&p, const unsigned char *&q,
-                size_t pixel_size, size_t row_size) {
-  *(float *)p = (*(float *)&q[0] +
-                 *(float *)&q[pixel_size] +
-                 *(float *)&q[row_size] +
-                 *(float *)&q[pixel_size + row_size]) / 4.0f;
-  p += 4;
-  q += 4;
+ * Returns the row of the above tables to use for the indicated number of
+ * components, which must be 1, 2 or 4.
+ */
+static INLINE int
+mipmap_order_index(int nc) {
+  return nc >> 1;
 }
 
 /**
- * Averages a 2x2x2 block of pixel components into a single pixel component,
- * for producing the next mipmap level.  Increments p and q to the next
- * component.
+ * The SSE4.1 version of the unsigned byte box filter.  Fills in as many values
+ * of the destination row as it can, 16 at a time, and returns the number of
+ * values filled in.
  */
-void Texture::
-filter_3d_unsigned_byte(unsigned char *&p, const unsigned char *&q,
-                        size_t pixel_size, size_t row_size, size_t page_size) {
-  unsigned int result = ((unsigned int)q[0] +
-                         (unsigned int)q[pixel_size] +
-                         (unsigned int)q[row_size] +
-                         (unsigned int)q[pixel_size + row_size] +
-                         (unsigned int)q[page_size] +
-                         (unsigned int)q[pixel_size + page_size] +
-                         (unsigned int)q[row_size + page_size] +
-                         (unsigned int)q[pixel_size + row_size + page_size]) >> 3;
-  *p = (unsigned char)result;
-  ++p;
-  ++q;
-}
-
-/**
- * Averages a 2x2x2 block of pixel components into a single pixel component,
- * for producing the next mipmap level.  Increments p and q to the next
- * component.
+static size_t TEXTURE_FILTER_TARGET("sse4.1")
+filter_values_unsigned_byte_sse41(unsigned char *p, const unsigned char *const *q,
+                                  int num_q, int shift, int nc, size_t num_values) {
+  const __m128i order = _mm_loadu_si128((const __m128i *)mipmap_byte_order[mipmap_order_index(nc)]);
+  const __m128i ones = _mm_set1_epi8(1);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+
+  size_t i = 0;
+  for (; i + 16 <= num_values; i += 16) {
+    __m128i s0 = _mm_setzero_si128();
+    __m128i s1 = _mm_setzero_si128();
+    for (int r = 0; r < num_q; ++r) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(q[r] + i * 2));
+      __m128i b = _mm_loadu_si128((const __m128i *)(q[r] + i * 2 + 16));
+      s0 = _mm_add_epi16(s0, _mm_maddubs_epi16(_mm_shuffle_epi8(a, order), ones));
+      s1 = _mm_add_epi16(s1, _mm_maddubs_epi16(_mm_shuffle_epi8(b, order), ones));
+    }
+    s0 = _mm_srl_epi16(s0, count);
+    s1 = _mm_srl_epi16(s1, count);
+    _mm_storeu_si128((__m128i *)(p + i), _mm_packus_epi16(s0, s1));
+  }
+  return i;
+}
+
+/**
+ * The AVX2 version of the unsigned byte box filter.  Fills in as many values
+ * of the destination row as it can, 32 at a time, and returns the number of
+ * values filled in.
+ */
+static size_t TEXTURE_FILTER_TARGET("avx2")
+filter_values_unsigned_byte_avx2(unsigned char *p, const unsigned char *const *q,
+                                 int num_q, int shift, int nc, size_t num_values) {
+  const __m256i order = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *)mipmap_byte_order[mipmap_order_index(nc)]));
+  const __m256i ones = _mm256_set1_epi8(1);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+
+  size_t i = 0;
+  for (; i + 32 <= num_values; i += 32) {
+    __m256i s0 = _mm256_setzero_si256();
+    __m256i s1 = _mm256_setzero_si256();
+    for (int r = 0; r < num_q; ++r) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(q[r] + i * 2));
+      __m256i b = _mm256_loadu_si256((const __m256i *)(q[r] + i * 2 + 32));
+      s0 = _mm256_add_epi16(s0, _mm256_maddubs_epi16(_mm256_shuffle_epi8(a, order), ones));
+      s1 = _mm256_add_epi16(s1, _mm256_maddubs_epi16(_mm256_shuffle_epi8(b, order), ones));
+    }
+    s0 = _mm256_srl_epi16(s0, count);
+    s1 = _mm256_srl_epi16(s1, count);
+
+    // The pack works within each 128-bit lane, so put the halves back in
+    // order afterwards.
+    __m256i result = _mm256_packus_epi16(s0, s1);
+    result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256((__m256i *)(p + i), result);
+  }
+  return i;
+}
+
+/**
+ * The SSE4.1 version of the unsigned short box filter.  Fills in as many
+ * values of the destination row as it can, 8 at a time, and returns the
+ * number of values filled in.
+ */
+static size_t TEXTURE_FILTER_TARGET("sse4.1")
+filter_values_unsigned_short_sse41(unsigned short *p, const unsigned short *const *q,
+                                   int num_q, int shift, int nc, size_t num_values) {
+  // The values are moved into the signed range, so that pairs of them can be
+  // added with a multiply-add; the bias is taken off again at the end.
+  const __m128i order = _mm_loadu_si128((const __m128i *)mipmap_short_order[mipmap_order_index(nc)]);
+  const __m128i bias = _mm_set1_epi16((short)0x8000);
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i unbias = _mm_set1_epi32(num_q * 0x10000);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+
+  size_t i = 0;
+  for (; i + 8 <= num_values; i += 8) {
+    __m128i s0 = unbias;
+    __m128i s1 = unbias;
+    for (int r = 0; r < num_q; ++r) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(q[r] + i * 2));
+      __m128i b = _mm_loadu_si128((const __m128i *)(q[r] + i * 2 + 8));
+      a = _mm_xor_si128(_mm_shuffle_epi8(a, order), bias);
+      b = _mm_xor_si128(_mm_shuffle_epi8(b, order), bias);
+      s0 = _mm_add_epi32(s0, _mm_madd_epi16(a, ones));
+      s1 = _mm_add_epi32(s1, _mm_madd_epi16(b, ones));
+    }
+    s0 = _mm_srl_epi32(s0, count);
+    s1 = _mm_srl_epi32(s1, count);
+    _mm_storeu_si128((__m128i *)(p + i), _mm_packus_epi32(s0, s1));
+  }
+  return i;
+}
+
+/**
+ * The AVX2 version of the unsigned short box filter.  Fills in as many values
+ * of the destination row as it can, 16 at a time, and returns the number of
+ * values filled in.
+ */
+static size_t TEXTURE_FILTER_TARGET("avx2")
+filter_values_unsigned_short_avx2(unsigned short *p, const unsigned short *const *q,
+                                  int num_q, int shift, int nc, size_t num_values) {
+  const __m256i order = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *)mipmap_short_order[mipmap_order_index(nc)]));
+  const __m256i bias = _mm256_set1_epi16((short)0x8000);
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256i unbias = _mm256_set1_epi32(num_q * 0x10000);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+
+  size_t i = 0;
+  for (; i + 16 <= num_values; i += 16) {
+    __m256i s0 = unbias;
+    __m256i s1 = unbias;
+    for (int r = 0; r < num_q; ++r) {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(q[r] + i * 2));
+      __m256i b = _mm256_loadu_si256((const __m256i *)(q[r] + i * 2 + 16));
+      a = _mm256_xor_si256(_mm256_shuffle_epi8(a, order), bias);
+      b = _mm256_xor_si256(_mm256_shuffle_epi8(b, order), bias);
+      s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(a, ones));
+      s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(b, ones));
+    }
+    s0 = _mm256_srl_epi32(s0, count);
+    s1 = _mm256_srl_epi32(s1, count);
+
+    __m256i result = _mm256_packus_epi32(s0, s1);
+    result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256((__m256i *)(p + i), result);
+  }
+  return i;
+}
+
+/**
+ * The AVX2 version of the float box filter, for 1 or 4 components.  Fills in
+ * as many values of the destination row as it can, 8 at a time, and returns
+ * the number of values filled in.  The values are added up in the same order
+ * as in the scalar version.
+ */
+static size_t TEXTURE_FILTER_TARGET("avx2")
+filter_values_float_avx2(float *p, const float *const *q,
+                         int num_q, float scale, int nc, size_t num_values) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+
+  size_t i = 0;
+  for (; i + 8 <= num_values; i += 8) {
+    size_t o = i * 2;
+    __m256 result = _mm256_setzero_ps();
+    for (int r = 0; r < num_q; ++r) {
+      __m256 a = _mm256_loadu_ps(q[r] + o);
+      __m256 b = _mm256_loadu_ps(q[r] + o + 8);
+      __m256 even, odd;
+      if (nc == 4) {
+        even = _mm256_permute2f128_ps(a, b, 0x20);
+        odd = _mm256_permute2f128_ps(a, b, 0x31);
+      } else {
+        even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      }
+      result = (r == 0) ? _mm256_add_ps(even, odd) : _mm256_add_ps(_mm256_add_ps(result, even), odd);
+    }
+    result = _mm256_mul_ps(result, vscale);
+    if (nc != 4) {
+      // The shuffle works within each 128-bit lane.
+      result = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(result), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    _mm256_storeu_ps(p + i, result);
+  }
+  return i;
+}
+#endif  // TEXTURE_FILTER_AVX2
+
+/**
+ * Fills in one row of a mipmap level of an unsigned byte texture, averaging
+ * each 2x2 (or 2x2x2) block of the source pixels into a single pixel.
  */
 void Texture::
-filter_3d_unsigned_byte_srgb(unsigned char *&p, const unsigned char *&q,
-                             size_t pixel_size, size_t row_size, size_t page_size) {
-  float result = (decode_sRGB_float(q[0]) +
-                  decode_sRGB_float(q[pixel_size]) +
-                  decode_sRGB_float(q[row_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size]) +
-                  decode_sRGB_float(q[page_size]) +
-                  decode_sRGB_float(q[pixel_size + page_size]) +
-                  decode_sRGB_float(q[row_size + page_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size + page_size]));
+filter_row_unsigned_byte(const MipmapJob &job, unsigned char *p,
+                         const unsigned char *const *q) {
+  int num_q = job._num_q;
+  int shift = (num_q == 4) ? 3 : 2;
+  int nc = job._num_components;
+  size_t step = job._pixel_step;
+  size_t num_values = (size_t)job._to_x_size * nc;
+  size_t i = 0;
+
+#ifdef TEXTURE_FILTER_SSE2
+  if (step == (size_t)nc && (nc == 1 || nc == 2 || nc == 4) &&
+      job._simd_level >= MSL_sse2) {
+#ifdef TEXTURE_FILTER_AVX2
+    if (job._simd_level >= MSL_avx2) {
+      i = filter_values_unsigned_byte_avx2(p, q, num_q, shift, nc, num_values);
+    } else if (job._simd_level >= MSL_sse41) {
+      i = filter_values_unsigned_byte_sse41(p, q, num_q, shift, nc, num_values);
+    }
+#endif  // TEXTURE_FILTER_AVX2
+
+    // Produce 16 values at a time from 32 values of each source row.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    for (; i + 16 <= num_values; i += 16) {
+      // First sum the source rows, widening the values to 16 bits.
+      __m128i s0 = zero;
+      __m128i s1 = zero;
+      __m128i s2 = zero;
+      __m128i s3 = zero;
+      for (int r = 0; r < num_q; ++r) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(q[r] + i * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(q[r] + i * 2 + 16));
+        s0 = _mm_add_epi16(s0, _mm_unpacklo_epi8(a, zero));
+        s1 = _mm_add_epi16(s1, _mm_unpackhi_epi8(a, zero));
+        s2 = _mm_add_epi16(s2, _mm_unpacklo_epi8(b, zero));
+        s3 = _mm_add_epi16(s3, _mm_unpackhi_epi8(b, zero));
+      }
+
+      // Then add each pair of horizontally adjacent pixels.
+      __m128i h0, h1;
+      if (nc == 4) {
+        h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+      } else if (nc == 2) {
+        __m128 f0 = _mm_castsi128_ps(s0);
+        __m128 f1 = _mm_castsi128_ps(s1);
+        __m128 f2 = _mm_castsi128_ps(s2);
+        __m128 f3 = _mm_castsi128_ps(s3);
+        h0 = _mm_add_epi16(_mm_castps_si128(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(2, 0, 2, 0))),
+                           _mm_castps_si128(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(3, 1, 3, 1))));
+        h1 = _mm_add_epi16(_mm_castps_si128(_mm_shuffle_ps(f2, f3, _MM_SHUFFLE(2, 0, 2, 0))),
+                           _mm_castps_si128(_mm_shuffle_ps(f2, f3, _MM_SHUFFLE(3, 1, 3, 1))));
+
+      } else {
+        h0 = _mm_packs_epi32(_mm_madd_epi16(s0, ones), _mm_madd_epi16(s1, ones));
+        h1 = _mm_packs_epi32(_mm_madd_epi16(s2, ones), _mm_madd_epi16(s3, ones));
+      }
 
-  *p = encode_sRGB_uchar(result * 0.125f);
-  ++p;
-  ++q;
+      h0 = _mm_srl_epi16(h0, count);
+      h1 = _mm_srl_epi16(h1, count);
+      _mm_storeu_si128((__m128i *)(p + i), _mm_packus_epi16(h0, h1));
+    }
+  }
+#endif  // TEXTURE_FILTER_SSE2
+
+  for (; i < num_values; i += nc) {
+    size_t o = i * 2;
+    for (int c = 0; c < nc; ++c) {
+      unsigned int result = 0;
+      for (int r = 0; r < num_q; ++r) {
+        result += (unsigned int)q[r][o + c] + (unsigned int)q[r][o + c + step];
+      }
+      p[i + c] = (unsigned char)(result >> shift);
+    }
+  }
 }
 
 /**
- * Averages a 2x2x2 block of pixel components into a single pixel component,
- * for producing the next mipmap level.  Increments p and q to the next
- * component.
+ * Fills in one row of a mipmap level of an sRGB texture, averaging each 2x2
+ * (or 2x2x2) block of the source pixels into a single pixel.  The color
+ * components are averaged in linear space.
  */
 void Texture::
-filter_3d_unsigned_byte_srgb_sse2(unsigned char *&p, const unsigned char *&q,
-                                  size_t pixel_size, size_t row_size, size_t page_size) {
-  float result = (decode_sRGB_float(q[0]) +
-                  decode_sRGB_float(q[pixel_size]) +
-                  decode_sRGB_float(q[row_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size]) +
-                  decode_sRGB_float(q[page_size]) +
-                  decode_sRGB_float(q[pixel_size + page_size]) +
-                  decode_sRGB_float(q[row_size + page_size]) +
-                  decode_sRGB_float(q[pixel_size + row_size + page_size]));
+filter_row_unsigned_byte_srgb(const MipmapJob &job, unsigned char *p,
+                              const unsigned char *const *q) {
+  int num_q = job._num_q;
+  int shift = (num_q == 4) ? 3 : 2;
+  float scale = (num_q == 4) ? 0.125f : 0.25f;
+  int nc = job._num_components;
+  int num_color_components = job._num_color_components;
+  size_t step = job._pixel_step;
+  size_t num_values = (size_t)job._to_x_size * nc;
 
-  *p = encode_sRGB_uchar_sse2(result * 0.125f);
-  ++p;
-  ++q;
+  for (size_t i = 0; i < num_values; i += nc) {
+    size_t o = i * 2;
+    int c = 0;
+    for (; c < num_color_components; ++c) {
+      float result = decode_sRGB_float(q[0][o + c]);
+      result += decode_sRGB_float(q[0][o + c + step]);
+      for (int r = 1; r < num_q; ++r) {
+        result += decode_sRGB_float(q[r][o + c]);
+        result += decode_sRGB_float(q[r][o + c + step]);
+      }
+      p[i + c] = encode_sRGB_uchar(result * scale);
+    }
+    for (; c < nc; ++c) {
+      // Alpha is always linear.
+      unsigned int result = 0;
+      for (int r = 0; r < num_q; ++r) {
+        result += (unsigned int)q[r][o + c] + (unsigned int)q[r][o + c + step];
+      }
+      p[i + c] = (unsigned char)(result >> shift);
+    }
+  }
 }
 
 /**
- * Averages a 2x2x2 block of pixel components into a single pixel component,
- * for producing the next mipmap level.  Increments p and q to the next
- * component.
+ * Fills in one row of a mipmap level of an sRGB texture, averaging each 2x2
+ * (or 2x2x2) block of the source pixels into a single pixel.  The color
+ * components are averaged in linear space.
  */
 void Texture::
-filter_3d_unsigned_short(unsigned char *&p, const unsigned char *&q,
-                         size_t pixel_size, size_t row_size,
-                         size_t page_size) {
-  unsigned int result = ((unsigned int)*(unsigned short *)&q[0] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size] +
-                         (unsigned int)*(unsigned short *)&q[row_size] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size + row_size] +
-                         (unsigned int)*(unsigned short *)&q[page_size] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size + page_size] +
-                         (unsigned int)*(unsigned short *)&q[row_size + page_size] +
-                         (unsigned int)*(unsigned short *)&q[pixel_size + row_size + page_size]) >> 3;
-  store_unscaled_short(p, result);
-  q += 2;
-}
-
-/**
- * Averages a 2x2x2 block of pixel components into a single pixel component,
- * for producing the next mipmap level.  Increments p and q to the next
- * component.
+filter_row_unsigned_byte_srgb_sse2(const MipmapJob &job, unsigned char *p,
+                                   const unsigned char *const *q) {
+  int num_q = job._num_q;
+  int shift = (num_q == 4) ? 3 : 2;
+  float scale = (num_q == 4) ? 0.125f : 0.25f;
+  int nc = job._num_components;
+  int num_color_components = job._num_color_components;
+  size_t step = job._pixel_step;
+  size_t num_values = (size_t)job._to_x_size * nc;
+
+  for (size_t i = 0; i < num_values; i += nc) {
+    size_t o = i * 2;
+    int c = 0;
+    for (; c < num_color_components; ++c) {
+      float result = decode_sRGB_float(q[0][o + c]);
+      result += decode_sRGB_float(q[0][o + c + step]);
+      for (int r = 1; r < num_q; ++r) {
+        result += decode_sRGB_float(q[r][o + c]);
+        result += decode_sRGB_float(q[r][o + c + step]);
+      }
+      p[i + c] = encode_sRGB_uchar_sse2(result * scale);
+    }
+    for (; c < nc; ++c) {
+      // Alpha is always linear.
+      unsigned int result = 0;
+      for (int r = 0; r < num_q; ++r) {
+        result += (unsigned int)q[r][o + c] + (unsigned int)q[r][o + c + step];
+      }
+      p[i + c] = (unsigned char)(result >> shift);
+    }
+  }
+}
+
+/**
+ * Fills in one row of a mipmap level of an unsigned short texture, averaging
+ * each 2x2 (or 2x2x2) block of the source pixels into a single pixel.
  */
 void Texture::
-filter_3d_float(unsigned char *&p, const unsigned char *&q,
-                size_t pixel_size, size_t row_size, size_t page_size) {
-  *(float *)p = (*(float *)&q[0] +
-                 *(float *)&q[pixel_size] +
-                 *(float *)&q[row_size] +
-                 *(float *)&q[pixel_size + row_size] +
-                 *(float *)&q[page_size] +
-                 *(float *)&q[pixel_size + page_size] +
-                 *(float *)&q[row_size + page_size] +
-                 *(float *)&q[pixel_size + row_size + page_size]) / 8.0f;
-  p += 4;
-  q += 4;
+filter_row_unsigned_short(const MipmapJob &job, unsigned char *p,
+                          const unsigned char *const *q) {
+  int num_q = job._num_q;
+  int shift = (num_q == 4) ? 3 : 2;
+  int nc = job._num_components;
+  size_t step = job._pixel_step / 2;
+  size_t num_values = (size_t)job._to_x_size * nc;
+  size_t i = 0;
+
+  unsigned short *ps = (unsigned short *)p;
+  const unsigned short *qs[4];
+  for (int r = 0; r < num_q; ++r) {
+    qs[r] = (const unsigned short *)q[r];
+  }
+
+#ifdef TEXTURE_FILTER_SSE2
+  if (step == (size_t)nc && (nc == 1 || nc == 2 || nc == 4) &&
+      job._simd_level >= MSL_sse2) {
+#ifdef TEXTURE_FILTER_AVX2
+    if (job._simd_level >= MSL_avx2) {
+      i = filter_values_unsigned_short_avx2(ps, qs, num_q, shift, nc, num_values);
+    } else if (job._simd_level >= MSL_sse41) {
+      i = filter_values_unsigned_short_sse41(ps, qs, num_q, shift, nc, num_values);
+    }
+#endif  // TEXTURE_FILTER_AVX2
+
+    // Produce 8 values at a time from 16 values of each source row.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    for (; i + 8 <= num_values; i += 8) {
+      // First sum the source rows, widening the values to 32 bits.
+      __m128i s0 = zero;
+      __m128i s1 = zero;
+      __m128i s2 = zero;
+      __m128i s3 = zero;
+      for (int r = 0; r < num_q; ++r) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(qs[r] + i * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(qs[r] + i * 2 + 8));
+        s0 = _mm_add_epi32(s0, _mm_unpacklo_epi16(a, zero));
+        s1 = _mm_add_epi32(s1, _mm_unpackhi_epi16(a, zero));
+        s2 = _mm_add_epi32(s2, _mm_unpacklo_epi16(b, zero));
+        s3 = _mm_add_epi32(s3, _mm_unpackhi_epi16(b, zero));
+      }
+
+      // Then add each pair of horizontally adjacent pixels.
+      __m128i h0, h1;
+      if (nc == 4) {
+        h0 = _mm_add_epi32(s0, s1);
+        h1 = _mm_add_epi32(s2, s3);
+
+      } else if (nc == 2) {
+        h0 = _mm_add_epi32(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        h1 = _mm_add_epi32(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+
+      } else {
+        __m128 f0 = _mm_castsi128_ps(s0);
+        __m128 f1 = _mm_castsi128_ps(s1);
+        __m128 f2 = _mm_castsi128_ps(s2);
+        __m128 f3 = _mm_castsi128_ps(s3);
+        h0 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(2, 0, 2, 0))),
+                           _mm_castps_si128(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(3, 1, 3, 1))));
+        h1 = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(f2, f3, _MM_SHUFFLE(2, 0, 2, 0))),
+                           _mm_castps_si128(_mm_shuffle_ps(f2, f3, _MM_SHUFFLE(3, 1, 3, 1))));
+      }
+
+      // SSE2 has no unsigned saturating pack from 32 to 16 bits, so we move
+      // the values into the signed range first, and back again afterwards.
+      h0 = _mm_sub_epi32(_mm_srl_epi32(h0, count), bias32);
+      h1 = _mm_sub_epi32(_mm_srl_epi32(h1, count), bias32);
+      _mm_storeu_si128((__m128i *)(ps + i), _mm_add_epi16(_mm_packs_epi32(h0, h1), bias16));
+    }
+  }
+#endif  // TEXTURE_FILTER_SSE2
+
+  for (; i < num_values; i += nc) {
+    size_t o = i * 2;
+    for (int c = 0; c < nc; ++c) {
+      unsigned int result = 0;
+      for (int r = 0; r < num_q; ++r) {
+        result += (unsigned int)qs[r][o + c] + (unsigned int)qs[r][o + c + step];
+      }
+      ps[i + c] = (unsigned short)(result >> shift);
+    }
+  }
 }
 
 /**
- * Invokes the squish library to compress the RAM image(s).
+ * Fills in one row of a mipmap level of a floating-point texture, averaging
+ * each 2x2 (or 2x2x2) block of the source pixels into a single pixel.
  */
-bool Texture::
-do_squish(CData *cdata, Texture::CompressionMode compression, int squish_flags) {
-#ifdef HAVE_SQUISH
-  if (!do_has_all_ram_mipmap_images(cdata)) {
-    // If we're about to compress the RAM image, we should ensure that we have
-    // all of the mipmap levels first.
-    do_generate_ram_mipmap_images(cdata, false);
+void Texture::
+filter_row_float(const MipmapJob &job, unsigned char *p,
+                 const unsigned char *const *q) {
+  int num_q = job._num_q;
+  float scale = (num_q == 4) ? 0.125f : 0.25f;
+  int nc = job._num_components;
+  size_t step = job._pixel_step / 4;
+  size_t num_values = (size_t)job._to_x_size * nc;
+  size_t i = 0;
+
+  float *pf = (float *)p;
+  const float *qf[4];
+  for (int r = 0; r < num_q; ++r) {
+    qf[r] = (const float *)q[r];
   }
 
-  RamImages compressed_ram_images;
-  compressed_ram_images.reserve(cdata->_ram_images.size());
-  for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage compressed_image;
-    int x_size = do_get_expected_mipmap_x_size(cdata, n);
-    int y_size = do_get_expected_mipmap_y_size(cdata, n);
-    int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-    int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  // Note that the vectorized paths add up the values in the same order as
+  // the scalar path, so that the results are identical.
+#ifdef TEXTURE_FILTER_AVX2
+  if (step == (size_t)nc && (nc == 1 || nc == 4) && job._simd_level >= MSL_avx2) {
+    i = filter_values_float_avx2(pf, qf, num_q, scale, nc, num_values);
+  }
+#endif  // TEXTURE_FILTER_AVX2
 
-    compressed_image._page_size = page_size;
-    compressed_image._image = PTA_uchar::empty_array(page_size * num_pages);
-    for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = compressed_image._image.p() + z * page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * cdata->_ram_images[n]._page_size;
-      unsigned const char *source_page_end = source_page + cdata->_ram_images[n]._page_size;
-      // Convert one 4 x 4 cell at a time.
-      unsigned char *d = dest_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          int mask = 0;
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned const char *s = source_page + (yi * x_size + xi) * cdata->_num_components;
-            if (s < source_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
+#ifdef TEXTURE_FILTER_SSE2
+  const __m128 vscale = _mm_set1_ps(scale);
+  if (job._simd_level < MSL_sse2) {
+    // Leave everything to the scalar loop below.
 
-              case 2:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = s[1];   // a
-                break;
+  } else if (nc == 4) {
+    // Each pixel fills a vector exactly.
+    for (; i < num_values; i += 4) {
+      size_t o = i * 2;
+      __m128 result = _mm_add_ps(_mm_loadu_ps(qf[0] + o), _mm_loadu_ps(qf[0] + o + step));
+      for (int r = 1; r < num_q; ++r) {
+        result = _mm_add_ps(result, _mm_loadu_ps(qf[r] + o));
+        result = _mm_add_ps(result, _mm_loadu_ps(qf[r] + o + step));
+      }
+      _mm_storeu_ps(pf + i, _mm_mul_ps(result, vscale));
+    }
 
-              case 3:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
+  } else if (nc == 1 && step == 1) {
+    // Produce 4 values at a time from 8 values of each source row.
+    for (; i + 4 <= num_values; i += 4) {
+      size_t o = i * 2;
+      __m128 result = _mm_setzero_ps();
+      for (int r = 0; r < num_q; ++r) {
+        __m128 a = _mm_loadu_ps(qf[r] + o);
+        __m128 b = _mm_loadu_ps(qf[r] + o + 4);
+        __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        result = (r == 0) ? _mm_add_ps(even, odd) : _mm_add_ps(_mm_add_ps(result, even), odd);
+      }
+      _mm_storeu_ps(pf + i, _mm_mul_ps(result, vscale));
+    }
+  }
+#endif  // TEXTURE_FILTER_SSE2
 
-              case 4:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = s[3];   // a
-                break;
-              }
-              mask |= (1 << i);
-            }
-            t += 4;
-          }
-          squish::CompressMasked(tb, mask, d, squish_flags);
-          d += cell_size;
-          Thread::consider_yield();
-        }
+  for (; i < num_values; i += nc) {
+    size_t o = i * 2;
+    for (int c = 0; c < nc; ++c) {
+      float result = qf[0][o + c] + qf[0][o + c + step];
+      for (int r = 1; r < num_q; ++r) {
+        result += qf[r][o + c];
+        result += qf[r][o + c + step];
       }
+      pf[i + c] = result * scale;
     }
-    compressed_ram_images.push_back(compressed_image);
   }
-  cdata->_ram_images.swap(compressed_ram_images);
-  cdata->_ram_image_compression = compression;
-  return true;
+}
 
-#else  // HAVE_SQUISH
-  return false;
+/**
+ * Invokes the squish library to compress the indicated chunk of a job.
+ */
+void Texture::
+do_squish(const CompressJob &job, size_t ci) {
+#ifdef HAVE_SQUISH
+  const CompressJob::Chunk &chunk = job._chunks[ci];
+  const RamImage &src_image = job._src_images[chunk._n];
+  const RamImage &dest_image = job._dest_images[chunk._n];
+  int x_size = job._x_sizes[chunk._n];
+  int num_components = job._num_components;
+  int squish_flags = job._squish_flags;
+  int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  int x_blocks = (x_size + 3) >> 2;
+
+  unsigned const char *source_page = src_image._image.p() + chunk._z * src_image._page_size;
+  unsigned const char *source_page_end = source_page + src_image._page_size;
+
+  // Convert one 4 x 4 cell at a time.
+  unsigned char *d = dest_image._image.p() + chunk._z * dest_image._page_size;
+  d += (size_t)chunk._row_begin * x_blocks * cell_size;
+  for (int y = chunk._row_begin * 4; y < chunk._row_end * 4; y += 4) {
+    for (int x = 0; x < x_size; x += 4) {
+      unsigned char tb[16 * 4];
+      int mask = 0;
+      unsigned char *t = tb;
+      for (int i = 0; i < 16; ++i) {
+        int xi = x + i % 4;
+        int yi = y + i / 4;
+        unsigned const char *s = source_page + (yi * x_size + xi) * num_components;
+        if (s < source_page_end) {
+          switch (num_components) {
+          case 1:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 2:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = s[1];   // a
+            break;
 
+          case 3:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 4:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = s[3];   // a
+            break;
+          }
+          mask |= (1 << i);
+        }
+        t += 4;
+      }
+      squish::CompressMasked(tb, mask, d, squish_flags);
+      d += cell_size;
+      Thread::consider_yield();
+    }
+  }
 #endif  // HAVE_SQUISH
 }
 
@@ -10469,6 +11285,8 @@ do_fillin_body(CData *cdata, DatagramIterator &scan, BamReader *manager) {
       return;
     }
 
+    // This is not deferred to a decode thread, since the image is copied
+    // into the real texture by do_fillin_from() before resolve().
     PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
     scan.extract_bytes(image.p(), u_size);
 
@@ -10538,8 +11356,10 @@ do_fillin_rawdata(CData *cdata, DatagramIterator &scan, BamReader *manager) {
       return;
     }
 
+    // This copy may be deferred to a decode thread, which holds its own
+    // reference to the array.
     PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
-    scan.extract_bytes(image.p(), u_size);
+    manager->extract_bytes(image, scan);
 
     cdata->_ram_images[n]._image = image;
   }
@@ -10847,3 +11667,23 @@ operator >> (istream &in, Texture::QualityLevel &tql) {
   tql = Texture::string_quality_level(word);
   return in;
 }
+
+/**
+ *
+ */
+ostream &
+operator << (ostream &out, Texture::MipmapFilter mf) {
+  return out << Texture::format_mipmap_filter(mf);
+}
+
+/**
+ *
+ */
+istream &
+operator >> (istream &in, Texture::MipmapFilter &mf) {
+  string word;
+  in >> word;
+
+  mf = Texture::string_mipmap_filter(word);
+  return in;
+}
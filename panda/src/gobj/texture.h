@@ -229,6 +229,14 @@ PUBLISHED:
     QL_best,
   };
 
+  // These are the filters that generate_ram_mipmap_images() may use to
+  // compute each mipmap level from the one above it.
+  enum MipmapFilter {
+    MF_box,      // Average each 2x2 block of pixels.  Fastest.
+    MF_kaiser,   // Kaiser-windowed sinc.  Sharper, with little ringing.
+    MF_lanczos,  // Lanczos-3 windowed sinc.  Sharpest.
+  };
+
 PUBLISHED:
   explicit Texture(const std::string &name = std::string());
 
@@ -476,6 +484,9 @@ PUBLISHED:
                                           QualityLevel quality_level = QL_default,
                                           GraphicsStateGuardianBase *gsg = nullptr);
   BLOCKING INLINE bool uncompress_ram_image();
+  PT(AsyncFuture) async_compress_ram_image(CompressionMode compression = CM_on,
+                                           QualityLevel quality_level = QL_default,
+                                           GraphicsStateGuardianBase *gsg = nullptr);
 
   INLINE int get_num_ram_mipmap_images() const;
   INLINE bool has_ram_mipmap_image(int n) const;
@@ -621,6 +632,9 @@ PUBLISHED:
   static std::string format_quality_level(QualityLevel tql);
   static QualityLevel string_quality_level(const std::string &str);
 
+  static std::string format_mipmap_filter(MipmapFilter mf);
+  static MipmapFilter string_mipmap_filter(const std::string &str);
+
 public:
   void texture_uploaded();
 
@@ -714,10 +728,21 @@ protected:
                              GraphicsStateGuardianBase *gsg);
   bool do_uncompress_ram_image(CData *cdata);
 
-  static void do_compress_ram_image_bc4(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
-  static void do_compress_ram_image_bc5(const RamImage &src, RamImage &dest,
-                                        int x_size, int y_size, int z_size);
+  class CompressJob;
+  bool do_make_compress_job(CData *cdata, CompressJob &job,
+                            CompressionMode compression,
+                            QualityLevel quality_level,
+                            GraphicsStateGuardianBase *gsg);
+  static void do_run_compress_job(CompressJob *job, bool wait);
+  static void do_compress_chunk(const CompressJob &job, size_t ci);
+  void finish_async_compress(CompressJob &job);
+
+  static void do_compress_ram_image_bc4(const unsigned char *src,
+                                        unsigned char *dest, int x_size,
+                                        int row_begin, int row_end);
+  static void do_compress_ram_image_bc5(const unsigned char *src,
+                                        unsigned char *dest, int x_size,
+                                        int row_begin, int row_end);
   static void do_uncompress_ram_image_bc4(const RamImage &src, RamImage &dest,
                                           int x_size, int y_size, int z_size);
   static void do_uncompress_ram_image_bc5(const RamImage &src, RamImage &dest,
@@ -885,50 +910,30 @@ private:
                                  RamImage &to, const RamImage &from,
                                  int x_size, int y_size, int z_size) const;
 
-  typedef void Filter2DComponent(unsigned char *&p,
-                                 const unsigned char *&q,
-                                 size_t pixel_size, size_t row_size);
-
-  typedef void Filter3DComponent(unsigned char *&p,
-                                 const unsigned char *&q,
-                                 size_t pixel_size, size_t row_size,
-                                 size_t page_size);
-
-  static void filter_2d_unsigned_byte(unsigned char *&p,
-                                      const unsigned char *&q,
-                                      size_t pixel_size, size_t row_size);
-  static void filter_2d_unsigned_byte_srgb(unsigned char *&p,
-                                           const unsigned char *&q,
-                                           size_t pixel_size, size_t row_size);
-  static void filter_2d_unsigned_byte_srgb_sse2(unsigned char *&p,
-                                                const unsigned char *&q,
-                                                size_t pixel_size, size_t row_size);
-  static void filter_2d_unsigned_short(unsigned char *&p,
-                                       const unsigned char *&q,
-                                       size_t pixel_size, size_t row_size);
-  static void filter_2d_float(unsigned char *&p, const unsigned char *&q,
-                              size_t pixel_size, size_t row_size);
-
-  static void filter_3d_unsigned_byte(unsigned char *&p,
-                                      const unsigned char *&q,
-                                      size_t pixel_size, size_t row_size,
-                                      size_t page_size);
-  static void filter_3d_unsigned_byte_srgb(unsigned char *&p,
-                                           const unsigned char *&q,
-                                           size_t pixel_size, size_t row_size,
-                                           size_t page_size);
-  static void filter_3d_unsigned_byte_srgb_sse2(unsigned char *&p,
-                                                const unsigned char *&q,
-                                                size_t pixel_size, size_t row_size,
-                                                size_t page_size);
-  static void filter_3d_unsigned_short(unsigned char *&p,
-                                       const unsigned char *&q,
-                                       size_t pixel_size, size_t row_size,
-                                       size_t page_size);
-  static void filter_3d_float(unsigned char *&p, const unsigned char *&q,
-                              size_t pixel_size, size_t row_size, size_t page_size);
-
-  bool do_squish(CData *cdata, CompressionMode compression, int squish_flags);
+  class MipmapJob;
+  static void do_run_mipmap_job(MipmapJob &job);
+  static void do_filter_mipmap_rows(const MipmapJob &job,
+                                    int row_begin, int row_end);
+  static void do_filter_mipmap_rows_kernel(const MipmapJob &job,
+                                           int row_begin, int row_end);
+
+  typedef void FilterRow(const MipmapJob &job, unsigned char *p,
+                         const unsigned char *const *q);
+
+  static void filter_row_unsigned_byte(const MipmapJob &job, unsigned char *p,
+                                       const unsigned char *const *q);
+  static void filter_row_unsigned_byte_srgb(const MipmapJob &job,
+                                            unsigned char *p,
+                                            const unsigned char *const *q);
+  static void filter_row_unsigned_byte_srgb_sse2(const MipmapJob &job,
+                                                 unsigned char *p,
+                                                 const unsigned char *const *q);
+  static void filter_row_unsigned_short(const MipmapJob &job, unsigned char *p,
+                                        const unsigned char *const *q);
+  static void filter_row_float(const MipmapJob &job, unsigned char *p,
+                               const unsigned char *const *q);
+
+  static void do_squish(const CompressJob &job, size_t ci);
   bool do_unsquish(CData *cdata, int squish_flags);
 
 protected:
@@ -1129,6 +1134,7 @@ private:
 };
 
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<Texture::QualityLevel> texture_quality_level;
+extern EXPCL_PANDA_GOBJ ConfigVariableEnum<Texture::MipmapFilter> texture_mipmap_filter;
 
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::TextureType tt);
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::ComponentType ct);
@@ -1137,6 +1143,8 @@ EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::Format f
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::CompressionMode cm);
 EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::QualityLevel tql);
 EXPCL_PANDA_GOBJ std::istream &operator >> (std::istream &in, Texture::QualityLevel &tql);
+EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, Texture::MipmapFilter mf);
+EXPCL_PANDA_GOBJ std::istream &operator >> (std::istream &in, Texture::MipmapFilter &mf);
 
 #include "texture.I"
 
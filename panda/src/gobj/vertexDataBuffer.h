@@ -19,6 +19,7 @@
 #include "vertexDataBlock.h"
 #include "pointerTo.h"
 #include "virtualFile.h"
+#include "mappedFile.h"
 #include "pStatCollector.h"
 #include "lightMutex.h"
 #include "lightMutexHolder.h"
@@ -27,7 +28,7 @@
  * A block of bytes that stores the actual raw vertex data referenced by a
  * GeomVertexArrayData object.
  *
- * At any point, a buffer may be in any of two states:
+ * At any point, a buffer may be in any of three states:
  *
  * independent - the buffer's memory is resident, and owned by the
  * VertexDataBuffer object itself (in _resident_data).  In this state,
@@ -39,6 +40,11 @@
  * memory is considered read-only.  In this state, _reserved_size will always
  * equal _size.
  *
+ * mapped - the buffer's memory is part of a file that has been mapped into
+ * memory, typically a bam file it was loaded from.  The memory is read-only,
+ * and is copied into independent memory the first time it is modified.  In
+ * this state, _reserved_size will always equal _size.
+ *
  * VertexDataBuffers start out in independent state.  They get moved to paged
  * state when their owning GeomVertexArrayData objects get evicted from the
  * _independent_lru.  They can get moved back to independent state if they are
@@ -68,6 +74,8 @@ public:
   INLINE void clear();
 
   INLINE void page_out(VertexDataBook &book);
+  void set_mapped_data(const MappedFile *mapping, const unsigned char *data,
+                       size_t size);
 
   void swap(VertexDataBuffer &other);
 
@@ -82,6 +90,8 @@ private:
   size_t _size;
   size_t _reserved_size;
   PT(VertexDataBlock) _block;
+  CPT(MappedFile) _mapping;
+  const unsigned char *_mapped_data;
   LightMutex _lock;
 
 public:
@@ -19,12 +19,24 @@
 #include "pStatTimer.h"
 #include "memoryHook.h"
 #include "config_gobj.h"
+#include "configVariableEnum.h"
+#include "string_utils.h"
 #include <algorithm>
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using std::string;
+
 ConfigVariableInt max_resident_vertex_data
 ("max-resident-vertex-data", -1,
  PRC_DESC("Specifies the maximum number of bytes of all vertex data "
@@ -41,11 +53,34 @@ ConfigVariableInt max_compressed_vertex_data
           "the least-recently-used ones will be temporarily flushed to "
           "disk until they are needed.  Set it to -1 for no limit."));
 
+// The default codec is the fastest one that was compiled in.
+#if defined(HAVE_LZ4)
+#define DEFAULT_VERTEX_DATA_CODEC VertexDataPage::CC_lz4
+#elif defined(HAVE_ZSTD)
+#define DEFAULT_VERTEX_DATA_CODEC VertexDataPage::CC_zstd
+#elif defined(HAVE_ZLIB)
+#define DEFAULT_VERTEX_DATA_CODEC VertexDataPage::CC_zlib
+#else
+#define DEFAULT_VERTEX_DATA_CODEC VertexDataPage::CC_none
+#endif
+
+ConfigVariableEnum<VertexDataPage::CompressionCodec> vertex_data_compression
+("vertex-data-compression", DEFAULT_VERTEX_DATA_CODEC,
+ PRC_DESC("Specifies the algorithm used to compress vertex data pages that "
+          "are evicted from max-resident-vertex-data.  This may be one of "
+          "\"lz4\", \"zstd\", \"zlib\", or \"none\".  lz4 is by far the "
+          "fastest to decompress, which matters because pages are expanded "
+          "on demand when they are rendered again.  The default is lz4 if "
+          "it was compiled in, otherwise zstd, otherwise zlib.  If the "
+          "requested library was not compiled in, zlib is used instead."));
+
 ConfigVariableInt vertex_data_compression_level
 ("vertex-data-compression-level", 1,
- PRC_DESC("Specifies the zlib compression level to use when compressing "
-          "vertex data.  The number should be in the range 1 to 9, where "
-          "larger values are slower but give better compression."));
+ PRC_DESC("Specifies the compression level to use when compressing "
+          "vertex data.  For zlib, the number should be in the range 1 to 9, "
+          "where larger values are slower but give better compression.  For "
+          "zstd, it is passed through as the zstd compression level.  It is "
+          "ignored by lz4."));
 
 ConfigVariableInt max_disk_vertex_data
 ("max-disk-vertex-data", -1,
@@ -83,6 +118,14 @@ PStatCollector VertexDataPage::_vdata_restore_pcollector("*:Vertex Data:Restore"
 PStatCollector VertexDataPage::_thread_wait_pcollector("Wait:Idle");
 PStatCollector VertexDataPage::_alloc_pages_pcollector("System memory:MMap:Vertex data");
 
+PStatCollector VertexDataPage::_ram_class_pcollectors[RC_end_of_list] = {
+  PStatCollector("Vertex data:Resident"),
+  PStatCollector("Vertex data:Compressed"),
+  PStatCollector("Vertex data:Disk"),
+};
+
+AtomicAdjust::Integer VertexDataPage::_num_evicted_pages = 0;
+
 TypeHandle VertexDataPage::_type_handle;
 TypeHandle VertexDataPage::DeflatePage::_type_handle;
 
@@ -116,6 +159,9 @@ VertexDataPage(size_t book_size) :
   _uncompressed_size = 0;
   _ram_class = RC_resident;
   _pending_ram_class = RC_resident;
+  _codec = CC_none;
+  _compressed_size = 0;
+  _counted_size = 0;
 }
 
 /**
@@ -134,6 +180,10 @@ VertexDataPage(VertexDataBook *book, size_t page_size, size_t block_size) :
   _size = page_size;
 
   _uncompressed_size = _size;
+  _codec = CC_none;
+  _compressed_size = 0;
+  _counted_size = 0;
+  _ram_class = RC_resident;
   _pending_ram_class = RC_resident;
   set_ram_class(RC_resident);
 }
@@ -160,6 +210,11 @@ VertexDataPage::
     _size = 0;
   }
 
+  _ram_class_pcollectors[_ram_class].sub_level_now(_counted_size);
+  if (_ram_class != RC_resident) {
+    AtomicAdjust::dec(_num_evicted_pages);
+  }
+
   nassertv(_book == nullptr);
 }
 
@@ -207,6 +262,107 @@ flush_threads() {
   }
 }
 
+/**
+ * Returns true if support for the indicated compression codec was compiled
+ * in, false otherwise.  CC_none is always available.
+ */
+bool VertexDataPage::
+has_codec(CompressionCodec codec) {
+  switch (codec) {
+  case CC_none:
+    return true;
+
+  case CC_zlib:
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+
+  case CC_lz4:
+#ifdef HAVE_LZ4
+    return true;
+#else
+    return false;
+#endif
+
+  case CC_zstd:
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  return false;
+}
+
+/**
+ * Returns the codec that will be used to compress pages that are moved to
+ * RC_compressed.  This is the codec named by vertex-data-compression, or the
+ * nearest available substitute if that codec was not compiled in.
+ */
+VertexDataPage::CompressionCodec VertexDataPage::
+get_compression_codec() {
+  CompressionCodec codec = vertex_data_compression;
+  if (has_codec(codec)) {
+    return codec;
+  }
+
+  // This may be called from several threads at once, but we only want to
+  // warn once.
+  static AtomicAdjust::Integer warned = 0;
+  CompressionCodec fallback = has_codec(CC_zlib) ? CC_zlib : CC_none;
+  if (AtomicAdjust::set(warned, 1) == 0) {
+    gobj_cat.warning()
+      << "vertex-data-compression " << codec
+      << " is not available in this build; using " << fallback
+      << " instead.\n";
+  }
+  return fallback;
+}
+
+/**
+ * Returns the string representation of the indicated CompressionCodec
+ * value.
+ */
+string VertexDataPage::
+format_codec(CompressionCodec codec) {
+  switch (codec) {
+  case CC_none:
+    return "none";
+  case CC_zlib:
+    return "zlib";
+  case CC_lz4:
+    return "lz4";
+  case CC_zstd:
+    return "zstd";
+  }
+
+  return "**invalid**";
+}
+
+/**
+ * Returns the CompressionCodec value associated with the given string
+ * representation.
+ */
+VertexDataPage::CompressionCodec VertexDataPage::
+string_codec(const string &str) {
+  if (cmp_nocase(str, "none") == 0) {
+    return CC_none;
+  } else if (cmp_nocase(str, "zlib") == 0) {
+    return CC_zlib;
+  } else if (cmp_nocase(str, "lz4") == 0) {
+    return CC_lz4;
+  } else if (cmp_nocase(str, "zstd") == 0) {
+    return CC_zstd;
+  }
+
+  gobj_cat->error()
+    << "Invalid VertexDataPage::CompressionCodec value: " << str << "\n";
+  return CC_zlib;
+}
+
 /**
  *
  */
@@ -348,76 +504,48 @@ make_resident() {
   }
 
   if (_ram_class == RC_compressed) {
-#ifdef HAVE_ZLIB
-    PStatTimer timer(_vdata_decompress_pcollector);
+    if (_codec != CC_none) {
+      PStatTimer timer(_vdata_decompress_pcollector);
 
-    if (gobj_cat.is_debug()) {
-      gobj_cat.debug()
-        << "Expanding page from " << _size
-        << " to " << _uncompressed_size << "\n";
-    }
-    size_t new_allocated_size = round_up(_uncompressed_size);
-    unsigned char *new_data = alloc_page_data(new_allocated_size);
-    unsigned char *end_data = new_data + new_allocated_size;
+      if (gobj_cat.is_debug()) {
+        gobj_cat.debug()
+          << "Expanding page from " << _compressed_size
+          << " to " << _uncompressed_size << " (" << _codec << ")\n";
+      }
+      size_t new_allocated_size = round_up(_uncompressed_size);
+      unsigned char *new_data = alloc_page_data(new_allocated_size);
 
-    z_stream z_source;
-#ifdef USE_MEMORY_NOWRAPPERS
-    z_source.zalloc = Z_NULL;
-    z_source.zfree = Z_NULL;
-#else
-    z_source.zalloc = (alloc_func)&do_zlib_alloc;
-    z_source.zfree = (free_func)&do_zlib_free;
-#endif
+      bool success = false;
+      switch (_codec) {
+      case CC_zlib:
+        success = decompress_zlib(new_data, new_allocated_size);
+        break;
 
-    z_source.opaque = Z_NULL;
-    z_source.msg = (char *) "no error message";
+      case CC_lz4:
+        success = decompress_lz4(new_data, new_allocated_size);
+        break;
 
-    z_source.next_in = (Bytef *)(char *)_page_data;
-    z_source.avail_in = _size;
-    z_source.next_out = (Bytef *)new_data;
-    z_source.avail_out = new_allocated_size;
+      case CC_zstd:
+        success = decompress_zstd(new_data, new_allocated_size);
+        break;
 
-    int result = inflateInit(&z_source);
-    if (result < 0) {
-      nassert_raise("zlib error");
-      return;
-    }
-    Thread::consider_yield();
+      case CC_none:
+        break;
+      }
 
-    size_t output_size = 0;
-
-    int flush = 0;
-    result = 0;
-    while (result != Z_STREAM_END) {
-      unsigned char *start_out = (unsigned char *)z_source.next_out;
-      nassertv(start_out < end_data);
-      z_source.avail_out = std::min((size_t)(end_data - start_out), (size_t)inflate_page_size);
-      nassertv(z_source.avail_out != 0);
-      result = inflate(&z_source, flush);
-      if (result < 0 && result != Z_BUF_ERROR) {
-        nassert_raise("zlib error");
+      if (!success) {
+        free_page_data(new_data, new_allocated_size);
+        nassert_raise("vertex data decompression error");
         return;
       }
-      size_t bytes_produced = (size_t)((unsigned char *)z_source.next_out - start_out);
-      output_size += bytes_produced;
-      if (bytes_produced == 0) {
-        // If we ever produce no bytes, then start flushing the output.
-        flush = Z_FINISH;
-      }
 
-      Thread::consider_yield();
+      free_page_data(_page_data, _allocated_size);
+      _page_data = new_data;
+      _allocated_size = new_allocated_size;
+      _codec = CC_none;
+      _compressed_size = 0;
     }
-    nassertv(z_source.avail_in == 0);
-    nassertv(output_size == _uncompressed_size);
-
-    result = inflateEnd(&z_source);
-    nassertv(result == Z_OK);
-
-    free_page_data(_page_data, _allocated_size);
-    _page_data = new_data;
     _size = _uncompressed_size;
-    _allocated_size = new_allocated_size;
-#endif
 
     set_lru_size(_size);
     set_ram_class(RC_resident);
@@ -445,106 +573,55 @@ make_compressed() {
   if (_ram_class == RC_resident) {
     nassertv(_size == _uncompressed_size);
 
-#ifdef HAVE_ZLIB
-    PStatTimer timer(_vdata_compress_pcollector);
+    CompressionCodec codec = get_compression_codec();
+    if (codec != CC_none) {
+      PStatTimer timer(_vdata_compress_pcollector);
 
-    DeflatePage *page = new DeflatePage;
-    DeflatePage *head = page;
+      unsigned char *new_data = nullptr;
+      size_t new_allocated_size = 0;
+      size_t output_size = 0;
 
-    z_stream z_dest;
-#ifdef USE_MEMORY_NOWRAPPERS
-    z_dest.zalloc = Z_NULL;
-    z_dest.zfree = Z_NULL;
-#else
-    z_dest.zalloc = (alloc_func)&do_zlib_alloc;
-    z_dest.zfree = (free_func)&do_zlib_free;
-#endif
+      bool success = false;
+      switch (codec) {
+      case CC_zlib:
+        success = compress_zlib(new_data, new_allocated_size, output_size);
+        break;
 
-    z_dest.opaque = Z_NULL;
-    z_dest.msg = (char *) "no error message";
+      case CC_lz4:
+        success = compress_lz4(new_data, new_allocated_size, output_size);
+        break;
 
-    int result = deflateInit(&z_dest, vertex_data_compression_level);
-    if (result < 0) {
-      nassert_raise("zlib error");
-      return;
-    }
-    Thread::consider_yield();
+      case CC_zstd:
+        success = compress_zstd(new_data, new_allocated_size, output_size);
+        break;
 
-    z_dest.next_in = (Bytef *)(char *)_page_data;
-    z_dest.avail_in = _uncompressed_size;
-    size_t output_size = 0;
-
-    // Compress the data into one or more individual pages.  We have to
-    // compress it page-at-a-time, since we're not really sure how big the
-    // result will be (so we can't easily pre-allocate a buffer).
-    int flush = 0;
-    result = 0;
-    while (result != Z_STREAM_END) {
-      unsigned char *start_out = (page->_buffer + page->_used_size);
-      z_dest.next_out = (Bytef *)start_out;
-      z_dest.avail_out = (size_t)deflate_page_size - page->_used_size;
-      if (z_dest.avail_out == 0) {
-        DeflatePage *new_page = new DeflatePage;
-        page->_next = new_page;
-        page = new_page;
-        start_out = page->_buffer;
-        z_dest.next_out = (Bytef *)start_out;
-        z_dest.avail_out = deflate_page_size;
+      case CC_none:
+        break;
       }
 
-      result = deflate(&z_dest, flush);
-      if (result < 0 && result != Z_BUF_ERROR) {
-        nassert_raise("zlib error");
-        return;
+      if (success && output_size < _uncompressed_size) {
+        // Now free the original, uncompressed data, and put this new
+        // compressed buffer in its place.
+        free_page_data(_page_data, _allocated_size);
+        _page_data = new_data;
+        _size = output_size;
+        _allocated_size = new_allocated_size;
+        _codec = codec;
+        _compressed_size = output_size;
+
+        if (gobj_cat.is_debug()) {
+          gobj_cat.debug()
+            << "Compressed page from " << _uncompressed_size
+            << " to " << _size << " (" << _codec << ")\n";
+        }
+
+      } else if (new_data != nullptr) {
+        // The data didn't get any smaller.  Keep it as it is; it still
+        // counts against the compressed LRU, but there's nothing to expand
+        // later.
+        free_page_data(new_data, new_allocated_size);
       }
-      size_t bytes_produced = (size_t)((unsigned char *)z_dest.next_out - start_out);
-      page->_used_size += bytes_produced;
-      nassertv(page->_used_size <= deflate_page_size);
-      output_size += bytes_produced;
-      if (bytes_produced == 0) {
-        // If we ever produce no bytes, then start flushing the output.
-        flush = Z_FINISH;
-      }
-
-      Thread::consider_yield();
-    }
-    nassertv(z_dest.avail_in == 0);
-
-    result = deflateEnd(&z_dest);
-    nassertv(result == Z_OK);
-
-    // Now we know how big the result will be.  Allocate a buffer, and copy
-    // the data from the various pages.
-
-    size_t new_allocated_size = round_up(output_size);
-    unsigned char *new_data = alloc_page_data(new_allocated_size);
-
-    size_t copied_size = 0;
-    unsigned char *p = new_data;
-    page = head;
-    while (page != nullptr) {
-      memcpy(p, page->_buffer, page->_used_size);
-      copied_size += page->_used_size;
-      p += page->_used_size;
-      DeflatePage *next = page->_next;
-      delete page;
-      page = next;
-    }
-    nassertv(copied_size == output_size);
-
-    // Now free the original, uncompressed data, and put this new compressed
-    // buffer in its place.
-    free_page_data(_page_data, _allocated_size);
-    _page_data = new_data;
-    _size = output_size;
-    _allocated_size = new_allocated_size;
-
-    if (gobj_cat.is_debug()) {
-      gobj_cat.debug()
-        << "Compressed " << *this << " from " << _uncompressed_size
-        << " to " << _size << "\n";
     }
-#endif
     set_lru_size(_size);
     set_ram_class(RC_compressed);
   }
@@ -580,6 +657,265 @@ make_disk() {
   }
 }
 
+/**
+ * Compresses the page data with zlib into a newly-allocated buffer.  Returns
+ * true on success, filling in the new buffer, its allocated size, and the
+ * number of bytes of compressed data.  Assumes the lock is already held.
+ */
+bool VertexDataPage::
+compress_zlib(unsigned char *&new_data, size_t &new_allocated_size,
+              size_t &output_size) {
+#ifdef HAVE_ZLIB
+  DeflatePage *page = new DeflatePage;
+  DeflatePage *head = page;
+
+  z_stream z_dest;
+#ifdef USE_MEMORY_NOWRAPPERS
+  z_dest.zalloc = Z_NULL;
+  z_dest.zfree = Z_NULL;
+#else
+  z_dest.zalloc = (alloc_func)&do_zlib_alloc;
+  z_dest.zfree = (free_func)&do_zlib_free;
+#endif
+
+  z_dest.opaque = Z_NULL;
+  z_dest.msg = (char *) "no error message";
+
+  int result = deflateInit(&z_dest, std::max(std::min((int)vertex_data_compression_level, 9), 1));
+  if (result < 0) {
+    delete page;
+    nassert_raise("zlib error");
+    return false;
+  }
+  Thread::consider_yield();
+
+  z_dest.next_in = (Bytef *)(char *)_page_data;
+  z_dest.avail_in = _uncompressed_size;
+  output_size = 0;
+
+  // Compress the data into one or more individual pages.  We have to
+  // compress it page-at-a-time, since we're not really sure how big the
+  // result will be (so we can't easily pre-allocate a buffer).
+  int flush = 0;
+  result = 0;
+  while (result != Z_STREAM_END) {
+    unsigned char *start_out = (page->_buffer + page->_used_size);
+    z_dest.next_out = (Bytef *)start_out;
+    z_dest.avail_out = (size_t)deflate_page_size - page->_used_size;
+    if (z_dest.avail_out == 0) {
+      DeflatePage *new_page = new DeflatePage;
+      page->_next = new_page;
+      page = new_page;
+      start_out = page->_buffer;
+      z_dest.next_out = (Bytef *)start_out;
+      z_dest.avail_out = deflate_page_size;
+    }
+
+    result = deflate(&z_dest, flush);
+    if (result < 0 && result != Z_BUF_ERROR) {
+      nassert_raise("zlib error");
+      break;
+    }
+    size_t bytes_produced = (size_t)((unsigned char *)z_dest.next_out - start_out);
+    page->_used_size += bytes_produced;
+    nassertd(page->_used_size <= deflate_page_size) break;
+    output_size += bytes_produced;
+    if (bytes_produced == 0) {
+      // If we ever produce no bytes, then start flushing the output.
+      flush = Z_FINISH;
+    }
+
+    Thread::consider_yield();
+  }
+  bool success = (result == Z_STREAM_END && z_dest.avail_in == 0);
+  deflateEnd(&z_dest);
+
+  // Now we know how big the result will be.  Allocate a buffer, and copy the
+  // data from the various pages.
+  if (success) {
+    new_allocated_size = round_up(output_size);
+    new_data = alloc_page_data(new_allocated_size);
+  }
+
+  unsigned char *p = new_data;
+  page = head;
+  while (page != nullptr) {
+    if (success) {
+      memcpy(p, page->_buffer, page->_used_size);
+      p += page->_used_size;
+    }
+    DeflatePage *next = page->_next;
+    delete page;
+    page = next;
+  }
+
+  return success;
+#else
+  return false;
+#endif  // HAVE_ZLIB
+}
+
+/**
+ * Compresses the page data with LZ4 into a newly-allocated buffer.  See
+ * compress_zlib().
+ */
+bool VertexDataPage::
+compress_lz4(unsigned char *&new_data, size_t &new_allocated_size,
+             size_t &output_size) {
+#ifdef HAVE_LZ4
+  int bound = LZ4_compressBound((int)_uncompressed_size);
+  if (bound <= 0) {
+    return false;
+  }
+
+  // We don't know how big the result will be until we have compressed it, so
+  // compress into a scratch buffer first, and then copy it into a page
+  // buffer of the right size.
+  char *buffer = (char *)PANDA_MALLOC_ARRAY(bound);
+  int result = LZ4_compress_default((const char *)_page_data, buffer,
+                                    (int)_uncompressed_size, bound);
+  Thread::consider_yield();
+  if (result <= 0) {
+    PANDA_FREE_ARRAY(buffer);
+    return false;
+  }
+
+  output_size = (size_t)result;
+  new_allocated_size = round_up(output_size);
+  new_data = alloc_page_data(new_allocated_size);
+  memcpy(new_data, buffer, output_size);
+  PANDA_FREE_ARRAY(buffer);
+  return true;
+#else
+  return false;
+#endif  // HAVE_LZ4
+}
+
+/**
+ * Compresses the page data with Zstandard into a newly-allocated buffer.
+ * See compress_zlib().
+ */
+bool VertexDataPage::
+compress_zstd(unsigned char *&new_data, size_t &new_allocated_size,
+              size_t &output_size) {
+#ifdef HAVE_ZSTD
+  size_t bound = ZSTD_compressBound(_uncompressed_size);
+  unsigned char *buffer = (unsigned char *)PANDA_MALLOC_ARRAY(bound);
+  size_t result = ZSTD_compress(buffer, bound, _page_data, _uncompressed_size,
+                                vertex_data_compression_level);
+  Thread::consider_yield();
+  if (ZSTD_isError(result)) {
+    gobj_cat.error()
+      << "zstd error: " << ZSTD_getErrorName(result) << "\n";
+    PANDA_FREE_ARRAY(buffer);
+    return false;
+  }
+
+  output_size = result;
+  new_allocated_size = round_up(output_size);
+  new_data = alloc_page_data(new_allocated_size);
+  memcpy(new_data, buffer, output_size);
+  PANDA_FREE_ARRAY(buffer);
+  return true;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+/**
+ * Expands the zlib-compressed page data into the indicated buffer, which
+ * must be large enough to hold _uncompressed_size bytes.  Returns true on
+ * success.  Assumes the lock is already held.
+ */
+bool VertexDataPage::
+decompress_zlib(unsigned char *new_data, size_t new_allocated_size) {
+#ifdef HAVE_ZLIB
+  unsigned char *end_data = new_data + new_allocated_size;
+
+  z_stream z_source;
+#ifdef USE_MEMORY_NOWRAPPERS
+  z_source.zalloc = Z_NULL;
+  z_source.zfree = Z_NULL;
+#else
+  z_source.zalloc = (alloc_func)&do_zlib_alloc;
+  z_source.zfree = (free_func)&do_zlib_free;
+#endif
+
+  z_source.opaque = Z_NULL;
+  z_source.msg = (char *) "no error message";
+
+  z_source.next_in = (Bytef *)(char *)_page_data;
+  z_source.avail_in = _compressed_size;
+  z_source.next_out = (Bytef *)new_data;
+  z_source.avail_out = new_allocated_size;
+
+  int result = inflateInit(&z_source);
+  if (result < 0) {
+    return false;
+  }
+  Thread::consider_yield();
+
+  size_t output_size = 0;
+
+  int flush = 0;
+  result = 0;
+  while (result != Z_STREAM_END) {
+    unsigned char *start_out = (unsigned char *)z_source.next_out;
+    if (start_out >= end_data) {
+      break;
+    }
+    z_source.avail_out = std::min((size_t)(end_data - start_out), (size_t)inflate_page_size);
+    result = inflate(&z_source, flush);
+    if (result < 0 && result != Z_BUF_ERROR) {
+      break;
+    }
+    size_t bytes_produced = (size_t)((unsigned char *)z_source.next_out - start_out);
+    output_size += bytes_produced;
+    if (bytes_produced == 0) {
+      // If we ever produce no bytes, then start flushing the output.
+      flush = Z_FINISH;
+    }
+
+    Thread::consider_yield();
+  }
+  bool success = (result == Z_STREAM_END && output_size == _uncompressed_size);
+  inflateEnd(&z_source);
+  return success;
+#else
+  return false;
+#endif  // HAVE_ZLIB
+}
+
+/**
+ * Expands the LZ4-compressed page data into the indicated buffer.  See
+ * decompress_zlib().
+ */
+bool VertexDataPage::
+decompress_lz4(unsigned char *new_data, size_t new_allocated_size) {
+#ifdef HAVE_LZ4
+  int result = LZ4_decompress_safe((const char *)_page_data, (char *)new_data,
+                                   (int)_compressed_size, (int)new_allocated_size);
+  return (result >= 0 && (size_t)result == _uncompressed_size);
+#else
+  return false;
+#endif  // HAVE_LZ4
+}
+
+/**
+ * Expands the Zstandard-compressed page data into the indicated buffer.  See
+ * decompress_zlib().
+ */
+bool VertexDataPage::
+decompress_zstd(unsigned char *new_data, size_t new_allocated_size) {
+#ifdef HAVE_ZSTD
+  size_t result = ZSTD_decompress(new_data, new_allocated_size,
+                                  _page_data, _compressed_size);
+  return (!ZSTD_isError(result) && result == _uncompressed_size);
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
 /**
  * Writes the page to disk, but does not evict it from memory or affect its
  * LRU status.  If it gets evicted later without having been modified, it will
@@ -648,15 +984,48 @@ do_restore_from_disk() {
     _size = buffer_size;
     _allocated_size = new_allocated_size;
 
-    set_lru_size(_size);
     if (_saved_block->get_compressed()) {
+      if (_codec != CC_none) {
+        _size = _compressed_size;
+      }
+      set_lru_size(_size);
       set_ram_class(RC_compressed);
     } else {
+      set_lru_size(_size);
       set_ram_class(RC_resident);
     }
   }
 }
 
+/**
+ * Puts the data in a new ram class.  Assumes the page lock is already held.
+ */
+void VertexDataPage::
+set_ram_class(RamClass rclass) {
+  if (_ram_class == RC_resident && rclass != RC_resident) {
+    AtomicAdjust::inc(_num_evicted_pages);
+  } else if (_ram_class != RC_resident && rclass == RC_resident) {
+    AtomicAdjust::dec(_num_evicted_pages);
+  }
+
+  // Move our bytes from the old class's PStats level to the new one.  A page
+  // on disk is counted by the size of its block in the save file.
+  _ram_class_pcollectors[_ram_class].sub_level_now(_counted_size);
+  if (rclass == RC_disk) {
+    _counted_size = (_saved_block != nullptr) ? _saved_block->get_size() : 0;
+  } else {
+    _counted_size = _size;
+  }
+  _ram_class_pcollectors[rclass].add_level_now(_counted_size);
+
+  _ram_class = rclass;
+  mark_used_lru(_global_lru[rclass]);
+
+  // Changing the ram class might make our effective available space 0 and
+  // thereby change the placement within the book.
+  adjust_book_size();
+}
+
 /**
  * Called when the "book size"--the size of the page as recorded in its book's
  * table--has changed for some reason.  Assumes the lock is held.
@@ -986,3 +1355,23 @@ thread_main() {
     Thread::consider_yield();
   }
 }
+
+/**
+ *
+ */
+std::ostream &
+operator << (std::ostream &out, VertexDataPage::CompressionCodec codec) {
+  return out << VertexDataPage::format_codec(codec);
+}
+
+/**
+ *
+ */
+std::istream &
+operator >> (std::istream &in, VertexDataPage::CompressionCodec &codec) {
+  string word;
+  in >> word;
+
+  codec = VertexDataPage::string_codec(word);
+  return in;
+}
@@ -24,6 +24,7 @@
 #include "thread.h"
 #include "mutexHolder.h"
 #include "pdeque.h"
+#include "atomicAdjust.h"
 
 class VertexDataBook;
 class VertexDataBlock;
@@ -51,8 +52,18 @@ PUBLISHED:
     RC_end_of_list,  // list marker; do not use
   };
 
+  // These are the algorithms that may be used to compress a page when it is
+  // moved to RC_compressed.
+  enum CompressionCodec {
+    CC_none,
+    CC_zlib,
+    CC_lz4,
+    CC_zstd,
+  };
+
   INLINE RamClass get_ram_class() const;
   INLINE RamClass get_pending_ram_class() const;
+  INLINE CompressionCodec get_codec() const;
   INLINE void request_resident();
 
   INLINE VertexDataBlock *alloc(size_t size);
@@ -73,11 +84,17 @@ PUBLISHED:
   static void stop_threads();
   static void flush_threads();
 
+  static bool has_codec(CompressionCodec codec);
+  static CompressionCodec get_compression_codec();
+  static std::string format_codec(CompressionCodec codec);
+  static CompressionCodec string_codec(const std::string &str);
+
   virtual void output(std::ostream &out) const;
   virtual void write(std::ostream &out, int indent_level) const;
 
 public:
   INLINE unsigned char *get_page_data(bool force);
+  INLINE static bool has_evicted_pages();
   INLINE bool operator < (const VertexDataPage &other) const;
 
 protected:
@@ -95,13 +112,23 @@ private:
   void make_compressed();
   void make_disk();
 
+  bool compress_zlib(unsigned char *&new_data, size_t &new_allocated_size,
+                     size_t &output_size);
+  bool compress_lz4(unsigned char *&new_data, size_t &new_allocated_size,
+                    size_t &output_size);
+  bool compress_zstd(unsigned char *&new_data, size_t &new_allocated_size,
+                     size_t &output_size);
+  bool decompress_zlib(unsigned char *new_data, size_t new_allocated_size);
+  bool decompress_lz4(unsigned char *new_data, size_t new_allocated_size);
+  bool decompress_zstd(unsigned char *new_data, size_t new_allocated_size);
+
   bool do_save_to_disk();
   void do_restore_from_disk();
 
   void adjust_book_size();
 
   void request_ram_class(RamClass ram_class);
-  INLINE void set_ram_class(RamClass ram_class);
+  void set_ram_class(RamClass ram_class);
   static void make_save_file();
 
   INLINE size_t round_up(size_t page_size) const;
@@ -158,6 +185,15 @@ private:
   unsigned char *_page_data;
   size_t _size, _allocated_size, _uncompressed_size;
   RamClass _ram_class;
+
+  // The codec and exact size of the compressed data, which are remembered
+  // while the page is on disk.
+  CompressionCodec _codec;
+  size_t _compressed_size;
+
+  // The number of bytes this page currently contributes to the PStats level
+  // of its ram class.
+  size_t _counted_size;
   PT(VertexDataSaveBlock) _saved_block;
   size_t _book_size;
   size_t _block_size;
@@ -211,6 +247,10 @@ private:
   static PStatCollector _vdata_restore_pcollector;
   static PStatCollector _thread_wait_pcollector;
   static PStatCollector _alloc_pages_pcollector;
+  static PStatCollector _ram_class_pcollectors[RC_end_of_list];
+
+  // The number of pages that are not currently in RC_resident.
+  static AtomicAdjust::Integer _num_evicted_pages;
 
 public:
   static TypeHandle get_class_type() {
@@ -232,6 +272,9 @@ inline std::ostream &operator << (std::ostream &out, const VertexDataPage &page)
   return out;
 }
 
+EXPCL_PANDA_GOBJ std::ostream &operator << (std::ostream &out, VertexDataPage::CompressionCodec codec);
+EXPCL_PANDA_GOBJ std::istream &operator >> (std::istream &in, VertexDataPage::CompressionCodec &codec);
+
 #include "vertexDataPage.I"
 
 #endif
@@ -0,0 +1,47 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bufferedCullHandler.cxx
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#include "bufferedCullHandler.h"
+#include "cullableObject.h"
+
+/**
+ * Deletes any objects that were recorded but never flushed.
+ */
+BufferedCullHandler::
+~BufferedCullHandler() {
+  for (CullableObject *object : _objects) {
+    delete object;
+  }
+}
+
+/**
+ * Holds on to the indicated object until the next call to flush().
+ */
+void BufferedCullHandler::
+record_object(CullableObject *object, const CullTraverser *) {
+  _objects.push_back(object);
+}
+
+/**
+ * Passes all of the recorded objects on to the indicated CullHandler, in the
+ * order in which they were recorded, as if they had been discovered by the
+ * indicated traverser.  Ownership of the objects is transferred to the
+ * handler, and this object is emptied.
+ */
+void BufferedCullHandler::
+flush(CullHandler *handler, const CullTraverser *traverser) {
+  for (CullableObject *object : _objects) {
+    handler->record_object(object, traverser);
+  }
+  _objects.clear();
+}
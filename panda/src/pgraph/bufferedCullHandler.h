@@ -0,0 +1,49 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bufferedCullHandler.h
+ * @author agent
+ * @date 2026-10-18
+ */
+
+#ifndef BUFFEREDCULLHANDLER_H
+#define BUFFEREDCULLHANDLER_H
+
+#include "pandabase.h"
+#include "cullHandler.h"
+#include "pvector.h"
+
+/**
+ * A CullHandler that simply holds on to the objects it is given, so that they
+ * may be passed on to another CullHandler at a later time, in the same order
+ * in which they were recorded.
+ *
+ * This is used by the CullTraverser when parts of the scene graph are
+ * traversed in parallel, so that the objects found by each thread can be
+ * handed to the real CullHandler in the same order as in a serial traversal.
+ */
+class EXPCL_PANDA_PGRAPH BufferedCullHandler : public CullHandler {
+public:
+  INLINE BufferedCullHandler();
+  BufferedCullHandler(const BufferedCullHandler &copy) = delete;
+  virtual ~BufferedCullHandler();
+
+  virtual void record_object(CullableObject *object,
+                             const CullTraverser *traverser);
+
+  INLINE size_t get_num_objects() const;
+  void flush(CullHandler *handler, const CullTraverser *traverser);
+
+private:
+  typedef pvector<CullableObject *> Objects;
+  Objects _objects;
+};
+
+#include "bufferedCullHandler.I"
+
+#endif
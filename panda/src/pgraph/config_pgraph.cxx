@@ -132,6 +132,29 @@ ConfigVariableBool debug_portal_cull
           "(You first need to enable portal culling, using the allow-portal-cull"
           "variable.)"));
 
+ConfigVariableInt cull_num_threads
+("cull-num-threads", 0,
+ PRC_DESC("Set this to a positive number to allow the CullTraverser to "
+          "distribute the children of nodes with many children across this "
+          "many worker threads, in addition to the thread doing the cull.  "
+          "The results are merged in the same order as a single-threaded "
+          "traversal would produce.  This requires that any cull callbacks "
+          "in the scene graph are safe to call from multiple threads.  Set "
+          "this to 0 to traverse the scene graph on a single thread."));
+
+ConfigVariableInt cull_parallel_threshold
+("cull-parallel-threshold", 256,
+ PRC_DESC("When cull-num-threads is nonzero, this is the minimum number of "
+          "children a node must have before its children are distributed "
+          "across the cull worker threads."));
+
+ConfigVariableBool cull_batch_bounds
+("cull-batch-bounds", true,
+ PRC_DESC("Set this true to test the bounding spheres of the children of each "
+          "node against the view frustum several at a time, using SIMD "
+          "instructions where available, before visiting them.  This has no "
+          "effect on the result of the cull traversal."));
+
 ConfigVariableBool show_occluder_volumes
 ("show-occluder-volumes", false,
  PRC_DESC("Set this true to enable debug visualization of the volumes used "
@@ -206,6 +229,31 @@ ConfigVariableDouble garbage_collect_states_rate
           "performance if states accumulate faster than they can be "
           "cleaned up."));
 
+ConfigVariableDouble garbage_collect_states_budget
+("garbage-collect-states-budget", 0.0,
+ PRC_DESC("The maximum amount of time, in seconds, that each call to "
+          "TransformState::garbage_collect(), RenderState::garbage_collect() "
+          "or RenderAttrib::garbage_collect() may spend before returning.  "
+          "Any remaining states are picked up by the next call.  Set this "
+          "to 0 to process garbage-collect-states-rate states regardless of "
+          "how long it takes."));
+
+ConfigVariableInt garbage_collect_states_old_age
+("garbage-collect-states-old-age", 8,
+ PRC_DESC("The number of consecutive garbage collection sweeps a state "
+          "must survive before it is considered long-lived.  Long-lived "
+          "states are examined less often; see "
+          "garbage-collect-old-states-interval."));
+
+ConfigVariableInt garbage_collect_old_states_interval
+("garbage-collect-old-states-interval", 8,
+ PRC_DESC("Long-lived states are only examined by the garbage collector "
+          "once every this many sweeps through the state cache.  Setting "
+          "this to 1 examines all states on every sweep, as older versions "
+          "of Panda did.  Larger values reduce the time spent in the "
+          "garbage collector, at the cost of holding on to states that "
+          "became unused after a long life for a little longer."));
+
 ConfigVariableBool transform_cache
 ("transform-cache", true,
  PRC_DESC("Set this true to enable the cache of TransformState objects.  "
@@ -375,6 +423,15 @@ ConfigVariableBool allow_live_flatten
           "only has an effect when Panda is not compiled for a release "
           "build."));
 
+ConfigVariableInt flatten_num_threads
+("flatten-num-threads", 0,
+ PRC_DESC("Set this to a positive number to allow the SceneGraphReducer to "
+          "flatten independent subtrees of the scene graph, and to unify "
+          "separate GeomNodes, on this many worker threads in addition to "
+          "the thread that requested the flatten.  Only subtrees whose "
+          "nodes are not instanced elsewhere are handed to the workers.  "
+          "Set this to 0 to flatten on a single thread."));
+
 ConfigVariableBool filled_wireframe_apply_shader
 ("filled-wireframe-apply-shader", false,
  PRC_DESC("Set this true to apply any shader configured on nodes onto the "
@@ -34,6 +34,9 @@ extern ConfigVariableBool fake_view_frustum_cull;
 extern ConfigVariableBool clip_plane_cull;
 extern ConfigVariableBool allow_portal_cull;
 extern ConfigVariableBool debug_portal_cull;
+extern ConfigVariableInt cull_num_threads;
+extern ConfigVariableInt cull_parallel_threshold;
+extern ConfigVariableBool cull_batch_bounds;
 extern ConfigVariableBool show_occluder_volumes;
 extern ConfigVariableBool unambiguous_graph;
 extern ConfigVariableBool detect_graph_cycles;
@@ -45,6 +48,9 @@ extern ConfigVariableBool paranoid_const;
 extern ConfigVariableBool auto_break_cycles;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool garbage_collect_states;
 extern ConfigVariableDouble garbage_collect_states_rate;
+extern ConfigVariableDouble garbage_collect_states_budget;
+extern ConfigVariableInt garbage_collect_states_old_age;
+extern ConfigVariableInt garbage_collect_old_states_interval;
 extern ConfigVariableBool transform_cache;
 extern ConfigVariableBool state_cache;
 extern ConfigVariableBool uniquify_transforms;
@@ -73,6 +79,7 @@ extern ConfigVariableList load_file_type;
 extern ConfigVariableString default_model_extension;
 
 extern ConfigVariableBool allow_live_flatten;
+extern ConfigVariableInt flatten_num_threads;
 
 extern ConfigVariableBool filled_wireframe_apply_shader;
 
@@ -34,6 +34,106 @@
 #include "geomLinestrips.h"
 #include "geomLines.h"
 #include "geomVertexWriter.h"
+#include "bufferedCullHandler.h"
+#include "asyncParallelJob.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
+
+/**
+ * A parallel traversal of the children of a single node.  The children are
+ * divided into a number of contiguous ranges, which are the items of the job.
+ * The objects found in each range are kept apart, so that they may be handed
+ * to the CullHandler in the original order afterwards.
+ */
+class CullTraverser::ParallelJob : public AsyncParallelJob {
+public:
+  ParallelJob() : AsyncParallelJob("cull", TP_high) {}
+
+protected:
+  virtual void do_item(int n, Thread *current_thread);
+
+public:
+  CullTraverser *_trav;
+  CullTraverserData *_data;
+  const PandaNode::Children *_children;
+  int _num_children;
+  int _range_size;
+  BufferedCullHandler *_handlers;
+};
+
+/**
+ * The planes of a BoundingHexahedron, rearranged for testing several
+ * bounding spheres at once.  The planes face outwards.
+ */
+struct CullBatchPlanes {
+  alignas(16) float _a[6][4];
+  alignas(16) float _b[6][4];
+  alignas(16) float _c[6][4];
+  alignas(16) float _d[6][4];
+};
+
+/**
+ * Fills in the plane arrays from the indicated frustum.
+ */
+static void
+cull_batch_load_planes(CullBatchPlanes &planes,
+                       const BoundingHexahedron *frustum) {
+  for (int p = 0; p < 6; ++p) {
+    LPlane plane = frustum->get_plane(p);
+    for (int i = 0; i < 4; ++i) {
+      planes._a[p][i] = (float)plane[0];
+      planes._b[p][i] = (float)plane[1];
+      planes._c[p][i] = (float)plane[2];
+      planes._d[p][i] = (float)plane[3];
+    }
+  }
+}
+
+/**
+ * Tests four bounding spheres at once against the frustum planes.  Returns a
+ * bitmask in which bit n is set if sphere n is entirely outside the frustum.
+ * A sphere with a negative radius is never reported as outside.
+ */
+static unsigned int
+cull_batch_spheres(const CullBatchPlanes &planes, const float cx[4],
+                   const float cy[4], const float cz[4], const float r[4]) {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  __m128 x = _mm_loadu_ps(cx);
+  __m128 y = _mm_loadu_ps(cy);
+  __m128 z = _mm_loadu_ps(cz);
+  __m128 radius = _mm_loadu_ps(r);
+  __m128 outside = _mm_setzero_ps();
+  for (int p = 0; p < 6; ++p) {
+    __m128 dist = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, _mm_load_ps(planes._a[p])),
+                 _mm_mul_ps(y, _mm_load_ps(planes._b[p]))),
+      _mm_add_ps(_mm_mul_ps(z, _mm_load_ps(planes._c[p])),
+                 _mm_load_ps(planes._d[p])));
+    outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, radius));
+  }
+  outside = _mm_and_ps(outside, _mm_cmpge_ps(radius, _mm_setzero_ps()));
+  return (unsigned int)_mm_movemask_ps(outside);
+
+#else
+  unsigned int outside = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (r[i] < 0.0f) {
+      continue;
+    }
+    for (int p = 0; p < 6; ++p) {
+      float dist = cx[i] * planes._a[p][i] + cy[i] * planes._b[p][i] +
+                   cz[i] * planes._c[p][i] + planes._d[p][i];
+      if (dist > r[i]) {
+        outside |= (1u << i);
+        break;
+      }
+    }
+  }
+  return outside;
+#endif
+}
 
 PStatCollector CullTraverser::_nodes_pcollector("Nodes");
 PStatCollector CullTraverser::_geom_nodes_pcollector("Nodes:GeomNodes");
@@ -56,6 +156,7 @@ CullTraverser() :
   _cull_handler = nullptr;
   _portal_clipper = nullptr;
   _effective_incomplete_render = true;
+  _parallel_worker = false;
 }
 
 /**
@@ -73,7 +174,8 @@ CullTraverser(const CullTraverser &copy) :
   _view_frustum(copy._view_frustum),
   _cull_handler(copy._cull_handler),
   _portal_clipper(copy._portal_clipper),
-  _effective_incomplete_render(copy._effective_incomplete_render)
+  _effective_incomplete_render(copy._effective_incomplete_render),
+  _parallel_worker(copy._parallel_worker)
 {
 }
 
@@ -200,9 +302,10 @@ traverse_below(CullTraverserData &data) {
   node_reader->release();
   int num_children = children.get_num_children();
   if (!node->has_selective_visibility()) {
-    for (int i = 0; i < num_children; ++i) {
-      CullTraverserData next_data(data, children.get_child(i));
-      do_traverse(next_data);
+    if (can_traverse_parallel(num_children)) {
+      traverse_children_parallel(data, children);
+    } else {
+      traverse_children(data, children, 0, num_children);
     }
   } else {
     int i = node->get_first_visible_child();
@@ -214,6 +317,73 @@ traverse_below(CullTraverserData &data) {
   }
 }
 
+/**
+ * Traverses the children of the indicated node in the range [begin, end).
+ * If cull-batch-bounds is enabled, the bounding spheres of the children are
+ * first tested against the view frustum four at a time, so that children
+ * that are entirely outside of it can be skipped without further ado.
+ */
+void CullTraverser::
+traverse_children(CullTraverserData &data, const PandaNode::Children &children,
+                  int begin, int end) {
+  const BoundingHexahedron *frustum = nullptr;
+  if (cull_batch_bounds && end - begin >= 4 &&
+      data._instances == nullptr && data._view_frustum != nullptr &&
+      data._view_frustum->is_exact_type(BoundingHexahedron::get_class_type()) &&
+      !data._view_frustum->is_empty() && !data._view_frustum->is_infinite() &&
+      !pgraph_cat.is_spam()) {
+#ifndef NDEBUG
+    if (!fake_view_frustum_cull) {
+      frustum = (const BoundingHexahedron *)data._view_frustum.p();
+    }
+#else
+    frustum = (const BoundingHexahedron *)data._view_frustum.p();
+#endif
+  }
+
+  if (frustum == nullptr) {
+    for (int i = begin; i < end; ++i) {
+      CullTraverserData next_data(data, children.get_child(i), _current_thread);
+      do_traverse(next_data);
+    }
+    return;
+  }
+
+  CullBatchPlanes planes;
+  cull_batch_load_planes(planes, frustum);
+
+  for (int i = begin; i < end; i += 4) {
+    int count = std::min(4, end - i);
+    alignas(16) float cx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    alignas(16) float cy[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    alignas(16) float cz[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    alignas(16) float r[4] = {-1.0f, -1.0f, -1.0f, -1.0f};
+
+    for (int j = 0; j < count; ++j) {
+      CPT(BoundingVolume) bounds =
+        children.get_child(i + j)->get_bounds(_current_thread);
+      const BoundingSphere *sphere = bounds->as_bounding_sphere();
+      if (sphere != nullptr && !sphere->is_empty() && !sphere->is_infinite()) {
+        const LPoint3 &center = sphere->get_center();
+        cx[j] = (float)center[0];
+        cy[j] = (float)center[1];
+        cz[j] = (float)center[2];
+        r[j] = (float)sphere->get_radius();
+      }
+    }
+
+    // A child whose bit is set here is entirely outside the frustum, and
+    // would have been rejected by is_in_view() anyway.
+    unsigned int outside = cull_batch_spheres(planes, cx, cy, cz, r);
+    for (int j = 0; j < count; ++j) {
+      if ((outside & (1u << j)) == 0) {
+        CullTraverserData next_data(data, children.get_child(i + j), _current_thread);
+        do_traverse(next_data);
+      }
+    }
+  }
+}
+
 /**
  * Should be called when the traverser has finished traversing its scene, this
  * gives it a chance to do any necessary finalization.
@@ -223,6 +393,74 @@ end_traverse() {
   _cull_handler->end_traverse();
 }
 
+/**
+ * Returns true if the children of a node with the indicated number of
+ * children should be distributed across the cull worker threads.
+ */
+bool CullTraverser::
+can_traverse_parallel(int num_children) const {
+#ifdef HAVE_THREADS
+  // Subclasses may keep additional state that is not copied into the worker
+  // traversers, so we only do this for a plain CullTraverser.
+  return cull_num_threads > 0 && !_parallel_worker &&
+    num_children >= std::max((int)cull_parallel_threshold, 2) &&
+    _portal_clipper == nullptr &&
+    get_type() == CullTraverser::get_class_type();
+#else
+  return false;
+#endif
+}
+
+/**
+ * Traverses all the children of the indicated node, distributing them across
+ * the cull worker threads.  The current thread also takes part.  The objects
+ * found are passed to the CullHandler in the same order as they would be by
+ * traverse_children(), after all threads have finished.
+ */
+void CullTraverser::
+traverse_children_parallel(CullTraverserData &data,
+                           const PandaNode::Children &children) {
+  int num_threads = cull_num_threads;
+  int num_children = children.get_num_children();
+
+  // Make several ranges per thread, so that a thread that happens to get a
+  // cheap range can go on to take another one.
+  int num_ranges = std::min(num_children, (num_threads + 1) * 4);
+
+  ParallelJob job;
+  job._trav = this;
+  job._data = &data;
+  job._children = &children;
+  job._num_children = num_children;
+  job._range_size = (num_children + num_ranges - 1) / num_ranges;
+  num_ranges = (num_children + job._range_size - 1) / job._range_size;
+  job._handlers = new BufferedCullHandler[num_ranges];
+
+  job.run(num_ranges, num_threads);
+
+  for (int i = 0; i < num_ranges; ++i) {
+    job._handlers[i].flush(_cull_handler, this);
+  }
+  delete[] job._handlers;
+}
+
+/**
+ * Traverses the nth range of children.  Called from each thread that takes
+ * part in the job.
+ */
+void CullTraverser::ParallelJob::
+do_item(int n, Thread *current_thread) {
+  CullTraverser trav(*_trav);
+  trav.local_object();
+  trav._current_thread = current_thread;
+  trav._cull_handler = &_handlers[n];
+  trav._parallel_worker = true;
+
+  int begin = n * _range_size;
+  int end = std::min(begin + _range_size, _num_children);
+  trav.traverse_children(*_data, *_children, begin, end);
+}
+
 /**
  * Draws an appropriate visualization of the indicated bounding volume.
  */
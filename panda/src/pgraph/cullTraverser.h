@@ -27,6 +27,7 @@
 #include "typedReferenceCount.h"
 #include "pStatCollector.h"
 #include "fogAttrib.h"
+#include "pandaNode.h"
 
 class GraphicsStateGuardian;
 class PandaNode;
@@ -90,6 +91,9 @@ PUBLISHED:
 
 protected:
   INLINE void do_traverse(CullTraverserData &data);
+  void traverse_children(CullTraverserData &data,
+                         const PandaNode::Children &children,
+                         int begin, int end);
 
   virtual bool is_in_view(CullTraverserData &data);
 
@@ -101,6 +105,13 @@ public:
   static PStatCollector _geoms_occluded_pcollector;
 
 private:
+  class ParallelJob;
+  friend class ParallelJob;
+
+  bool can_traverse_parallel(int num_children) const;
+  void traverse_children_parallel(CullTraverserData &data,
+                                  const PandaNode::Children &children);
+
   void show_bounds(CullTraverserData &data, bool tight);
   static PT(Geom) make_bounds_viz(const BoundingVolume *vol);
   PT(Geom) make_tight_bounds_viz(PandaNode *node) const;
@@ -121,6 +132,7 @@ private:
   CullHandler *_cull_handler;
   PortalClipper *_portal_clipper;
   bool _effective_incomplete_render;
+  bool _parallel_worker;
 
 public:
   static TypeHandle get_class_type() {
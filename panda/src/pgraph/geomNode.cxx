@@ -40,6 +40,8 @@
 #include "config_mathutil.h"
 #include "preparedGraphicsObjects.h"
 #include "instanceList.h"
+#include "vertexDataPage.h"
+#include "config_gobj.h"
 
 
 bool allow_flatten_color = ConfigVariableBool
@@ -516,6 +518,17 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
   trav->_geoms_pcollector.add_level(num_geoms);
   CPT(TransformState) internal_transform = data.get_internal_transform(trav);
 
+  if (vertex_data_prefetch && vertex_data_page_threads > 0 &&
+      VertexDataPage::has_evicted_pages()) {
+    // Some vertex data has been paged out.  Queue up all of our Geoms to be
+    // made resident now, so the paging threads can work on them while we
+    // continue the traversal, rather than having the draw block on each one
+    // in turn.
+    for (int i = 0; i < num_geoms; i++) {
+      geoms.get_geom(i)->request_resident();
+    }
+  }
+
   if (num_geoms == 1) {
     // If there's only one Geom, we don't need to bother culling each individual
     // Geom bounding volume against the view frustum, since we've already
@@ -6,6 +6,7 @@
 #include "auxSceneData.cxx"
 #include "bamFile.cxx"
 #include "billboardEffect.cxx"
+#include "bufferedCullHandler.cxx"
 #include "cacheStats.cxx"
 #include "camera.cxx"
 #include "clipPlaneAttrib.cxx"
@@ -17,6 +17,7 @@
 #include "config_pgraph.h"
 #include "lightReMutexHolder.h"
 #include "pStatTimer.h"
+#include "trueClock.h"
 
 using std::ostream;
 
@@ -25,8 +26,10 @@ RenderAttrib::Attribs RenderAttrib::_attribs;
 TypeHandle RenderAttrib::_type_handle;
 
 size_t RenderAttrib::_garbage_index = 0;
+unsigned int RenderAttrib::_num_sweeps = 0;
 
 PStatCollector RenderAttrib::_garbage_collect_pcollector("*:State Cache:Garbage Collect");
+PStatCollector RenderAttrib::_reclaimed_pcollector("State cache operations:Attrib reclaimed");
 
 /**
  *
@@ -195,42 +198,77 @@ garbage_collect() {
   // How many elements to process this pass?
   size_t size = orig_size;
   size_t num_this_pass = std::max(0, int(size * garbage_collect_states_rate));
+  num_this_pass = std::min(num_this_pass, size);
   if (num_this_pass <= 0) {
     return 0;
   }
 
+  double deadline = 0.0;
+  if (garbage_collect_states_budget > 0.0) {
+    deadline = TrueClock::get_global_ptr()->get_short_time() +
+      garbage_collect_states_budget;
+  }
+
+  // As in TransformState::garbage_collect_shard(), the value stored with each
+  // attrib is the number of sweeps it has survived, and long-lived attribs
+  // are only examined every few sweeps.  They still count towards the number
+  // of attribs visited in this pass.
+  unsigned int old_age = (unsigned int)std::max(1, (int)garbage_collect_states_old_age);
+  unsigned int old_interval = (unsigned int)std::max(1, (int)garbage_collect_old_states_interval);
+  bool examine_old = (_num_sweeps % old_interval) == 0;
+
   size_t si = _garbage_index;
   if (si >= size) {
     si = 0;
   }
 
-  num_this_pass = std::min(num_this_pass, size);
-  size_t stop_at_element = (si + num_this_pass) % size;
-
-  do {
-    RenderAttrib *attrib = (RenderAttrib *)_attribs.get_key(si);
-    if (!attrib->unref_if_one()) {
-      // This attrib has recently been unreffed to 1 (the one we added when
-      // we stored it in the cache).  Now it's time to delete it.  This is
-      // safe, because we're holding the _attribs_lock, so it's not possible
-      // for some other thread to find the attrib in the cache and ref it
-      // while we're doing this.  Also, we've just made sure to unref it to 0,
-      // to ensure that another thread can't get it via a weak pointer.
-      attrib->release_new();
-      delete attrib;
+  size_t num_visited = 0;
+  while (num_visited < num_this_pass && size != 0) {
+    ++num_visited;
 
-      // When we removed it from the hash map, it swapped the last element
-      // with the one we just removed.  So the current index contains one we
-      // still need to visit.
-      --size;
-      --si;
-      if (stop_at_element > 0) {
-        --stop_at_element;
+    if (deadline != 0.0 && (num_visited & 0x3f) == 0 &&
+        TrueClock::get_global_ptr()->get_short_time() >= deadline) {
+      // We've used up our time budget.
+      break;
+    }
+
+    unsigned int &age = _attribs.modify_data(si);
+    if (age < old_age || examine_old) {
+      RenderAttrib *attrib = (RenderAttrib *)_attribs.get_key(si);
+      if (!attrib->unref_if_one()) {
+        // This attrib has recently been unreffed to 1 (the one we added when
+        // we stored it in the cache).  Now it's time to delete it.  This is
+        // safe, because we're holding the _attribs_lock, so it's not
+        // possible for some other thread to find the attrib in the cache and
+        // ref it while we're doing this.  Also, we've just made sure to
+        // unref it to 0, to ensure that another thread can't get it via a
+        // weak pointer.
+        attrib->release_new();
+        delete attrib;
+
+        // When we removed it from the hash map, it swapped the last element
+        // with the one we just removed.  So the current index contains one
+        // we still need to visit.
+        --size;
+        if (si >= size) {
+          si = 0;
+          ++_num_sweeps;
+          examine_old = (_num_sweeps % old_interval) == 0;
+        }
+        continue;
+      }
+
+      if (age < old_age) {
+        ++age;
       }
     }
 
     si = (si + 1) % size;
-  } while (si != stop_at_element);
+    if (si == 0) {
+      ++_num_sweeps;
+      examine_old = (_num_sweeps % old_interval) == 0;
+    }
+  }
   _garbage_index = si;
 
   nassertr(_attribs.get_num_entries() == size, 0);
@@ -243,6 +281,7 @@ garbage_collect() {
   // size.  This will help reduce iteration overhead in the future.
   _attribs.consider_shrink_table();
 
+  _reclaimed_pcollector.add_level((int)orig_size - (int)size);
   return (int)orig_size - (int)size;
 }
 
@@ -373,7 +412,7 @@ return_unique(RenderAttrib *attrib) {
     // deleted while it's in it.
     attrib->ref();
   }
-  si = _attribs.store(attrib, nullptr);
+  si = _attribs.store(attrib, 0);
 
   // Save the index and return the input attrib.
   attrib->_saved_entry = si;
@@ -175,6 +175,7 @@ protected:
 public:
   INLINE static int register_slot(TypeHandle type_handle, int sort,
                                   RenderAttrib *default_attrib);
+  INLINE static void flush_level();
 
 private:
   void release_new();
@@ -185,17 +186,21 @@ public:
 private:
   // This mutex protects _attribs.
   static LightReMutex *_attribs_lock;
-  typedef SimpleHashMap<const RenderAttrib *, std::nullptr_t, indirect_compare_to_hash<const RenderAttrib *> > Attribs;
+  // The value is the number of consecutive garbage collection sweeps the
+  // attrib has survived.
+  typedef SimpleHashMap<const RenderAttrib *, unsigned int, indirect_compare_to_hash<const RenderAttrib *> > Attribs;
   static Attribs _attribs;
 
   int _saved_entry;
   size_t _hash;
 
   // This keeps track of our current position through the garbage collection
-  // cycle.
+  // cycle, and how many times we have gone all the way around.
   static size_t _garbage_index;
+  static unsigned int _num_sweeps;
 
   static PStatCollector _garbage_collect_pcollector;
+  static PStatCollector _reclaimed_pcollector;
 
   friend class RenderAttribRegistry;
 
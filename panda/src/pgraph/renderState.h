@@ -28,6 +28,7 @@
 #include "weakPointerTo.h"
 #include "lightReMutex.h"
 #include "lightMutex.h"
+#include "reMutex.h"
 #include "deletedChain.h"
 #include "simpleHashMap.h"
 #include "cacheStats.h"
@@ -233,12 +234,34 @@ public:
   mutable UpdateSeq _generated_shader_seq;
 
 private:
-  // This mutex protects _states.  It also protects any modification to the
-  // cache, which is encoded in _composition_cache and
-  // _invert_composition_cache.
+  // This mutex protects any modification to the cache, which is encoded in
+  // _composition_cache and _invert_composition_cache.  It must also be held
+  // while removing a state from the set of unique states.
   static LightReMutex *_states_lock;
-  typedef SimpleHashMap<const RenderState *, std::nullptr_t, indirect_compare_to_hash<const RenderState *> > States;
-  static States _states;
+  // As in TransformState, the value is the number of consecutive garbage
+  // collection sweeps the state has survived.
+  typedef SimpleHashMap<const RenderState *, unsigned int, indirect_compare_to_hash<const RenderState *> > States;
+
+  // The set of unique states is sharded by hash, as in TransformState.  If
+  // both are needed, _states_lock must be acquired before a shard's lock.
+  class StatesShard {
+  public:
+    ReMutex *_lock;
+    States _states;
+
+    // This keeps track of our current position through the garbage
+    // collection cycle, and how many times we have gone all the way around.
+    size_t _garbage_index;
+    unsigned int _num_sweeps;
+  };
+  enum { num_states_shards = 16 };
+  static StatesShard _states_shards[num_states_shards];
+  INLINE static StatesShard &get_states_shard(size_t hash);
+  static bool garbage_collect_shard(StatesShard &shard, double deadline,
+                                    int &num_collected);
+
+  // The shard at which the next garbage collection pass begins.
+  static size_t _garbage_shard;
   static const RenderState *_empty_state;
 
   // This iterator records the entry corresponding to this RenderState object
@@ -287,10 +310,6 @@ private:
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
 
-  // This keeps track of our current position through the garbage collection
-  // cycle.
-  static size_t _garbage_index;
-
   static PStatCollector _cache_update_pcollector;
   static PStatCollector _garbage_collect_pcollector;
   static PStatCollector _state_compose_pcollector;
@@ -300,6 +319,10 @@ private:
 
   static PStatCollector _node_counter;
   static PStatCollector _cache_counter;
+  static PStatCollector _cache_hit_pcollector;
+  static PStatCollector _cache_miss_pcollector;
+  static PStatCollector _contention_pcollector;
+  static PStatCollector _reclaimed_pcollector;
 
 private:
   // This is the actual data within the RenderState: a set of max_slots
@@ -342,6 +365,10 @@ private:
   // This mutex protects _flags, and all of the above computed values.
   LightMutex _lock;
 
+  // This mutex allows the composition caches to be read without holding
+  // _states_lock.  Modifying the caches requires holding both.
+  LightMutex _cache_lock;
+
   static CacheStats _cache_stats;
 
 public:
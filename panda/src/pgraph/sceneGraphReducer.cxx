@@ -22,6 +22,8 @@
 #include "geomNode.h"
 #include "config_gobj.h"
 #include "thread.h"
+#include "asyncParallelJob.h"
+#include "atomicAdjust.h"
 
 PStatCollector SceneGraphReducer::_flatten_collector("*:Flatten:flatten");
 PStatCollector SceneGraphReducer::_apply_collector("*:Flatten:apply");
@@ -32,6 +34,67 @@ PStatCollector SceneGraphReducer::_make_nonindexed_collector("*:Flatten:make non
 PStatCollector SceneGraphReducer::_unify_collector("*:Flatten:unify");
 PStatCollector SceneGraphReducer::_remove_unused_collector("*:Flatten:remove unused vertices");
 PStatCollector SceneGraphReducer::_premunge_collector("*:Premunge");
+PStatCollector SceneGraphReducer::_check_clean_collector("*:Flatten:check clean");
+
+/**
+ * A set of independent work items, such as subtrees to flatten or GeomNodes
+ * to unify, that may be divided among the threads of the flatten task chain.
+ */
+class SceneGraphReducer::ParallelJob : public AsyncParallelJob {
+public:
+  ParallelJob(PStatCollector &collector);
+
+  virtual void do_item(int n, Thread *current_thread);
+  virtual void process_item(size_t n)=0;
+
+  PStatCollector &_collector;
+  size_t _num_items;
+};
+
+/**
+ * Flattens a number of independent subtrees.  Each subtree has temporarily
+ * been moved under a private holder node, so that the nodes may be collapsed
+ * into their parent without touching the shared parent node.
+ */
+class SceneGraphReducer::FlattenJob : public SceneGraphReducer::ParallelJob {
+public:
+  FlattenJob(SceneGraphReducer *reducer, int combine_siblings_bits);
+  virtual void process_item(size_t n);
+
+  SceneGraphReducer *_reducer;
+  int _combine_siblings_bits;
+  pvector<PT(PandaNode)> _holders;
+  AtomicAdjust::Integer _num_nodes;
+};
+
+/**
+ * Applies one of the per-GeomNode operations to a list of distinct GeomNodes.
+ */
+class SceneGraphReducer::GeomNodeJob : public SceneGraphReducer::ParallelJob {
+public:
+  GeomNodeJob(PStatCollector &collector, GeomNodeOp op, int bits,
+              bool preserve_order);
+  virtual void process_item(size_t n);
+
+  GeomNodeOp _op;
+  int _bits;
+  bool _preserve_order;
+  pvector<PT(GeomNode)> _geom_nodes;
+  AtomicAdjust::Integer _num_changed;
+};
+
+/**
+ *
+ */
+SceneGraphReducer::
+SceneGraphReducer(GraphicsStateGuardianBase *gsg) :
+  _combine_radius(0.0f),
+  _num_threads(flatten_num_threads),
+  _parallel_active(false),
+  _incremental(false)
+{
+  set_gsg(gsg);
+}
 
 /**
  * Specifies the particular GraphicsStateGuardian that this object will
@@ -90,18 +153,7 @@ flatten(PandaNode *root, int combine_siblings_bits) {
   int num_pass_nodes;
 
   do {
-    num_pass_nodes = 0;
-
-    // Get a copy of the children list, so we don't have to worry about self-
-    // modifications.
-    PandaNode::Children cr = root->get_children();
-
-    // Now visit each of the children in turn.
-    int num_children = cr.get_num_children();
-    for (int i = 0; i < num_children; i++) {
-      PT(PandaNode) child_node = cr.get_child(i);
-      num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
-    }
+    num_pass_nodes = flatten_children(root, combine_siblings_bits, _incremental);
 
     if (combine_siblings_bits != 0 &&
         root->get_num_children() >= 2 &&
@@ -116,6 +168,11 @@ flatten(PandaNode *root, int combine_siblings_bits) {
     // could convert cousins into siblings, which may get flattened next pass.
   } while ((combine_siblings_bits & CS_recurse) != 0 && num_pass_nodes != 0);
 
+  if (_incremental) {
+    PStatTimer timer(_check_clean_collector);
+    record_subtrees(_flatten_records, &r_flatten_signature, root);
+  }
+
   return num_total_nodes;
 }
 
@@ -165,7 +222,7 @@ decompose(PandaNode *root) {
 
   if (!preserve_triangle_strips) {
     PStatTimer timer(_unify_collector);
-    r_decompose(root);
+    process_geom_nodes(root, GO_decompose, 0, false, false);
   }
 }
 
@@ -183,7 +240,12 @@ unify(PandaNode *root, bool preserve_order) {
   if (_gsg != nullptr) {
     max_indices = std::min(max_indices, _gsg->get_max_vertices_per_primitive());
   }
-  r_unify(root, max_indices, preserve_order);
+  process_geom_nodes(root, GO_unify, max_indices, preserve_order, _incremental);
+
+  if (_incremental) {
+    PStatTimer timer(_check_clean_collector);
+    record_subtrees(_unify_records, &r_unify_signature, root);
+  }
 }
 
 /**
@@ -420,14 +482,7 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
     }
 
     // First, recurse on each of the children.
-    {
-      PandaNode::Children cr = parent_node->get_children();
-      int num_children = cr.get_num_children();
-      for (int i = 0; i < num_children; i++) {
-        PT(PandaNode) child_node = cr.get_child(i);
-        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
-      }
-    }
+    num_nodes += flatten_children(parent_node, combine_siblings_bits, false);
 
     // Now that the above loop has removed some children, the child list saved
     // above is no longer accurate, so hereafter we must ask the node for its
@@ -487,6 +542,103 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
   return num_nodes;
 }
 
+/**
+ * Calls r_flatten() on each of the children of the indicated node, and
+ * returns the total number of nodes removed.
+ *
+ * If worker threads are available, the children whose subtrees are
+ * independent of the rest of the graph are flattened in parallel.  If
+ * skip_clean is true, the children that have not been modified since the
+ * last incremental flatten are left alone.
+ */
+int SceneGraphReducer::
+flatten_children(PandaNode *parent_node, int combine_siblings_bits,
+                 bool skip_clean) {
+  int num_nodes = 0;
+
+  // Get a copy of the children list, so we don't have to worry about self-
+  // modifications.
+  PandaNode::Children cr = parent_node->get_children();
+  int num_children = cr.get_num_children();
+  pvector<PT(PandaNode)> children;
+  children.reserve(num_children);
+  if (skip_clean) {
+    PStatTimer timer(_check_clean_collector);
+    for (int i = 0; i < num_children; i++) {
+      PandaNode *child_node = cr.get_child(i);
+      if (!is_clean(_flatten_records, &r_flatten_signature, child_node)) {
+        children.push_back(child_node);
+      }
+    }
+  } else {
+    for (int i = 0; i < num_children; i++) {
+      children.push_back(cr.get_child(i));
+    }
+  }
+
+  if (_num_threads > 0 && !_parallel_active && children.size() >= 2 &&
+      Thread::is_threading_supported()) {
+    // Separate out the children that we can safely hand to another thread:
+    // those that do not share any nodes with another part of the graph.
+    FlattenJob job(this, combine_siblings_bits);
+    pvector<PT(PandaNode)> independent;
+    pvector<PT(PandaNode)> dependent;
+    for (PandaNode *child_node : children) {
+      if (is_independent(child_node)) {
+        independent.push_back(child_node);
+      } else {
+        dependent.push_back(child_node);
+      }
+    }
+
+    if (independent.size() >= 2) {
+      // Move each independent child under a holder node of its own, leaving
+      // a placeholder in its slot, so that the threads don't all need to
+      // modify the same parent node.
+      pvector<PT(PandaNode)> placeholders;
+      placeholders.reserve(independent.size());
+      job._holders.reserve(independent.size());
+      for (PandaNode *child_node : independent) {
+        PT(PandaNode) placeholder = new PandaNode(child_node->get_name());
+        parent_node->replace_child(child_node, placeholder);
+        PT(PandaNode) holder = new PandaNode("flatten");
+        holder->add_child(child_node);
+        placeholders.push_back(std::move(placeholder));
+        job._holders.push_back(std::move(holder));
+      }
+      job._num_items = job._holders.size();
+      run_parallel(job);
+
+      // Now put the flattened subtrees back where they came from.
+      for (size_t i = 0; i < placeholders.size(); ++i) {
+        PandaNode *holder = job._holders[i];
+        nassertd(holder->get_num_children() == 1) {
+          parent_node->remove_child(placeholders[i]);
+          parent_node->steal_children(holder);
+          continue;
+        }
+        PT(PandaNode) child_node = holder->get_child(0);
+        holder->remove_all_children();
+        parent_node->replace_child(placeholders[i], child_node);
+      }
+      num_nodes += (int)AtomicAdjust::get(job._num_nodes);
+
+      // Since the independent subtrees share no nodes with the others, the
+      // rest may be flattened afterwards without changing the result.
+      for (PandaNode *child_node : dependent) {
+        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+      }
+      return num_nodes;
+    }
+  }
+
+  // Now visit each of the children in turn.
+  for (PandaNode *child_node : children) {
+    num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+  }
+  return num_nodes;
+}
+
 class SortByState {
 public:
   INLINE bool
@@ -851,66 +1003,103 @@ r_collect_vertex_data(PandaNode *node, int collect_bits,
 }
 
 /**
- * The recursive implementation of make_nonindexed().
+ * Applies the indicated operation to each distinct GeomNode at the indicated
+ * root and below, sharing the GeomNodes out among the worker threads if any
+ * are available.  If skip_clean is true, the subtrees that have not been
+ * modified since the last incremental unify are left alone.
+ *
+ * The return value is the number of Geoms changed, for GO_make_nonindexed,
+ * or 0 otherwise.
  */
 int SceneGraphReducer::
-r_make_nonindexed(PandaNode *node, int nonindexed_bits) {
-  int num_changed = 0;
-
-  if (node->is_geom_node()) {
-    GeomNode *geom_node = DCAST(GeomNode, node);
-    int num_geoms = geom_node->get_num_geoms();
-    for (int i = 0; i < num_geoms; ++i) {
-      const Geom *geom = geom_node->get_geom(i);
-
-      // Check whether the geom is animated or dynamic, and skip it if the
-      // user specified so.
-      const GeomVertexData *data = geom->get_vertex_data();
-      int this_geom_bits = 0;
-      if (data->get_format()->get_animation().get_animation_type() !=
-          Geom::AT_none) {
-        this_geom_bits |= MN_avoid_animated;
-      }
-      if (data->get_usage_hint() != Geom::UH_static ||
-          geom->get_usage_hint() != Geom::UH_static) {
-        this_geom_bits |= MN_avoid_dynamic;
-      }
-
-      if ((nonindexed_bits & this_geom_bits) == 0) {
-        // The geom meets the user's qualifications for making nonindexed, so
-        // do it.
-        PT(Geom) mgeom = geom_node->modify_geom(i);
-        num_changed += mgeom->make_nonindexed((nonindexed_bits & MN_composite_only) != 0);
+process_geom_nodes(PandaNode *root, GeomNodeOp op, int bits,
+                   bool preserve_order, bool skip_clean) {
+  PStatCollector &collector =
+    (op == GO_make_nonindexed) ? _make_nonindexed_collector : _unify_collector;
+  GeomNodeJob job(collector, op, bits, preserve_order);
+
+  pset<GeomNode *> found;
+  if (skip_clean) {
+    PStatTimer timer(_check_clean_collector);
+    if (root->is_geom_node()) {
+      GeomNode *geom_node = DCAST(GeomNode, root);
+      found.insert(geom_node);
+      job._geom_nodes.push_back(geom_node);
+    }
+    PandaNode::Children children = root->get_children();
+    int num_children = children.get_num_children();
+    for (int i = 0; i < num_children; ++i) {
+      PandaNode *child_node = children.get_child(i);
+      if (!is_clean(_unify_records, &r_unify_signature, child_node)) {
+        r_find_geom_nodes(child_node, job._geom_nodes, found);
       }
     }
+  } else {
+    r_find_geom_nodes(root, job._geom_nodes, found);
   }
 
-  PandaNode::Children children = node->get_children();
-  int num_children = children.get_num_children();
-  for (int i = 0; i < num_children; ++i) {
-    num_changed +=
-      r_make_nonindexed(children.get_child(i), nonindexed_bits);
-  }
-
-  return num_changed;
+  job._num_items = job._geom_nodes.size();
+  run_parallel(job);
+  return (int)AtomicAdjust::get(job._num_changed);
 }
 
 /**
- * The recursive implementation of unify().
+ * Appends each GeomNode at the indicated node and below to the list, in
+ * depth-first order, skipping any that have already been found by way of
+ * another path.
  */
 void SceneGraphReducer::
-r_unify(PandaNode *node, int max_indices, bool preserve_order) {
+r_find_geom_nodes(PandaNode *node, pvector<PT(GeomNode)> &geom_nodes,
+                  pset<GeomNode *> &found) {
   if (node->is_geom_node()) {
     GeomNode *geom_node = DCAST(GeomNode, node);
-    geom_node->unify(max_indices, preserve_order);
+    if (found.insert(geom_node).second) {
+      geom_nodes.push_back(geom_node);
+    }
   }
 
   PandaNode::Children children = node->get_children();
   int num_children = children.get_num_children();
   for (int i = 0; i < num_children; ++i) {
-    r_unify(children.get_child(i), max_indices, preserve_order);
+    r_find_geom_nodes(children.get_child(i), geom_nodes, found);
   }
-  Thread::consider_yield();
+}
+
+/**
+ * Converts the Geoms of a single GeomNode to nonindexed geometry, according
+ * to the bits passed to make_nonindexed().  Returns the number of Geoms
+ * changed.
+ */
+int SceneGraphReducer::
+make_geom_node_nonindexed(GeomNode *geom_node, int nonindexed_bits) {
+  int num_changed = 0;
+
+  int num_geoms = geom_node->get_num_geoms();
+  for (int i = 0; i < num_geoms; ++i) {
+    const Geom *geom = geom_node->get_geom(i);
+
+    // Check whether the geom is animated or dynamic, and skip it if the user
+    // specified so.
+    const GeomVertexData *data = geom->get_vertex_data();
+    int this_geom_bits = 0;
+    if (data->get_format()->get_animation().get_animation_type() !=
+        Geom::AT_none) {
+      this_geom_bits |= MN_avoid_animated;
+    }
+    if (data->get_usage_hint() != Geom::UH_static ||
+        geom->get_usage_hint() != Geom::UH_static) {
+      this_geom_bits |= MN_avoid_dynamic;
+    }
+
+    if ((nonindexed_bits & this_geom_bits) == 0) {
+      // The geom meets the user's qualifications for making nonindexed, so
+      // do it.
+      PT(Geom) mgeom = geom_node->modify_geom(i);
+      num_changed += mgeom->make_nonindexed((nonindexed_bits & MN_composite_only) != 0);
+    }
+  }
+
+  return num_changed;
 }
 
 /**
@@ -932,44 +1121,246 @@ r_register_vertices(PandaNode *node, GeomTransformer &transformer) {
 }
 
 /**
- * The recursive implementation of decompose().
+ * The recursive implementation of premunge().
  */
 void SceneGraphReducer::
-r_decompose(PandaNode *node) {
+r_premunge(PandaNode *node, const RenderState *state) {
+  CPT(RenderState) next_state = state->compose(node->get_state());
+
   if (node->is_geom_node()) {
     GeomNode *geom_node = DCAST(GeomNode, node);
-    geom_node->decompose();
+    geom_node->do_premunge(_gsg, next_state, _transformer);
   }
 
+  int i;
   PandaNode::Children children = node->get_children();
   int num_children = children.get_num_children();
-  for (int i = 0; i < num_children; ++i) {
-    r_decompose(children.get_child(i));
+  for (i = 0; i < num_children; ++i) {
+    r_premunge(children.get_child(i), next_state);
+  }
+
+  PandaNode::Stashed stashed = node->get_stashed();
+  int num_stashed = stashed.get_num_stashed();
+  for (i = 0; i < num_stashed; ++i) {
+    r_premunge(stashed.get_stashed(i), next_state);
   }
 }
 
 /**
- * The recursive implementation of premunge().
+ * Returns true if none of the nodes at the indicated node and below,
+ * including stashed nodes, has more than one parent, so that the subtree may
+ * be modified without affecting any other part of the scene graph.
  */
-void SceneGraphReducer::
-r_premunge(PandaNode *node, const RenderState *state) {
-  CPT(RenderState) next_state = state->compose(node->get_state());
-
-  if (node->is_geom_node()) {
-    GeomNode *geom_node = DCAST(GeomNode, node);
-    geom_node->do_premunge(_gsg, next_state, _transformer);
+bool SceneGraphReducer::
+is_independent(PandaNode *node) {
+  if (node->get_num_parents() != 1) {
+    return false;
   }
 
   int i;
   PandaNode::Children children = node->get_children();
   int num_children = children.get_num_children();
   for (i = 0; i < num_children; ++i) {
-    r_premunge(children.get_child(i), next_state);
+    if (!is_independent(children.get_child(i))) {
+      return false;
+    }
   }
 
   PandaNode::Stashed stashed = node->get_stashed();
   int num_stashed = stashed.get_num_stashed();
   for (i = 0; i < num_stashed; ++i) {
-    r_premunge(stashed.get_stashed(i), next_state);
+    if (!is_independent(stashed.get_stashed(i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Returns true if the subtree at the indicated node has the same signature,
+ * according to the indicated function, that it had when it was last recorded
+ * by record_subtrees().
+ */
+bool SceneGraphReducer::
+is_clean(const SubtreeRecords &records, SignatureFunc *func, PandaNode *node) {
+  SubtreeRecords::const_iterator ri = records.find(node);
+  if (ri == records.end() || (*ri).second._node.was_deleted()) {
+    return false;
+  }
+  return (*ri).second._signature == (*func)(0, node);
+}
+
+/**
+ * Replaces the contents of the indicated record table with the signatures of
+ * the subtrees at each of the children of the indicated root.
+ */
+void SceneGraphReducer::
+record_subtrees(SubtreeRecords &records, SignatureFunc *func, PandaNode *root) {
+  records.clear();
+
+  PandaNode::Children children = root->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    PandaNode *child_node = children.get_child(i);
+    SubtreeRecord &record = records[child_node];
+    record._node = child_node;
+    record._signature = (*func)(0, child_node);
+  }
+}
+
+/**
+ * Accumulates a signature of the properties of the indicated subtree that
+ * flatten() considers: the shape of the graph, and the transform, state,
+ * effects and draw masks of each node.  The contents of the GeomNodes are not
+ * considered, since these have no bearing on which nodes may be combined.
+ */
+size_t SceneGraphReducer::
+r_flatten_signature(size_t signature, PandaNode *node) {
+  signature = pointer_hash::add_hash(signature, node);
+  signature = pointer_hash::add_hash(signature, node->get_transform());
+  signature = pointer_hash::add_hash(signature, node->get_state());
+  signature = pointer_hash::add_hash(signature, node->get_effects());
+  signature = size_t_hash::add_hash(signature, node->get_draw_control_mask().get_word());
+  signature = size_t_hash::add_hash(signature, node->get_draw_show_mask().get_word());
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  signature = int_hash::add_hash(signature, num_children);
+  for (int i = 0; i < num_children; ++i) {
+    signature = r_flatten_signature(signature, children.get_child(i));
+  }
+  return signature;
+}
+
+/**
+ * Accumulates a signature of the properties of the indicated subtree that
+ * unify() considers: the Geoms of each GeomNode, their states, and the
+ * modification counters of their primitives and vertex data.
+ */
+size_t SceneGraphReducer::
+r_unify_signature(size_t signature, PandaNode *node) {
+  signature = pointer_hash::add_hash(signature, node);
+
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    int num_geoms = geom_node->get_num_geoms();
+    signature = int_hash::add_hash(signature, num_geoms);
+    for (int i = 0; i < num_geoms; ++i) {
+      CPT(Geom) geom = geom_node->get_geom(i);
+      CPT(GeomVertexData) data = geom->get_vertex_data();
+      signature = pointer_hash::add_hash(signature, geom);
+      signature = pointer_hash::add_hash(signature, geom_node->get_geom_state(i));
+      signature = size_t_hash::add_hash(signature, geom->get_modified().get_seq());
+      signature = pointer_hash::add_hash(signature, data);
+      signature = size_t_hash::add_hash(signature, data->get_modified().get_seq());
+    }
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  signature = int_hash::add_hash(signature, num_children);
+  for (int i = 0; i < num_children; ++i) {
+    signature = r_unify_signature(signature, children.get_child(i));
+  }
+  return signature;
+}
+
+/**
+ * Runs all of the items of the indicated job, and returns when they are
+ * finished.  The items are shared with the threads of the flatten task chain,
+ * if worker threads have been enabled with set_num_threads().
+ */
+void SceneGraphReducer::
+run_parallel(ParallelJob &job) {
+  int num_threads = _parallel_active ? 0 : _num_threads;
+
+  // While the job is running, any flatten operations it starts on its own
+  // subtrees are performed serially by whichever thread picked them up.
+  // This must be set before any worker can see the job, and is only restored
+  // once they are all done with it.
+  bool was_active = _parallel_active;
+  _parallel_active = true;
+  job.run((int)job._num_items, num_threads);
+  _parallel_active = was_active;
+}
+
+/**
+ *
+ */
+SceneGraphReducer::ParallelJob::
+ParallelJob(PStatCollector &collector) :
+  AsyncParallelJob("flatten"),
+  _collector(collector),
+  _num_items(0)
+{
+}
+
+/**
+ * Runs the nth item of the job.  Called from each thread that takes part in
+ * the job.
+ */
+void SceneGraphReducer::ParallelJob::
+do_item(int n, Thread *current_thread) {
+  PStatTimer timer(_collector, current_thread);
+  process_item((size_t)n);
+  Thread::consider_yield();
+}
+
+/**
+ *
+ */
+SceneGraphReducer::FlattenJob::
+FlattenJob(SceneGraphReducer *reducer, int combine_siblings_bits) :
+  ParallelJob(_flatten_collector),
+  _reducer(reducer),
+  _combine_siblings_bits(combine_siblings_bits),
+  _num_nodes(0)
+{
+}
+
+/**
+ * Flattens the subtree below the nth holder node.
+ */
+void SceneGraphReducer::FlattenJob::
+process_item(size_t n) {
+  PandaNode *holder = _holders[n];
+  PT(PandaNode) child_node = holder->get_child(0);
+  int num_nodes = _reducer->r_flatten(holder, child_node, _combine_siblings_bits);
+  AtomicAdjust::add(_num_nodes, num_nodes);
+}
+
+/**
+ *
+ */
+SceneGraphReducer::GeomNodeJob::
+GeomNodeJob(PStatCollector &collector, SceneGraphReducer::GeomNodeOp op,
+            int bits, bool preserve_order) :
+  ParallelJob(collector),
+  _op(op),
+  _bits(bits),
+  _preserve_order(preserve_order),
+  _num_changed(0)
+{
+}
+
+/**
+ * Applies the operation to the nth GeomNode.
+ */
+void SceneGraphReducer::GeomNodeJob::
+process_item(size_t n) {
+  GeomNode *geom_node = _geom_nodes[n];
+  switch (_op) {
+  case GO_unify:
+    geom_node->unify(_bits, _preserve_order);
+    break;
+
+  case GO_decompose:
+    geom_node->decompose();
+    break;
+
+  case GO_make_nonindexed:
+    AtomicAdjust::add(_num_changed, make_geom_node_nonindexed(geom_node, _bits));
+    break;
   }
 }
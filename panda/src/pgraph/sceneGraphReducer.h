@@ -25,8 +25,13 @@
 #include "typedObject.h"
 #include "pointerTo.h"
 #include "graphicsStateGuardianBase.h"
+#include "pandaNode.h"
+#include "weakPointerTo.h"
+#include "pmap.h"
+#include "pset.h"
+#include "pvector.h"
 
-class PandaNode;
+class GeomNode;
 
 /**
  * An interface for simplifying ("flattening") scene graphs by eliminating
@@ -38,7 +43,7 @@ class PandaNode;
  */
 class EXPCL_PANDA_PGRAPH SceneGraphReducer {
 PUBLISHED:
-  INLINE explicit SceneGraphReducer(GraphicsStateGuardianBase *gsg = nullptr);
+  explicit SceneGraphReducer(GraphicsStateGuardianBase *gsg = nullptr);
   INLINE ~SceneGraphReducer();
 
   enum AttribTypes {
@@ -120,6 +125,12 @@ PUBLISHED:
   INLINE void set_combine_radius(PN_stdfloat combine_radius);
   INLINE PN_stdfloat get_combine_radius() const;
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
+  INLINE void set_incremental(bool incremental);
+  INLINE bool get_incremental() const;
+
   INLINE void apply_attribs(PandaNode *node, int attrib_types = ~(TT_clip_plane | TT_cull_face | TT_apply_texture_color));
   INLINE void apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                             int attrib_types, GeomTransformer &transformer);
@@ -147,6 +158,8 @@ protected:
 
   int r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
                 int combine_siblings_bits);
+  int flatten_children(PandaNode *parent_node, int combine_siblings_bits,
+                       bool skip_clean);
   int flatten_siblings(PandaNode *parent_node,
                        int combine_siblings_bits);
 
@@ -173,18 +186,63 @@ protected:
 
   int r_collect_vertex_data(PandaNode *node, int collect_bits,
                             GeomTransformer &transformer, bool format_only);
-  int r_make_nonindexed(PandaNode *node, int collect_bits);
-  void r_unify(PandaNode *node, int max_indices, bool preserve_order);
   void r_register_vertices(PandaNode *node, GeomTransformer &transformer);
-  void r_decompose(PandaNode *node);
 
   void r_premunge(PandaNode *node, const RenderState *state);
 
+private:
+  class ParallelJob;
+  class FlattenJob;
+  class GeomNodeJob;
+
+  enum GeomNodeOp {
+    GO_unify,
+    GO_decompose,
+    GO_make_nonindexed,
+  };
+
+  int process_geom_nodes(PandaNode *root, GeomNodeOp op, int bits,
+                         bool preserve_order, bool skip_clean);
+  static void r_find_geom_nodes(PandaNode *node,
+                                pvector<PT(GeomNode)> &geom_nodes,
+                                pset<GeomNode *> &found);
+  static int make_geom_node_nonindexed(GeomNode *geom_node,
+                                       int nonindexed_bits);
+
+  static bool is_independent(PandaNode *node);
+
+  // In incremental mode, these record, for each child of the most recently
+  // processed root, a signature of its subtree as the pass left it, so that
+  // subtrees that have not been touched since may be skipped next time.
+  class SubtreeRecord {
+  public:
+    WPT(PandaNode) _node;
+    size_t _signature;
+  };
+  typedef pmap<const PandaNode *, SubtreeRecord> SubtreeRecords;
+  typedef size_t SignatureFunc(size_t signature, PandaNode *node);
+
+  static bool is_clean(const SubtreeRecords &records, SignatureFunc *func,
+                       PandaNode *node);
+  static void record_subtrees(SubtreeRecords &records, SignatureFunc *func,
+                              PandaNode *root);
+  static size_t r_flatten_signature(size_t signature, PandaNode *node);
+  static size_t r_unify_signature(size_t signature, PandaNode *node);
+
+  void run_parallel(ParallelJob &job);
+
 private:
   PT(GraphicsStateGuardianBase) _gsg;
   PN_stdfloat _combine_radius;
   GeomTransformer _transformer;
 
+  int _num_threads;
+  bool _parallel_active;
+
+  bool _incremental;
+  SubtreeRecords _flatten_records;
+  SubtreeRecords _unify_records;
+
   static PStatCollector _flatten_collector;
   static PStatCollector _apply_collector;
   static PStatCollector _remove_column_collector;
@@ -194,6 +252,7 @@ private:
   static PStatCollector _unify_collector;
   static PStatCollector _remove_unused_collector;
   static PStatCollector _premunge_collector;
+  static PStatCollector _check_clean_collector;
 };
 
 #include "sceneGraphReducer.I"
@@ -22,16 +22,18 @@
 #include "config_pgraph.h"
 #include "lightReMutexHolder.h"
 #include "lightMutexHolder.h"
+#include "reMutexHolder.h"
 #include "thread.h"
+#include "trueClock.h"
 
 using std::ostream;
 
 LightReMutex *TransformState::_states_lock = nullptr;
-TransformState::States TransformState::_states;
+TransformState::StatesShard TransformState::_states_shards[TransformState::num_states_shards];
+size_t TransformState::_garbage_shard = 0;
 CPT(TransformState) TransformState::_identity_state;
 CPT(TransformState) TransformState::_invalid_state;
 UpdateSeq TransformState::_last_cycle_detect;
-size_t TransformState::_garbage_index = 0;
 bool TransformState::_uniquify_matrix = true;
 
 PStatCollector TransformState::_cache_update_pcollector("*:State Cache:Update");
@@ -45,6 +47,10 @@ PStatCollector TransformState::_transform_validate_pcollector("*:State Cache:Val
 PStatCollector TransformState::_transform_hash_pcollector("*:State Cache:Calc Hash");
 PStatCollector TransformState::_node_counter("TransformStates:On nodes");
 PStatCollector TransformState::_cache_counter("TransformStates:Cached");
+PStatCollector TransformState::_cache_hit_pcollector("State cache operations:Transform hit");
+PStatCollector TransformState::_cache_miss_pcollector("State cache operations:Transform miss");
+PStatCollector TransformState::_contention_pcollector("State cache operations:Transform contention");
+PStatCollector TransformState::_reclaimed_pcollector("State cache operations:Transform reclaimed");
 
 CacheStats TransformState::_cache_stats;
 
@@ -600,18 +606,36 @@ compose(const TransformState *other) const {
     return do_compose(other);
   }
 
+  {
+    // Most of the time, the composition is already cached, and we only need
+    // to hold our own cache lock to look it up.  The result is kept alive by
+    // the cache for as long as we hold the lock.
+    LightMutexHolder cache_holder(_cache_lock);
+    int index = _composition_cache.find(other);
+    if (index != -1) {
+      const Composition &comp = _composition_cache.get_data(index);
+      if (comp._result != nullptr) {
+        // Success!
+        _cache_stats.inc_hits();
+        _cache_hit_pcollector.add_level(1);
+        return comp._result;
+      }
+    }
+  }
+
   LightReMutexHolder holder(*_states_lock);
 
-  // Is this composition already cached?
+  // Check again, now that we hold the lock.
   int index = _composition_cache.find(other);
   if (index != -1) {
     const Composition &comp = _composition_cache.get_data(index);
     if (comp._result != nullptr) {
-      // Success!
       _cache_stats.inc_hits();
+      _cache_hit_pcollector.add_level(1);
       return comp._result;
     }
   }
+  _cache_miss_pcollector.add_level(1);
 
   // Not in the cache.  Compute a new result.  It's important that we don't
   // hold the lock while we do this, or we lose the benefit of
@@ -619,6 +643,7 @@ compose(const TransformState *other) const {
   CPT(TransformState) result = do_compose(other);
 
   if (index != -1) {
+    LightMutexHolder cache_holder(_cache_lock);
     Composition &comp = _composition_cache.modify_data(index);
     // Well, it wasn't cached already, but we already had an entry (probably
     // created for the reverse direction), so use the same entry to store
@@ -646,11 +671,15 @@ compose(const TransformState *other) const {
   _cache_stats.add_total_size(1);
   _cache_stats.inc_adds(_composition_cache.is_empty());
 
-  _composition_cache[other]._result = result;
+  {
+    LightMutexHolder cache_holder(_cache_lock);
+    _composition_cache[other]._result = result;
+  }
 
   if (other != this) {
     _cache_stats.add_total_size(1);
     _cache_stats.inc_adds(other->_composition_cache.is_empty());
+    LightMutexHolder cache_holder(other->_cache_lock);
     other->_composition_cache[this]._result = nullptr;
   }
 
@@ -707,17 +736,33 @@ invert_compose(const TransformState *other) const {
     return do_invert_compose(other);
   }
 
+  {
+    // See compose() for an explanation of this lookup.
+    LightMutexHolder cache_holder(_cache_lock);
+    int index = _invert_composition_cache.find(other);
+    if (index != -1) {
+      const Composition &comp = _invert_composition_cache.get_data(index);
+      if (comp._result != nullptr) {
+        // Success!
+        _cache_stats.inc_hits();
+        _cache_hit_pcollector.add_level(1);
+        return comp._result;
+      }
+    }
+  }
+
   LightReMutexHolder holder(*_states_lock);
 
   int index = _invert_composition_cache.find(other);
   if (index != -1) {
     const Composition &comp = _invert_composition_cache.get_data(index);
     if (comp._result != nullptr) {
-      // Success!
       _cache_stats.inc_hits();
+      _cache_hit_pcollector.add_level(1);
       return comp._result;
     }
   }
+  _cache_miss_pcollector.add_level(1);
 
   // Not in the cache.  Compute a new result.  It's important that we don't
   // hold the lock while we do this, or we lose the benefit of
@@ -726,6 +771,7 @@ invert_compose(const TransformState *other) const {
 
   // Is this composition already cached?
   if (index != -1) {
+    LightMutexHolder cache_holder(_cache_lock);
     Composition &comp = _invert_composition_cache.modify_data(index);
     // Well, it wasn't cached already, but we already had an entry (probably
     // created for the reverse direction), so use the same entry to store
@@ -752,11 +798,15 @@ invert_compose(const TransformState *other) const {
   // the other will be NULL for now.
   _cache_stats.add_total_size(1);
   _cache_stats.inc_adds(_invert_composition_cache.is_empty());
-  _invert_composition_cache[other]._result = result;
+  {
+    LightMutexHolder cache_holder(_cache_lock);
+    _invert_composition_cache[other]._result = result;
+  }
 
   if (other != this) {
     _cache_stats.add_total_size(1);
     _cache_stats.inc_adds(other->_invert_composition_cache.is_empty());
+    LightMutexHolder cache_holder(other->_cache_lock);
     other->_invert_composition_cache[this]._result = nullptr;
   }
 
@@ -987,7 +1037,12 @@ write_composition_cache(ostream &out, int indent_level) const {
 int TransformState::
 get_num_states() {
   LightReMutexHolder holder(*_states_lock);
-  return _states.get_num_entries();
+  size_t num_states = 0;
+  for (const StatesShard &shard : _states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    num_states += shard._states.get_num_entries();
+  }
+  return (int)num_states;
 }
 
 /**
@@ -1013,41 +1068,44 @@ get_num_unused_states() {
   typedef pmap<const TransformState *, int> StateCount;
   StateCount state_count;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-
-    std::pair<StateCount::iterator, bool> ir =
-      state_count.insert(StateCount::value_type(state, 1));
-    if (!ir.second) {
-      // If the above insert operation fails, then it's already in the
-      // cache; increment its value.
-      (*(ir.first)).second++;
-    }
+  for (const StatesShard &shard : _states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+
+      std::pair<StateCount::iterator, bool> ir =
+        state_count.insert(StateCount::value_type(state, 1));
+      if (!ir.second) {
+        // If the above insert operation fails, then it's already in the
+        // cache; increment its value.
+        (*(ir.first)).second++;
+      }
 
-    size_t i;
-    size_t cache_size = state->_composition_cache.get_num_entries();
-    for (i = 0; i < cache_size; ++i) {
-      const TransformState *result = state->_composition_cache.get_data(i)._result;
-      if (result != nullptr && result != state) {
-        // Here's a TransformState that's recorded in the cache.  Count it.
-        std::pair<StateCount::iterator, bool> ir =
-          state_count.insert(StateCount::value_type(result, 1));
-        if (!ir.second) {
-          // If the above insert operation fails, then it's already in the
-          // cache; increment its value.
-          (*(ir.first)).second++;
+      size_t i;
+      size_t cache_size = state->_composition_cache.get_num_entries();
+      for (i = 0; i < cache_size; ++i) {
+        const TransformState *result = state->_composition_cache.get_data(i)._result;
+        if (result != nullptr && result != state) {
+          // Here's a TransformState that's recorded in the cache.  Count it.
+          std::pair<StateCount::iterator, bool> ir =
+            state_count.insert(StateCount::value_type(result, 1));
+          if (!ir.second) {
+            // If the above insert operation fails, then it's already in the
+            // cache; increment its value.
+            (*(ir.first)).second++;
+          }
         }
       }
-    }
-    cache_size = state->_invert_composition_cache.get_num_entries();
-    for (i = 0; i < cache_size; ++i) {
-      const TransformState *result = state->_invert_composition_cache.get_data(i)._result;
-      if (result != nullptr && result != state) {
-        std::pair<StateCount::iterator, bool> ir =
-          state_count.insert(StateCount::value_type(result, 1));
-        if (!ir.second) {
-          (*(ir.first)).second++;
+      cache_size = state->_invert_composition_cache.get_num_entries();
+      for (i = 0; i < cache_size; ++i) {
+        const TransformState *result = state->_invert_composition_cache.get_data(i)._result;
+        if (result != nullptr && result != state) {
+          std::pair<StateCount::iterator, bool> ir =
+            state_count.insert(StateCount::value_type(result, 1));
+          if (!ir.second) {
+            (*(ir.first)).second++;
+          }
         }
       }
     }
@@ -1098,7 +1156,7 @@ clear_cache() {
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
-  int orig_size = _states.get_num_entries();
+  int orig_size = get_num_states();
 
   // First, we need to copy the entire set of states to a temporary vector,
   // reference-counting each object.  That way we can walk through the copy,
@@ -1109,10 +1167,13 @@ clear_cache() {
     TempStates temp_states;
     temp_states.reserve(orig_size);
 
-    size_t size = _states.get_num_entries();
-    for (size_t si = 0; si < size; ++si) {
-      const TransformState *state = _states.get_key(si);
-      temp_states.push_back(state);
+    for (const StatesShard &shard : _states_shards) {
+      ReMutexHolder shard_holder(*shard._lock);
+      size_t size = shard._states.get_num_entries();
+      for (size_t si = 0; si < size; ++si) {
+        const TransformState *state = shard._states.get_key(si);
+        temp_states.push_back(state);
+      }
     }
 
     // Now it's safe to walk through the list, destroying the cache within
@@ -1120,6 +1181,7 @@ clear_cache() {
     TempStates::iterator ti;
     for (ti = temp_states.begin(); ti != temp_states.end(); ++ti) {
       TransformState *state = (TransformState *)(*ti).p();
+      LightMutexHolder cache_holder(state->_cache_lock);
 
       size_t i;
       size_t cache_size = state->_composition_cache.get_num_entries();
@@ -1150,7 +1212,7 @@ clear_cache() {
     // the various objects' caches will go away.
   }
 
-  int new_size = _states.get_num_entries();
+  int new_size = get_num_states();
   return orig_size - new_size;
 }
 
@@ -1169,75 +1231,146 @@ garbage_collect() {
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_garbage_collect_pcollector);
-  size_t orig_size = _states.get_num_entries();
 
-  // How many elements to process this pass?
-  size_t size = orig_size;
-  size_t num_this_pass = std::max(0, int(size * garbage_collect_states_rate));
+  // If there is a time budget, we may not get around to all of the shards,
+  // so we start where we left off the last time.
+  double deadline = 0.0;
+  if (garbage_collect_states_budget > 0.0) {
+    deadline = TrueClock::get_global_ptr()->get_short_time() +
+      garbage_collect_states_budget;
+  }
+
+  int num_collected = 0;
+  for (size_t i = 0; i < num_states_shards; ++i) {
+    StatesShard &shard = _states_shards[_garbage_shard];
+    _garbage_shard = (_garbage_shard + 1) % num_states_shards;
+
+    ReMutexHolder shard_holder(*shard._lock);
+    if (!garbage_collect_shard(shard, deadline, num_collected)) {
+      break;
+    }
+  }
+
+  _reclaimed_pcollector.add_level(num_collected);
+  return num_collected;
+}
+
+/**
+ * Performs a garbage-collection pass over a single shard of the set of unique
+ * states.  You must already be holding _states_lock and the lock of the
+ * shard.  Increments num_collected by the number of states freed.
+ *
+ * Each entry in the shard records the number of consecutive sweeps the state
+ * has survived.  States that have survived garbage-collect-states-old-age
+ * sweeps are only examined every garbage-collect-old-states-interval sweeps;
+ * in between, they are merely stepped over.  Either way, no more than
+ * garbage-collect-states-rate of the shard is visited in one pass.
+ *
+ * Returns false if the deadline (if nonzero) has passed, in which case the
+ * caller should not process any more shards.
+ */
+bool TransformState::
+garbage_collect_shard(StatesShard &shard, double deadline, int &num_collected) {
+  size_t size = shard._states.get_num_entries();
+
+  // How many elements to process this pass?  We round up, so that even a
+  // shard containing only a few states is eventually visited.
+  size_t num_this_pass = std::max(0, (int)ceil(size * garbage_collect_states_rate));
+  num_this_pass = std::min(num_this_pass, size);
   if (num_this_pass <= 0) {
-    return 0;
+    return true;
   }
 
   bool break_and_uniquify = (auto_break_cycles && uniquify_transforms);
 
-  size_t si = _garbage_index;
+  unsigned int old_age = (unsigned int)std::max(1, (int)garbage_collect_states_old_age);
+  unsigned int old_interval = (unsigned int)std::max(1, (int)garbage_collect_old_states_interval);
+  bool examine_old = (shard._num_sweeps % old_interval) == 0;
+
+  size_t si = shard._garbage_index;
   if (si >= size) {
     si = 0;
   }
 
-  num_this_pass = std::min(num_this_pass, size);
-  size_t stop_at_element = (si + num_this_pass) % size;
-
-  do {
-    TransformState *state = (TransformState *)_states.get_key(si);
-    if (break_and_uniquify) {
-      if (state->get_cache_ref_count() > 0 &&
-          state->get_ref_count() == state->get_cache_ref_count()) {
-        // If we have removed all the references to this state not in the
-        // cache, leaving only references in the cache, then we need to
-        // check for a cycle involving this TransformState and break it if
-        // it exists.
-        state->detect_and_break_cycles();
-      }
+  bool in_budget = true;
+  size_t num_visited = 0;
+  while (num_visited < num_this_pass && size != 0) {
+    ++num_visited;
+
+    // Checking the clock is not free, so we only do it once in a while.
+    if (deadline != 0.0 && (num_visited & 0x3f) == 0 &&
+        TrueClock::get_global_ptr()->get_short_time() >= deadline) {
+      in_budget = false;
+      break;
     }
 
-    if (!state->unref_if_one()) {
-      // This state has recently been unreffed to 1 (the one we added when
-      // we stored it in the cache).  Now it's time to delete it.  This is
-      // safe, because we're holding the _states_lock, so it's not possible
-      // for some other thread to find the state in the cache and ref it
-      // while we're doing this.  Also, we've just made sure to unref it to 0,
-      // to ensure that another thread can't get it via a weak pointer.
-      state->release_new();
-      state->remove_cache_pointers();
-      state->cache_unref_only();
-      delete state;
-
-      // When we removed it from the hash map, it swapped the last element
-      // with the one we just removed.  So the current index contains one we
-      // still need to visit.
-      --size;
-      --si;
-      if (stop_at_element > 0) {
-        --stop_at_element;
+    unsigned int &age = shard._states.modify_data(si);
+    if (age >= old_age && !examine_old) {
+      // This is a long-lived state; don't bother with it this sweep.
+    } else {
+
+      TransformState *state = (TransformState *)shard._states.get_key(si);
+      if (break_and_uniquify) {
+        if (state->get_cache_ref_count() > 0 &&
+            state->get_ref_count() == state->get_cache_ref_count()) {
+          // If we have removed all the references to this state not in the
+          // cache, leaving only references in the cache, then we need to
+          // check for a cycle involving this TransformState and break it if
+          // it exists.
+          state->detect_and_break_cycles();
+        }
+      }
+
+      if (!state->unref_if_one()) {
+        // This state has recently been unreffed to 1 (the one we added when
+        // we stored it in the cache).  Now it's time to delete it.  This is
+        // safe, because we're holding the lock of the shard, so it's not
+        // possible for some other thread to find the state in the cache and
+        // ref it while we're doing this.  Also, we've just made sure to unref
+        // it to 0, to ensure that another thread can't get it via a weak
+        // pointer.
+        state->release_new();
+        state->remove_cache_pointers();
+        state->cache_unref_only();
+        delete state;
+        ++num_collected;
+
+        // When we removed it from the hash map, it swapped the last element
+        // with the one we just removed.  So the current index contains one
+        // we still need to visit.
+        --size;
+        if (si >= size) {
+          si = 0;
+          ++shard._num_sweeps;
+          examine_old = (shard._num_sweeps % old_interval) == 0;
+        }
+        continue;
+      }
+
+      if (age < old_age) {
+        ++age;
       }
     }
 
     si = (si + 1) % size;
-  } while (si != stop_at_element);
-  _garbage_index = si;
+    if (si == 0) {
+      ++shard._num_sweeps;
+      examine_old = (shard._num_sweeps % old_interval) == 0;
+    }
+  }
+  shard._garbage_index = si;
 
-  nassertr(_states.get_num_entries() == size, 0);
+  nassertr(shard._states.get_num_entries() == size, false);
 
 #ifdef _DEBUG
-  nassertr(_states.validate(), 0);
+  nassertr(shard._states.validate(), false);
 #endif
 
   // If we just cleaned up a lot of states, see if we can reduce the table in
   // size.  This will help reduce iteration overhead in the future.
-  _states.consider_shrink_table();
+  shard._states.consider_shrink_table();
 
-  return (int)orig_size - (int)size;
+  return in_budget;
 }
 
 /**
@@ -1261,60 +1394,63 @@ list_cycles(ostream &out) {
   VisitedStates visited;
   CompositionCycleDesc cycle_desc;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-
-    bool inserted = visited.insert(state).second;
-    if (inserted) {
-      ++_last_cycle_detect;
-      if (r_detect_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
-        // This state begins a cycle.
-        CompositionCycleDesc::reverse_iterator csi;
-
-        out << "\nCycle detected of length " << cycle_desc.size() + 1 << ":\n"
-            << "state " << (void *)state << ":" << state->get_ref_count()
-            << " =\n";
-        state->write(out, 2);
-        for (csi = cycle_desc.rbegin(); csi != cycle_desc.rend(); ++csi) {
-          const CompositionCycleDescEntry &entry = (*csi);
-          if (entry._inverted) {
-            out << "invert composed with ";
-          } else {
-            out << "composed with ";
-          }
-          out << (const void *)entry._obj << ":" << entry._obj->get_ref_count()
-              << " " << *entry._obj << "\n"
-              << "produces " << (const void *)entry._result << ":"
-              << entry._result->get_ref_count() << " =\n";
-          entry._result->write(out, 2);
-          visited.insert(entry._result);
-        }
+  for (const StatesShard &shard : _states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
 
-        cycle_desc.clear();
-      } else {
+      bool inserted = visited.insert(state).second;
+      if (inserted) {
         ++_last_cycle_detect;
-        if (r_detect_reverse_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
+        if (r_detect_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
           // This state begins a cycle.
-          CompositionCycleDesc::iterator csi;
+          CompositionCycleDesc::reverse_iterator csi;
 
-          out << "\nReverse cycle detected of length " << cycle_desc.size() + 1 << ":\n"
-              << "state ";
-          for (csi = cycle_desc.begin(); csi != cycle_desc.end(); ++csi) {
+          out << "\nCycle detected of length " << cycle_desc.size() + 1 << ":\n"
+              << "state " << (void *)state << ":" << state->get_ref_count()
+              << " =\n";
+          state->write(out, 2);
+          for (csi = cycle_desc.rbegin(); csi != cycle_desc.rend(); ++csi) {
             const CompositionCycleDescEntry &entry = (*csi);
-            out << (const void *)entry._result << ":"
+            if (entry._inverted) {
+              out << "invert composed with ";
+            } else {
+              out << "composed with ";
+            }
+            out << (const void *)entry._obj << ":" << entry._obj->get_ref_count()
+                << " " << *entry._obj << "\n"
+                << "produces " << (const void *)entry._result << ":"
                 << entry._result->get_ref_count() << " =\n";
             entry._result->write(out, 2);
-            out << (const void *)entry._obj << ":"
-                << entry._obj->get_ref_count() << " =\n";
-            entry._obj->write(out, 2);
             visited.insert(entry._result);
           }
-          out << (void *)state << ":"
-              << state->get_ref_count() << " =\n";
-          state->write(out, 2);
 
           cycle_desc.clear();
+        } else {
+          ++_last_cycle_detect;
+          if (r_detect_reverse_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
+            // This state begins a cycle.
+            CompositionCycleDesc::iterator csi;
+
+            out << "\nReverse cycle detected of length " << cycle_desc.size() + 1 << ":\n"
+                << "state ";
+            for (csi = cycle_desc.begin(); csi != cycle_desc.end(); ++csi) {
+              const CompositionCycleDescEntry &entry = (*csi);
+              out << (const void *)entry._result << ":"
+                  << entry._result->get_ref_count() << " =\n";
+              entry._result->write(out, 2);
+              out << (const void *)entry._obj << ":"
+                  << entry._obj->get_ref_count() << " =\n";
+              entry._obj->write(out, 2);
+              visited.insert(entry._result);
+            }
+            out << (void *)state << ":"
+                << state->get_ref_count() << " =\n";
+            state->write(out, 2);
+
+            cycle_desc.clear();
+          }
         }
       }
     }
@@ -1331,11 +1467,14 @@ void TransformState::
 list_states(ostream &out) {
   LightReMutexHolder holder(*_states_lock);
 
-  size_t size = _states.get_num_entries();
-  out << size << " states:\n";
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-    state->write(out, 2);
+  out << get_num_states() << " states:\n";
+  for (const StatesShard &shard : _states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+      state->write(out, 2);
+    }
   }
 }
 
@@ -1350,44 +1489,49 @@ validate_states() {
   PStatTimer timer(_transform_validate_pcollector);
 
   LightReMutexHolder holder(*_states_lock);
-  if (_states.is_empty()) {
-    return true;
-  }
-
-  if (!_states.validate()) {
-    pgraph_cat.error()
-      << "TransformState::_states cache is invalid!\n";
-    return false;
-  }
-
-  size_t size = _states.get_num_entries();
-  size_t si = 0;
-  nassertr(si < size, false);
-  nassertr(_states.get_key(si)->get_ref_count() >= 0, false);
-  size_t snext = si;
-  ++snext;
-  while (snext < size) {
-    nassertr(_states.get_key(snext)->get_ref_count() >= 0, false);
-    const TransformState *ssi = _states.get_key(si);
-    if (!ssi->validate_composition_cache()) {
-      return false;
+  for (const StatesShard &shard : _states_shards) {
+    ReMutexHolder shard_holder(*shard._lock);
+    const States &states = shard._states;
+    if (states.is_empty()) {
+      continue;
     }
-    const TransformState *ssnext = _states.get_key(snext);
-    bool c = (*ssi) == (*ssnext);
-    bool ci = (*ssnext) == (*ssi);
-    if (c != ci) {
+
+    if (!states.validate()) {
       pgraph_cat.error()
-        << "TransformState::operator == () not defined properly!\n";
-      pgraph_cat.error(false)
-        << "(a, b): " << c << "\n";
-      pgraph_cat.error(false)
-        << "(b, a): " << ci << "\n";
-      ssi->write(pgraph_cat.error(false), 2);
-      ssnext->write(pgraph_cat.error(false), 2);
+        << "TransformState::_states cache is invalid!\n";
       return false;
     }
-    si = snext;
+
+    size_t size = states.get_num_entries();
+    size_t si = 0;
+    nassertr(si < size, false);
+    nassertr(states.get_key(si)->get_ref_count() >= 0, false);
+    size_t snext = si;
     ++snext;
+    while (snext < size) {
+      nassertr(states.get_key(snext)->get_ref_count() >= 0, false);
+      const TransformState *ssi = states.get_key(si);
+      if (!ssi->validate_composition_cache()) {
+        return false;
+      }
+      const TransformState *ssnext = states.get_key(snext);
+      bool c = (*ssi) == (*ssnext);
+      bool ci = (*ssnext) == (*ssi);
+      if (c != ci) {
+        pgraph_cat.error()
+          << "TransformState::operator == () not defined properly!\n";
+        pgraph_cat.error(false)
+          << "(a, b): " << c << "\n";
+        pgraph_cat.error(false)
+          << "(b, a): " << ci << "\n";
+        ssi->write(pgraph_cat.error(false), 2);
+        ssnext->write(pgraph_cat.error(false), 2);
+        return false;
+      }
+      si = snext;
+      ++snext;
+    }
+
   }
 
   return true;
@@ -1419,6 +1563,11 @@ init_states() {
   // OK because we guarantee that this method is called at static init time,
   // presumably when there is still only one thread in the world.
   _states_lock = new LightReMutex("TransformState::_states_lock");
+  for (StatesShard &shard : _states_shards) {
+    shard._lock = new ReMutex("TransformState::StatesShard::_lock");
+    shard._garbage_index = 0;
+    shard._num_sweeps = 0;
+  }
   _cache_stats.init();
   nassertv(Thread::get_current_thread() == Thread::get_main_thread());
 }
@@ -1465,36 +1614,57 @@ return_unique(TransformState *state) {
 
   PStatTimer timer(_transform_new_pcollector);
 
-  LightReMutexHolder holder(*_states_lock);
-
-  if (state->_saved_entry != -1) {
-    // This state is already in the cache.  nassertr(_states.find(state) ==
-    // state->_saved_entry, state);
-    return state;
-  }
-
   // Save the state in a local PointerTo so that it will be freed at the end
-  // of this function if no one else uses it.
+  // of this function if no one else uses it.  This must be released after
+  // the locks are, since the destructor needs to grab _states_lock.
   CPT(TransformState) pt_state = state;
 
-  int si = _states.find(state);
-  if (si != -1) {
-    // There's an equivalent state already in the set.  Return it.
-    return _states.get_key(si);
+  // If we are not garbage collecting, a state may be removed from the set as
+  // soon as its reference count drops to zero, which happens while holding
+  // _states_lock, so we must hold it as well.  Otherwise, states are only
+  // removed by garbage_collect(), which also holds the lock of the shard.
+  if (!garbage_collect_states) {
+    _states_lock->acquire();
   }
 
-  // Not already in the set; add it.
-  if (garbage_collect_states) {
-    // If we'll be garbage collecting states explicitly, we'll increment the
-    // reference count when we store it in the cache, so that it won't be
-    // deleted while it's in it.
-    state->cache_ref();
+  StatesShard &shard = get_states_shard(state->get_hash());
+  if (!shard._lock->try_acquire()) {
+    _contention_pcollector.add_level(1);
+    shard._lock->acquire();
   }
-  si = _states.store(state, nullptr);
 
-  // Save the index and return the input state.
-  state->_saved_entry = si;
-  return pt_state;
+  CPT(TransformState) result;
+  if (state->_saved_entry != -1) {
+    // This state is already in the cache.
+    result = state;
+
+  } else {
+    int si = shard._states.find(state);
+    if (si != -1) {
+      // There's an equivalent state already in the set.  Return it.
+      result = shard._states.get_key(si);
+
+    } else {
+      // Not already in the set; add it.
+      if (garbage_collect_states) {
+        // If we'll be garbage collecting states explicitly, we'll increment
+        // the reference count when we store it in the cache, so that it
+        // won't be deleted while it's in it.
+        state->cache_ref();
+      }
+      si = shard._states.store(state, 0);
+
+      // Save the index and return the input state.
+      state->_saved_entry = si;
+      result = state;
+    }
+  }
+
+  shard._lock->release();
+  if (!garbage_collect_states) {
+    _states_lock->release();
+  }
+  return result;
 }
 
 /**
@@ -1877,8 +2047,10 @@ release_new() {
   nassertv(_states_lock->debug_is_locked());
 
   if (_saved_entry != -1) {
+    StatesShard &shard = get_states_shard(get_hash());
+    ReMutexHolder shard_holder(*shard._lock);
     _saved_entry = -1;
-    nassertv_always(_states.remove(this));
+    nassertv_always(shard._states.remove(this));
   }
 }
 
@@ -1935,7 +2107,12 @@ remove_cache_pointers() {
     // Now we can remove the element from our cache.  We do this now, rather
     // than later, before any other TransformState objects have had a chance
     // to destruct, so we are confident that our iterator is still valid.
-    _composition_cache.remove_element(i);
+    // The _cache_lock must not be held while releasing the results, since
+    // that may cause other states to destruct.
+    {
+      LightMutexHolder cache_holder(_cache_lock);
+      _composition_cache.remove_element(i);
+    }
     _cache_stats.add_total_size(-1);
     _cache_stats.inc_dels();
 
@@ -1948,7 +2125,10 @@ remove_cache_pointers() {
         // Hold a copy of the other composition result, too.
         Composition ocomp = other->_composition_cache.get_data(oi);
 
-        other->_composition_cache.remove_element(oi);
+        {
+          LightMutexHolder cache_holder(other->_cache_lock);
+          other->_composition_cache.remove_element(oi);
+        }
         _cache_stats.add_total_size(-1);
         _cache_stats.inc_dels();
 
@@ -1974,14 +2154,20 @@ remove_cache_pointers() {
     TransformState *other = (TransformState *)_invert_composition_cache.get_key(i);
     nassertv(other != this);
     Composition comp = _invert_composition_cache.get_data(i);
-    _invert_composition_cache.remove_element(i);
+    {
+      LightMutexHolder cache_holder(_cache_lock);
+      _invert_composition_cache.remove_element(i);
+    }
     _cache_stats.add_total_size(-1);
     _cache_stats.inc_dels();
     if (other != this) {
       int oi = other->_invert_composition_cache.find(this);
       if (oi != -1) {
         Composition ocomp = other->_invert_composition_cache.get_data(oi);
-        other->_invert_composition_cache.remove_element(oi);
+        {
+          LightMutexHolder cache_holder(other->_cache_lock);
+          other->_invert_composition_cache.remove_element(oi);
+        }
         _cache_stats.add_total_size(-1);
         _cache_stats.inc_dels();
         if (ocomp._result != nullptr && ocomp._result != other) {
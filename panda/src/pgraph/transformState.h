@@ -27,6 +27,7 @@
 #include "lightReMutexHolder.h"
 #include "lightMutex.h"
 #include "lightMutexHolder.h"
+#include "reMutex.h"
 #include "config_pgraph.h"
 #include "deletedChain.h"
 #include "simpleHashMap.h"
@@ -255,12 +256,37 @@ private:
   void remove_cache_pointers();
 
 private:
-  // This mutex protects _states.  It also protects any modification to the
-  // cache, which is encoded in _composition_cache and
-  // _invert_composition_cache.
+  // This mutex protects any modification to the cache, which is encoded in
+  // _composition_cache and _invert_composition_cache.  It must also be held
+  // while removing a state from the set of unique states.
   static LightReMutex *_states_lock;
-  typedef SimpleHashMap<const TransformState *, std::nullptr_t, indirect_equals_hash<const TransformState *> > States;
-  static States _states;
+  // The value associated with each state is the number of consecutive
+  // garbage collection sweeps it has survived, up to
+  // garbage-collect-states-old-age.
+  typedef SimpleHashMap<const TransformState *, unsigned int, indirect_equals_hash<const TransformState *> > States;
+
+  // The set of unique states is divided into a number of shards according
+  // to the hash of the state, each with its own lock, so that threads that
+  // are creating unrelated states don't have to wait for each other.  If both
+  // are needed, _states_lock must be acquired before a shard's lock.
+  class StatesShard {
+  public:
+    ReMutex *_lock;
+    States _states;
+
+    // This keeps track of our current position through the garbage
+    // collection cycle, and how many times we have gone all the way around.
+    size_t _garbage_index;
+    unsigned int _num_sweeps;
+  };
+  enum { num_states_shards = 16 };
+  static StatesShard _states_shards[num_states_shards];
+  INLINE static StatesShard &get_states_shard(size_t hash);
+  static bool garbage_collect_shard(StatesShard &shard, double deadline,
+                                    int &num_collected);
+
+  // The shard at which the next garbage collection pass begins.
+  static size_t _garbage_shard;
   static CPT(TransformState) _identity_state;
   static CPT(TransformState) _invalid_state;
 
@@ -297,10 +323,6 @@ private:
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
 
-  // This keeps track of our current position through the garbage collection
-  // cycle.
-  static size_t _garbage_index;
-
   static bool _uniquify_matrix;
 
   static PStatCollector _cache_update_pcollector;
@@ -315,6 +337,10 @@ private:
 
   static PStatCollector _node_counter;
   static PStatCollector _cache_counter;
+  static PStatCollector _cache_hit_pcollector;
+  static PStatCollector _cache_miss_pcollector;
+  static PStatCollector _contention_pcollector;
+  static PStatCollector _reclaimed_pcollector;
 
 private:
   // This is the actual data within the TransformState.
@@ -379,6 +405,10 @@ private:
   // This mutex protects _flags, and all of the above computed values.
   LightMutex _lock;
 
+  // This mutex allows the composition caches to be read without holding
+  // _states_lock.  Modifying the caches requires holding both.
+  LightMutex _cache_lock;
+
   static CacheStats _cache_stats;
 
 public:
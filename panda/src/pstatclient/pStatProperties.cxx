@@ -215,6 +215,16 @@ static LevelCollectorProperties level_properties[] = {
   { 1, "RenderStates:On nodes",            { 0.2, 0.8, 1.0 } },
   { 1, "RenderStates:Cached",              { 1.0, 0.0, 0.2 } },
   { 1, "RenderStates:Unused",              { 0.2, 0.2, 0.2 } },
+  { 1, "State cache operations",           { 0.4, 0.7, 0.7 },  "", 5000 },
+  { 1, "State cache operations:Transform hit",        { 0.2, 0.8, 1.0 } },
+  { 1, "State cache operations:Transform miss",       { 1.0, 0.0, 0.2 } },
+  { 1, "State cache operations:Transform contention", { 0.8, 0.8, 0.2 } },
+  { 1, "State cache operations:Render hit",           { 0.2, 0.4, 0.8 } },
+  { 1, "State cache operations:Render miss",          { 0.8, 0.2, 0.4 } },
+  { 1, "State cache operations:Render contention",    { 0.6, 0.6, 0.0 } },
+  { 1, "State cache operations:Transform reclaimed",  { 0.6, 0.2, 0.8 } },
+  { 1, "State cache operations:Render reclaimed",     { 0.8, 0.4, 0.0 } },
+  { 1, "State cache operations:Attrib reclaimed",     { 0.4, 0.4, 0.4 } },
   { 1, "PipelineCyclers",                  { 0.5, 0.5, 1.0 },  "", 50000 },
   { 1, "Dirty PipelineCyclers",            { 0.2, 0.2, 0.2 },  "", 5000 },
   { 1, "Collision Volumes",                { 1.0, 0.8, 0.5 },  "", 500 },
@@ -59,6 +59,11 @@ PUBLISHED:
     // May appear at any level and indicates the following datagram contains
     // auxiliary file data that may be referenced by a later object.
     BOC_file_data,
+
+    // May appear at any level and indicates the following datagram contains
+    // a block of raw data, positioned at an aligned offset within the file,
+    // that will be claimed by a later object.
+    BOC_aligned_data,
   };
 
   // This enum is used to control how textures are written to a bam stream.
@@ -19,6 +19,8 @@
 #include "datagramIterator.h"
 #include "config_putil.h"
 #include "pipelineCyclerBase.h"
+#include "mutexHolder.h"
+#include "virtualFile.h"
 
 using std::string;
 
@@ -33,13 +35,60 @@ BamReader::NewTypes BamReader::_new_types;
 const int BamReader::_cur_major = _bam_major_ver;
 const int BamReader::_cur_minor = _bam_minor_ver;
 
+BamReader::DecodeThreadManager *BamReader::_decode_mgr = nullptr;
+Mutex &BamReader::_decode_lock = *(new Mutex("BamReader::_decode_lock"));
+
+/**
+ * A DecodeJob that simply copies a block of bytes out of a datagram.  The
+ * job holds a reference to the datagram's buffer, so that it remains valid
+ * after the BamReader has moved on to the next datagram, as well as to the
+ * object that owns the destination buffer, so that the destination remains
+ * valid even if the object being read is thrown away before resolve().
+ */
+class ExtractBytesJob : public BamReader::DecodeJob {
+public:
+  ExtractBytesJob(const Datagram &datagram, size_t start,
+                  unsigned char *into, size_t size, ReferenceCount *owner) :
+    _datagram(datagram),
+    _start(start),
+    _into(into),
+    _size(size),
+    _owner(owner)
+  {
+  }
+
+  ExtractBytesJob(const Datagram &datagram, size_t start,
+                  const PTA_uchar &into) :
+    _datagram(datagram),
+    _start(start),
+    _into(into.p()),
+    _size(into.size()),
+    _into_array(into)
+  {
+  }
+
+  virtual void do_decode() {
+    memcpy(_into, (const unsigned char *)_datagram.get_data() + _start, _size);
+  }
+
+private:
+  Datagram _datagram;
+  size_t _start;
+  unsigned char *_into;
+  size_t _size;
+  PT(ReferenceCount) _owner;
+  PTA_uchar _into_array;
+};
+
 
 /**
  *
  */
 BamReader::
 BamReader(DatagramGenerator *source)
-  : _source(source)
+  : _source(source),
+    _num_pending_decodes(0),
+    _decode_cvar(_decode_lock)
 {
   _needs_init = true;
   _num_extra_objects = 0;
@@ -49,6 +98,7 @@ BamReader(DatagramGenerator *source)
   _pta_id = -1;
   _long_object_id = false;
   _long_pta_id = false;
+  _tried_source_mapping = false;
 }
 
 
@@ -57,6 +107,9 @@ BamReader(DatagramGenerator *source)
  */
 BamReader::
 ~BamReader() {
+  // Any jobs still running refer to objects that we are about to release.
+  wait_decode();
+
   nassertv(_num_extra_objects == 0);
   nassertv(_nesting_level == 0);
 }
@@ -323,6 +376,10 @@ read_object(TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
  */
 bool BamReader::
 resolve() {
+  // Objects may still be decoding their data; they must be finished before
+  // anyone gets a chance to look at them.
+  wait_decode();
+
   bool all_completed;
   bool any_completed_this_pass;
 
@@ -685,6 +742,139 @@ read_file_data(SubfileInfo &info) {
   _file_data_records.pop_front();
 }
 
+/**
+ * Reads a block of raw data that was written by a matching call to
+ * BamWriter::write_aligned_data().  On success, fills in data and size to
+ * reference the block, and returns true.
+ *
+ * If the block could be mapped directly from the source file, mapping is set
+ * to the mapping that contains the data, and the data remains valid for as
+ * long as the caller holds on to it.  Otherwise, mapping is set to nullptr,
+ * and the data is only valid until the next call to read_aligned_data(), so
+ * the caller must copy it.
+ */
+bool BamReader::
+read_aligned_data(CPT(MappedFile) &mapping,
+                  const unsigned char *&data, size_t &size) {
+  // As with read_file_data(), the blocks were already encountered in the
+  // stream before the datagram of the object requesting them.
+  nassertr(!_aligned_data_records.empty(), false);
+  AlignedDataRecord &record = _aligned_data_records.front();
+
+  if (record._data != nullptr) {
+    mapping = _source_mapping;
+    data = record._data;
+    size = record._size;
+  } else {
+    _aligned_data_buffer = std::move(record._datagram);
+    mapping = nullptr;
+    data = (const unsigned char *)_aligned_data_buffer.get_data();
+    size = _aligned_data_buffer.get_length();
+  }
+
+  _aligned_data_records.pop_front();
+  return true;
+}
+
+/**
+ * Hands the indicated job off to be run on one of the decode threads, if
+ * bam-decode-num-threads is nonzero; otherwise, runs it immediately.  This is
+ * intended to be called from within fillin(), to defer the decoding of a
+ * large block of data while the BamReader continues to read the rest of the
+ * file.
+ *
+ * The job is guaranteed to have finished before resolve() begins completing
+ * pointers, so the object may not look at its data before then.
+ */
+void BamReader::
+queue_decode(DecodeJob *job) {
+  nassertv(job != nullptr && job->_reader == nullptr);
+
+  int num_threads = bam_decode_num_threads;
+  if (num_threads <= 0 || !Thread::is_threading_supported()) {
+    PT(DecodeJob) hold = job;
+    job->do_decode();
+    return;
+  }
+
+  MutexHolder holder(_decode_lock);
+  DecodeThreadManager *mgr = get_decode_mgr();
+  mgr->start_threads(num_threads);
+
+  job->_reader = this;
+  ++_num_pending_decodes;
+  mgr->_pending_jobs.push_back(job);
+  mgr->_pending_cvar.notify();
+}
+
+/**
+ * Copies the indicated number of bytes from the current position of the
+ * DatagramIterator into the indicated buffer, and advances the iterator past
+ * them.  This is equivalent to scan.extract_bytes(), except that a large
+ * enough block may be copied later, on a decode thread; see queue_decode().
+ *
+ * The buffer must belong to the indicated owner, which is kept alive until
+ * the copy has been made.
+ */
+void BamReader::
+extract_bytes(unsigned char *into, DatagramIterator &scan, size_t size,
+              ReferenceCount *owner) {
+  nassertv(size <= scan.get_remaining_size());
+
+  if (bam_decode_num_threads <= 0 ||
+      size < (size_t)std::max((int)bam_decode_min_size, 1)) {
+    scan.extract_bytes(into, size);
+    return;
+  }
+
+  queue_decode(new ExtractBytesJob(scan.get_datagram(),
+                                   scan.get_current_index(), into, size, owner));
+  scan.skip_bytes(size);
+}
+
+/**
+ * Fills the indicated array with as many bytes as it holds, from the current
+ * position of the DatagramIterator, as above.  The array is kept alive until
+ * the copy has been made.
+ */
+void BamReader::
+extract_bytes(const PTA_uchar &into, DatagramIterator &scan) {
+  size_t size = into.size();
+  nassertv(size <= scan.get_remaining_size());
+
+  if (bam_decode_num_threads <= 0 ||
+      size < (size_t)std::max((int)bam_decode_min_size, 1)) {
+    scan.extract_bytes(into.p(), size);
+    return;
+  }
+
+  queue_decode(new ExtractBytesJob(scan.get_datagram(),
+                                   scan.get_current_index(), into));
+  scan.skip_bytes(size);
+}
+
+/**
+ * Blocks until all of the jobs passed to queue_decode() by this BamReader
+ * have finished.  Rather than sitting idle, the calling thread helps out with
+ * any jobs that have not yet been started.  This is called implicitly by
+ * resolve().
+ */
+void BamReader::
+wait_decode() {
+  MutexHolder holder(_decode_lock);
+  while (_num_pending_decodes > 0) {
+    nassertv(_decode_mgr != nullptr);
+    DecodeThreadManager::PendingJobs &jobs = _decode_mgr->_pending_jobs;
+    if (!jobs.empty()) {
+      PT(DecodeJob) job = jobs.front();
+      jobs.pop_front();
+      run_decode_job(job);
+    } else {
+      _decode_cvar.wait();
+    }
+  }
+}
+
 /**
  * Reads in the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
@@ -1111,6 +1301,17 @@ p_read_object() {
 
     return p_read_object();
 
+  case BOC_aligned_data:
+    // A block of data for a future object, as above, but one that we should
+    // try to map into memory rather than read.
+    if (!read_aligned_data_record()) {
+      bam_cat.error()
+        << "Failed to read aligned data.\n";
+      return 0;
+    }
+
+    return p_read_object();
+
   default:
     bam_cat.error()
       << "Encountered invalid BamObjectCode 0x" << std::hex << (int)boc << std::dec << ".\n";
@@ -1297,6 +1498,116 @@ p_read_object() {
   return object_id;
 }
 
+/**
+ * Reads the datagram following a BOC_aligned_data marker and queues it up for
+ * a future call to read_aligned_data().  If the source file can be mapped into
+ * memory, the data is not actually read, but merely skipped over.  Returns
+ * true on success, false on failure.
+ */
+bool BamReader::
+read_aligned_data_record() {
+  if (!_tried_source_mapping) {
+    map_source();
+  }
+
+  AlignedDataRecord record;
+  if (_source_mapping != nullptr) {
+    SubfileInfo info;
+    if (!_source->save_datagram(info)) {
+      return false;
+    }
+    size_t start = (size_t)info.get_start();
+    record._size = (size_t)info.get_size();
+    if (start + record._size > _source_mapping->get_size()) {
+      bam_cat.error()
+        << "Aligned data extends past the end of "
+        << _source_mapping->get_filename() << ".\n";
+      return false;
+    }
+    record._data = _source_mapping->get_data() + start;
+
+  } else {
+    if (!_source->get_datagram(record._datagram)) {
+      return false;
+    }
+    record._data = nullptr;
+    record._size = record._datagram.get_length();
+  }
+
+  _aligned_data_records.push_back(std::move(record));
+  return true;
+}
+
+/**
+ * Attempts to map the source file into memory, so that aligned data blocks
+ * can be referenced in place.  This is only possible if the source is an
+ * uncompressed file (or an uncompressed subfile of a Multifile) on disk.  If
+ * this fails, the data blocks will be read normally instead.
+ */
+void BamReader::
+map_source() {
+  _tried_source_mapping = true;
+
+  if (!bam_map_aligned_data) {
+    return;
+  }
+
+  VirtualFile *vfile = _source->get_vfile();
+  if (vfile == nullptr || _source->get_file() == nullptr) {
+    return;
+  }
+
+  // A compressed file is transparently decompressed as we read it, so the
+  // offsets within the stream don't correspond to the offsets on disk.
+  std::string extension = vfile->get_filename().get_extension();
+  if (extension == "pz" || extension == "gz") {
+    return;
+  }
+  // If the file is in a mapped Multifile, this returns a view into the
+  // Multifile's existing mapping.
+  PT(MappedFile) mapping = vfile->map_file();
+  if (mapping == nullptr) {
+    return;
+  }
+
+  if (bam_cat.is_debug()) {
+    bam_cat.debug()
+      << "Mapped " << mapping->get_size() << " bytes of "
+      << mapping->get_filename() << " for aligned data.\n";
+  }
+  _source_mapping = mapping;
+}
+
+/**
+ * Returns the manager of the decode threads shared by all BamReaders,
+ * creating it if necessary.  Assumes _decode_lock is held.
+ */
+BamReader::DecodeThreadManager *BamReader::
+get_decode_mgr() {
+  if (_decode_mgr == nullptr) {
+    _decode_mgr = new DecodeThreadManager;
+  }
+  return _decode_mgr;
+}
+
+/**
+ * Runs the indicated job, which has already been removed from the queue, and
+ * notifies its BamReader if it was the last one outstanding.  Assumes
+ * _decode_lock is held; it is released while the job runs.
+ */
+void BamReader::
+run_decode_job(DecodeJob *job) {
+  _decode_lock.release();
+  job->do_decode();
+  _decode_lock.acquire();
+
+  BamReader *reader = job->_reader;
+  nassertv(reader != nullptr && reader->_num_pending_decodes > 0);
+  if (--reader->_num_pending_decodes == 0) {
+    reader->_decode_cvar.notify_all();
+  }
+}
+
 /**
  * Checks whether all of the pointers a particular object is waiting for have
  * been filled in yet.  If they have, calls complete_pointers() on the object
@@ -1546,3 +1857,59 @@ finalize() {
     }
   }
 }
+
+/**
+ *
+ */
+BamReader::DecodeThread::
+DecodeThread(const string &name) :
+  Thread(name, name)
+{
+}
+
+/**
+ * The main processing loop for each decode thread.  The threads run for the
+ * lifetime of the process, waiting for jobs to be queued.
+ */
+void BamReader::DecodeThread::
+thread_main() {
+  MutexHolder holder(_decode_lock);
+  DecodeThreadManager::PendingJobs &jobs = _decode_mgr->_pending_jobs;
+
+  while (true) {
+    while (jobs.empty()) {
+      _decode_mgr->_pending_cvar.wait();
+    }
+
+    PT(DecodeJob) job = jobs.front();
+    jobs.pop_front();
+    run_decode_job(job);
+  }
+}
+
+/**
+ *
+ */
+BamReader::DecodeThreadManager::
+DecodeThreadManager() :
+  _pending_cvar(_decode_lock)
+{
+}
+
+/**
+ * Starts up additional threads, if necessary, so that there are at least the
+ * indicated number of decode threads running.  Assumes _decode_lock is held.
+ */
+void BamReader::DecodeThreadManager::
+start_threads(int num_threads) {
+  while ((int)_threads.size() < num_threads) {
+    std::ostringstream name_strm;
+    name_strm << "BamDecode_" << _threads.size();
+    PT(DecodeThread) thread = new DecodeThread(name_strm.str());
+    if (!thread->start(TP_normal, false)) {
+      // Never mind; wait_decode() will take up the slack.
+      break;
+    }
+    _threads.push_back(thread);
+  }
+}
@@ -34,6 +34,11 @@
 #include "dcast.h"
 #include "pipelineCyclerBase.h"
 #include "referenceCount.h"
+#include "mappedFile.h"
+#include "pta_uchar.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "conditionVar.h"
 
 #include <algorithm>
 
@@ -167,6 +172,15 @@ public:
   void skip_pointer(DatagramIterator &scan);
 
   void read_file_data(SubfileInfo &info);
+  bool read_aligned_data(CPT(MappedFile) &mapping,
+                         const unsigned char *&data, size_t &size);
+
+  class DecodeJob;
+  void queue_decode(DecodeJob *job);
+  void extract_bytes(unsigned char *into, DatagramIterator &scan, size_t size,
+                     ReferenceCount *owner);
+  void extract_bytes(const PTA_uchar &into, DatagramIterator &scan);
+  void wait_decode();
 
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler);
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler,
@@ -214,6 +228,8 @@ private:
   int read_object_id(DatagramIterator &scan);
   int read_pta_id(DatagramIterator &scan);
   int p_read_object();
+  bool read_aligned_data_record();
+  void map_source();
   bool resolve_object_pointers(TypedWritable *object, PointerReference &pref);
   bool resolve_cycler_pointers(PipelineCyclerBase *cycler, const vector_int &pointer_ids,
                                bool require_fully_complete);
@@ -221,6 +237,10 @@ private:
 
   INLINE bool get_datagram(Datagram &datagram);
 
+  class DecodeThreadManager;
+  static DecodeThreadManager *get_decode_mgr();
+  static void run_decode_job(DecodeJob *job);
+
 public:
   // Inherit from this class to piggyback additional temporary data on the
   // bamReader (via set_aux_data() and get_aux_data()) for any particular
@@ -231,6 +251,23 @@ public:
     virtual ~AuxData() = default;
   };
 
+  // Inherit from this class to perform the expensive part of reading an
+  // object, such as decoding a large block of data, on a decode thread.  The
+  // job may be started at any time after it is passed to queue_decode(), and
+  // is guaranteed to have finished before resolve() completes any pointers.
+  // It must not touch anything other than the data it was given.
+  class EXPCL_PANDA_PUTIL DecodeJob : public ReferenceCount {
+  public:
+    INLINE DecodeJob();
+    virtual ~DecodeJob() = default;
+
+    virtual void do_decode()=0;
+
+  private:
+    BamReader *_reader;
+    friend class BamReader;
+  };
+
 private:
   static WritableFactory *_factory;
 
@@ -321,6 +358,54 @@ private:
   typedef pdeque<SubfileInfo> FileDataRecords;
   FileDataRecords _file_data_records;
 
+  // Similarly, this is the queue of aligned data blocks.  If the source file
+  // could be mapped into memory, each block merely points into the mapping;
+  // otherwise, it holds a copy of the data.
+  class AlignedDataRecord {
+  public:
+    const unsigned char *_data;
+    size_t _size;
+    Datagram _datagram;
+  };
+  typedef pdeque<AlignedDataRecord> AlignedDataRecords;
+  AlignedDataRecords _aligned_data_records;
+  Datagram _aligned_data_buffer;
+  CPT(MappedFile) _source_mapping;
+  bool _tried_source_mapping;
+
+  // The number of our DecodeJobs that have not yet finished.  This is
+  // protected by _decode_lock, and _decode_cvar is signaled when it drops to
+  // zero.
+  int _num_pending_decodes;
+  ConditionVar _decode_cvar;
+
+  // The decode threads are shared by all BamReaders.
+  class DecodeThread : public Thread {
+  public:
+    DecodeThread(const std::string &name);
+
+  protected:
+    virtual void thread_main();
+  };
+
+  class DecodeThreadManager {
+  public:
+    DecodeThreadManager();
+    void start_threads(int num_threads);
+
+    typedef pdeque<PT(DecodeJob)> PendingJobs;
+    PendingJobs _pending_jobs;
+
+    // Signaled when a new job is added to _pending_jobs.
+    ConditionVar _pending_cvar;
+
+    typedef pvector<PT(DecodeThread)> DecodeThreads;
+    DecodeThreads _threads;
+  };
+
+  static DecodeThreadManager *_decode_mgr;
+  static Mutex &_decode_lock;  // Protects _decode_mgr and all of its members.
+
   // This is used internally to record all of the new types created on-the-fly
   // to satisfy bam requirements.  We keep track of this just so we can
   // suppress warning messages from attempts to create objects of these types.
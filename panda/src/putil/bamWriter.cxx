@@ -100,6 +100,7 @@ BamWriter(DatagramSink *target) :
   _file_endian = bam_endian;
   _file_stdfloat_double = bam_stdfloat_double;
   _file_texture_mode = bam_texture_mode;
+  _aligned_data_threshold = (size_t)std::max((int)bam_aligned_data_threshold, 0);
 }
 
 /**
@@ -415,6 +416,48 @@ write_file_data(SubfileInfo &result, const SubfileInfo &source) {
   // order and queued up in the BamReader.
 }
 
+/**
+ * Writes a block of raw data as a separate datagram, positioned so that the
+ * data begins on a page boundary within the output file.  This must be
+ * balanced by a matching call to BamReader::read_aligned_data() on restore.
+ *
+ * Returns true if the data was written, or false if the data should instead
+ * be written inline because it is smaller than the aligned data threshold,
+ * or because aligned data is not supported by the bam version being written.
+ */
+bool BamWriter::
+write_aligned_data(const void *data, size_t size) {
+  if (_aligned_data_threshold == 0 || size < _aligned_data_threshold ||
+      _file_minor < 46) {
+    return false;
+  }
+
+  // Like write_file_data(), this is preceded by a datagram containing only
+  // the BOC_aligned_data token.  We pad that datagram out so that the data in
+  // the following datagram begins on an aligned offset.  The length of each
+  // datagram is written as a 32-bit number, or as 0xffffffff followed by a
+  // 64-bit number for very large datagrams.
+  static const size_t alignment = 4096;
+  size_t header_size = (size == (uint32_t)-1 || size != (uint32_t)size) ? 12 : 4;
+  size_t start = (size_t)_target->get_file_pos() + 4 + 1 + header_size;
+  size_t padding = (alignment - (start % alignment)) % alignment;
+
+  Datagram dg;
+  dg.add_uint8(BOC_aligned_data);
+  dg.pad_bytes(padding);
+  if (!_target->put_datagram(dg)) {
+    util_cat.error()
+      << "Unable to write data to output.\n";
+    return true;
+  }
+
+  if (!_target->put_datagram(Datagram(data, size))) {
+    util_cat.error()
+      << "Unable to write aligned data to output.\n";
+  }
+  return true;
+}
+
 /**
  * Writes out the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
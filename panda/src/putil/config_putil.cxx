@@ -89,6 +89,37 @@ ConfigVariableEnum<BamEnums::BamTextureMode> bam_texture_mode
  PRC_DESC("Set this to specify how textures should be written into Bam files."
           "See the panda source or documentation for available options."));
 
+ConfigVariableInt bam_aligned_data_threshold
+("bam-aligned-data-threshold", 0,
+ PRC_DESC("Set this to a nonzero number of bytes to write vertex and index "
+          "arrays at least this large into bam files as separate blocks, "
+          "aligned to a page boundary within the file, so that they may be "
+          "mapped directly into memory when the file is loaded.  This "
+          "requires writing bam version 6.46 or later; see bam-version.  "
+          "Set this to 0 to store all arrays inline."));
+
+ConfigVariableBool bam_map_aligned_data
+("bam-map-aligned-data", true,
+ PRC_DESC("When this is true, aligned data blocks in a bam file (see "
+          "bam-aligned-data-threshold) are mapped into memory directly from "
+          "the file when possible, rather than being read and copied.  This "
+          "is only possible for uncompressed files on disk or in an "
+          "uncompressed, unencrypted Multifile subfile."));
+
+ConfigVariableInt bam_decode_num_threads
+("bam-decode-num-threads", 0,
+ PRC_DESC("The number of worker threads that BamReader may use to decode "
+          "the bulk data of large objects, such as vertex arrays and texture "
+          "images, while the reading thread continues on through the rest of "
+          "the file.  Set this to 0 to decode everything on the reading "
+          "thread."));
+
+ConfigVariableInt bam_decode_min_size
+("bam-decode-min-size", 65536,
+ PRC_DESC("The minimum size in bytes of a block of object data that will be "
+          "handed off to a decode thread when bam-decode-num-threads is "
+          "nonzero.  Smaller blocks are decoded immediately."));
+
 ConfigureFn(config_putil) {
   init_libputil();
 }
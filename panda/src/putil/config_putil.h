@@ -39,6 +39,10 @@ extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_version;
 extern EXPCL_PANDA_PUTIL ConfigVariableEnum<BamEnums::BamEndian> bam_endian;
 extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_stdfloat_double;
 extern EXPCL_PANDA_PUTIL ConfigVariableEnum<BamEnums::BamTextureMode> bam_texture_mode;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_aligned_data_threshold;
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_map_aligned_data;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_decode_num_threads;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_decode_min_size;
 
 BEGIN_PUBLISH
 EXPCL_PANDA_PUTIL ConfigVariableSearchPath &get_model_path();
@@ -0,0 +1,82 @@
+from panda3d import core
+import pytest
+
+
+BIND_FLAGS = core.PartGroup.HMF_ok_wrong_root_name
+
+
+def make_character(name, num_frames=10):
+    """ Returns a Character with a single joint, and an AnimBundle that moves
+    the joint along the X axis by one unit per frame. """
+
+    char = core.Character(name)
+    bundle = char.get_bundle(0)
+    skeleton = core.PartGroup(bundle, "<skeleton>")
+    joint = core.CharacterJoint(char, bundle, skeleton, "joint", core.Mat4.ident_mat())
+
+    anim = core.AnimBundle(name, 24, num_frames)
+    anim_skeleton = core.AnimGroup(anim, "<skeleton>")
+    table = core.AnimChannelMatrixXfmTable(anim_skeleton, "joint")
+    table.set_table('x', core.CPTA_float([float(i) for i in range(num_frames)]))
+    return char, joint, anim
+
+
+@pytest.fixture
+def anim_threads():
+    var = core.ConfigVariableInt("anim-update-num-threads")
+    old_value = var.value
+    yield var
+    var.value = old_value
+
+
+@pytest.mark.parametrize("num_threads", [0, 2])
+def test_part_bundle_update_all(anim_threads, num_threads):
+    anim_threads.value = num_threads
+    core.PartBundle.update_all()
+
+    characters = []
+    for i in range(8):
+        char, joint, anim = make_character("char%d" % i)
+        control = char.get_bundle(0).bind_anim(anim, BIND_FLAGS)
+        assert control is not None
+        control.pose(i)
+        characters.append((char, joint, control))
+
+    # Every posed bundle is brought up to date by a single call.
+    assert core.PartBundle.update_all() >= len(characters)
+    for i, (char, joint, control) in enumerate(characters):
+        assert joint.get_transform().get_row3(3).almost_equal((i, 0, 0))
+
+        # There is nothing left for update() to do.
+        assert not char.get_bundle(0).update()
+
+    # Nothing has changed since the last call.
+    assert core.PartBundle.update_all() == 0
+
+    # A bundle is only updated once per frame, so advance the clock.
+    characters[3][2].pose(7)
+    core.ClockObject.get_global_clock().tick()
+    assert core.PartBundle.update_all() == 1
+    assert characters[3][1].get_transform().get_row3(3).almost_equal((7, 0, 0))
+
+
+def test_part_bundle_update_all_prune():
+    core.PartBundle.update_all()
+    num_bundles = core.PartBundle.get_num_animated_bundles()
+
+    char, joint, anim = make_character("prune")
+    assert core.PartBundle.get_num_animated_bundles() == num_bundles
+
+    # Binding and posing an animation adds the bundle to the list.
+    control = char.get_bundle(0).bind_anim(anim, BIND_FLAGS)
+    control.pose(3)
+    assert core.PartBundle.get_num_animated_bundles() == num_bundles + 1
+
+    core.PartBundle.update_all()
+    assert joint.get_transform().get_row3(3).almost_equal((3, 0, 0))
+
+    # Once the bundle is gone, the next call to update_all() drops it.
+    del control, joint, char
+    assert core.PartBundle.get_num_animated_bundles() == num_bundles + 1
+    core.PartBundle.update_all()
+    assert core.PartBundle.get_num_animated_bundles() == num_bundles
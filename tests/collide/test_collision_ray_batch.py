@@ -0,0 +1,120 @@
+from panda3d import core
+import pytest
+
+
+def make_scene(num_spheres):
+    root = core.NodePath("root")
+
+    cnode = core.CollisionNode("spheres")
+    for i in range(num_spheres):
+        cnode.add_solid(core.CollisionSphere(i * 3, 0, 0, 1))
+    root.attach_new_node(cnode)
+
+    poly = core.CollisionNode("poly")
+    poly.add_solid(core.CollisionPolygon(
+        core.Point3(-1, 10, -1), core.Point3(1, 10, -1),
+        core.Point3(1, 10, 1), core.Point3(-1, 10, 1)))
+    np = root.attach_new_node(poly)
+    np.set_pos(0, -5, 0)
+    return root
+
+
+@pytest.mark.parametrize("num_spheres", [1, 20])
+def test_ray_batch_spheres(num_spheres):
+    root = make_scene(num_spheres)
+
+    batch = core.CollisionRayBatch()
+    for i in range(num_spheres):
+        batch.add_ray((i * 3, 0, 10), (0, 0, -1))
+    batch.add_ray((-10, -10, 10), (0, 0, 1))
+    assert batch.get_num_rays() == num_spheres + 1
+
+    assert batch.traverse(root) == num_spheres
+    for i in range(num_spheres):
+        assert batch.has_hit(i)
+        assert batch.get_hit_t(i) == pytest.approx(9)
+        assert batch.get_hit_pos(i).almost_equal((i * 3, 0, 1))
+        assert batch.get_hit_normal(i).almost_equal((0, 0, 1))
+        assert batch.get_hit_node(i).name == "spheres"
+        assert batch.get_hit_solid_index(i) == i
+    assert not batch.has_hit(num_spheres)
+
+
+def test_ray_batch_segments():
+    root = make_scene(1)
+
+    batch = core.CollisionRayBatch()
+    batch.add_segment((0, 0, 3), (0, 0, 2))
+    batch.add_segment((0, 0, 3), (0, 0, 0))
+    batch.add_segment((0, 10, 0), (0, -10, 0))
+    assert batch.traverse(root) == 2
+
+    assert not batch.has_hit(0)
+    assert batch.get_hit_pos(1).almost_equal((0, 0, 1))
+
+    # The polygon is transformed to y=5, in front of the sphere.
+    assert batch.get_hit_node(2).name == "poly"
+    assert batch.get_hit_pos(2).almost_equal((0, 5, 0))
+    assert batch.get_hit_t(2) == pytest.approx(0.25)
+    assert batch.get_hit_normal(2).almost_equal((0, -1, 0))
+
+    # Reusing the batch for a different query.
+    batch.set_ray(0, (0, 0, -10), (0, 0, 1))
+    batch.collide_mask = core.CollideMask.bit(25)
+    assert batch.traverse(root) == 0
+    batch.collide_mask = core.CollideMask.all_on()
+    assert batch.traverse(root) == 3
+    assert batch.get_hit_pos(0).almost_equal((0, 0, -1))
+    assert batch.get_hit_normal(0).almost_equal((0, 0, -1))
+
+
+def test_ray_batch_transformed():
+    # The sphere ends up at (20, 5, 0): its node is offset along the x axis
+    # of a parent that is itself moved and turned a quarter around z, so that
+    # each node's bounding volume lies in a different place in its own space
+    # than in that of its parent.
+    root = core.NodePath("root")
+    arm = root.attach_new_node("arm")
+    arm.set_pos(20, 0, 0)
+    arm.set_h(90)
+
+    cnode = core.CollisionNode("sphere")
+    cnode.add_solid(core.CollisionSphere(0, 0, 0, 1))
+    sphere = arm.attach_new_node(cnode)
+    sphere.set_pos(5, 0, 0)
+    sphere.set_scale(2)
+
+    batch = core.CollisionRayBatch()
+    batch.add_ray((20, 5, 10), (0, 0, -1))
+    batch.add_segment((10, 5, 0), (30, 5, 0))
+    batch.add_ray((5, 0, 10), (0, 0, -1))
+    batch.add_ray((0, 5, 10), (0, 0, -1))
+
+    assert batch.traverse(root) == 2
+
+    assert batch.get_hit_node(0).name == "sphere"
+    assert batch.get_hit_pos(0).almost_equal((20, 5, 2), 0.001)
+    assert batch.get_hit_normal(0).almost_equal((0, 0, 1), 0.001)
+    assert batch.get_hit_t(0) == pytest.approx(8)
+
+    assert batch.get_hit_pos(1).almost_equal((18, 5, 0), 0.001)
+    assert batch.get_hit_normal(1).almost_equal((-1, 0, 0), 0.001)
+    assert batch.get_hit_t(1) == pytest.approx(0.4)
+
+    # These pass through the places where the sphere and its parent would be
+    # if their transforms were ignored.
+    assert not batch.has_hit(2)
+    assert not batch.has_hit(3)
+
+    # The results agree with the CollisionTraverser.
+    for i, (origin, direction) in enumerate([((20, 5, 10), (0, 0, -1)),
+                                             ((0, 5, 10), (0, 0, -1))]):
+        ray_node = core.CollisionNode("ray")
+        ray_node.add_solid(core.CollisionRay(origin, direction))
+        ray_np = root.attach_new_node(ray_node)
+        queue = core.CollisionHandlerQueue()
+        trav = core.CollisionTraverser()
+        trav.add_collider(ray_np, queue)
+        trav.traverse(root)
+        assert queue.get_num_entries() == (1 if batch.has_hit(i * 3) else 0)
+        ray_np.remove_node()
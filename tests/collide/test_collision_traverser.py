@@ -29,3 +29,57 @@ def test_collision_traverser_pickle():
     # Two colliders must still be the same object; this only works with our own
     # version of the pickle module, in direct.stdpy.pickle.
     assert trav.get_handler(collider1) == trav.get_handler(collider2)
+
+
+def traverse_grid(num_threads, bvh_min_solids):
+    from panda3d.core import ConfigVariableInt, CollisionSphere, CollisionRay
+
+    threads_var = ConfigVariableInt("collision-num-threads")
+    bvh_var = ConfigVariableInt("collision-bvh-min-solids")
+    old_threads = threads_var.value
+    old_bvh = bvh_var.value
+
+    root = NodePath("root")
+    into = CollisionNode("into")
+    for x in range(10):
+        for y in range(10):
+            into.add_solid(CollisionSphere(x * 3, y * 3, 0, 1))
+    root.attach_new_node(into)
+
+    handler = CollisionHandlerQueue()
+    trav = CollisionTraverser()
+    for i in range(8):
+        collider = CollisionNode("collider%d" % (i))
+        collider.set_into_collide_mask(0)
+        if i % 2 == 0:
+            collider.add_solid(CollisionSphere(i * 3 + 0.5, i * 3, 0, 1))
+        else:
+            collider.add_solid(CollisionRay(i * 3, -5, 0, 0, 1, 0))
+        trav.add_collider(root.attach_new_node(collider), handler)
+
+    try:
+        threads_var.value = num_threads
+        bvh_var.value = bvh_min_solids
+        trav.traverse(root)
+    finally:
+        threads_var.value = old_threads
+        bvh_var.value = old_bvh
+
+    return [(entry.from_node.name, tuple(entry.into_solid.center))
+            for entry in handler.entries]
+
+
+def test_collision_traverser_bvh():
+    expected = traverse_grid(0, 0)
+    assert len(expected) == 4 + 4 * 10
+    assert traverse_grid(0, 16) == expected
+
+
+def test_collision_traverser_parallel():
+    expected = traverse_grid(0, 0)
+    first = traverse_grid(2, 16)
+    assert sorted(first) == sorted(expected)
+
+    # The order must not depend on the timing of the threads.
+    for i in range(5):
+        assert traverse_grid(2, 16) == first
@@ -0,0 +1,77 @@
+from panda3d import core
+import pytest
+
+
+COLORS = [
+    (1, 0, 0, 1),
+    (0, 1, 0, 1),
+    (0, 0, 1, 1),
+    (1, 1, 0, 1),
+]
+
+
+def make_card_scene(color):
+    scene = core.NodePath("root")
+    scene.set_attrib(core.DepthTestAttrib.make(core.RenderAttrib.M_always))
+
+    camera = scene.attach_new_node(core.Camera("camera"))
+    camera.node().get_lens(0).set_near_far(1, 3)
+
+    cm = core.CardMaker("card")
+    cm.set_frame(-1, 1, -1, 1)
+    card = scene.attach_new_node(cm.generate())
+    card.set_pos(0, 2, 0)
+    card.set_scale(60)
+    card.set_color(color)
+    return camera
+
+
+@pytest.mark.parametrize("num_threads", [0, 2])
+def test_cull_region_num_threads(graphics_pipe, num_threads):
+    var = core.ConfigVariableInt("cull-region-num-threads")
+    old_value = var.value
+    var.value = num_threads
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+    fbprops.set_rgba_bits(8, 8, 8, 8)
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    try:
+        if buffer is None:
+            pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+        # One DisplayRegion per quadrant, each with its own scene.
+        for i, color in enumerate(COLORS):
+            left = (i % 2) * 0.5
+            bottom = (i // 2) * 0.5
+            region = buffer.make_display_region(left, left + 0.5, bottom, bottom + 0.5)
+            region.camera = make_card_scene(color)
+
+        color_texture = core.Texture("color")
+        buffer.add_render_texture(color_texture,
+                                  core.GraphicsOutput.RTM_copy_ram,
+                                  core.GraphicsOutput.RTP_color)
+        engine.render_frame()
+        engine.render_frame()
+
+        for i, color in enumerate(COLORS):
+            col = core.LColor()
+            color_texture.peek().lookup(col, (i % 2) * 0.5 + 0.25, (i // 2) * 0.5 + 0.25)
+            assert col.almost_equal(color, 0.02)
+    finally:
+        var.value = old_value
+        if buffer is not None:
+            engine.remove_window(buffer)
@@ -0,0 +1,101 @@
+from panda3d import core
+import pytest
+
+
+NUM_STRIPS = 8
+NUM_CARDS = 64
+
+
+def card_color(i):
+    return ((i + 1) / float(NUM_CARDS), 0.5, 1.0 - i / float(NUM_CARDS), 1)
+
+
+def make_strip_scene():
+    """ Makes a scene of many overlapping cards under a single node.  Each
+    vertical strip of the view is covered by several cards, which are drawn
+    in scene graph order, so the last card in each strip is the one that ends
+    up visible.  Half of the other children lie outside of the view. """
+
+    scene = core.NodePath("root")
+    scene.set_depth_test(False)
+    scene.set_depth_write(False)
+    scene.set_bin("unsorted", 0)
+
+    lens = core.OrthographicLens()
+    lens.set_film_size(2, 2)
+    lens.set_near_far(1, 3)
+    camera = scene.attach_new_node(core.Camera("camera", lens))
+
+    parent = scene.attach_new_node("parent")
+    width = 2.0 / NUM_STRIPS
+    for i in range(NUM_CARDS):
+        strip = i % NUM_STRIPS
+        cm = core.CardMaker("card%d" % i)
+        cm.set_frame(-1 + strip * width, -1 + (strip + 1) * width, -1, 1)
+        card = parent.attach_new_node(cm.generate())
+        card.set_pos(0, 2, 0)
+        card.set_color(card_color(i))
+
+        hidden = parent.attach_new_node(cm.generate())
+        hidden.set_pos(10 + i, 2, 0)
+        hidden.set_color(0, 0, 0, 1)
+
+    return camera
+
+
+@pytest.mark.parametrize("num_threads,batch_bounds",
+                         [(0, False), (0, True), (2, False), (2, True)])
+def test_cull_parallel_order(graphics_pipe, num_threads, batch_bounds):
+    variables = [
+        (core.ConfigVariableInt("cull-num-threads"), num_threads),
+        (core.ConfigVariableInt("cull-parallel-threshold"), 4),
+        (core.ConfigVariableBool("cull-batch-bounds"), batch_bounds),
+    ]
+    old_values = [var.value for var, value in variables]
+    for var, value in variables:
+        var.value = value
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.force_hardware = True
+    fbprops.set_rgba_bits(8, 8, 8, 8)
+
+    buffer = engine.make_output(
+        graphics_pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(32, 32),
+        core.GraphicsPipe.BF_refuse_window,
+    )
+    engine.open_windows()
+
+    try:
+        if buffer is None:
+            pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+        region = buffer.make_display_region()
+        region.camera = make_strip_scene()
+
+        color_texture = core.Texture("color")
+        buffer.add_render_texture(color_texture,
+                                  core.GraphicsOutput.RTM_copy_ram,
+                                  core.GraphicsOutput.RTP_color)
+        engine.render_frame()
+        engine.render_frame()
+
+        # The objects found by the parallel ranges must reach the bin in the
+        # same order as in a serial traversal, and no visible card may be
+        # culled.
+        peeker = color_texture.peek()
+        for strip in range(NUM_STRIPS):
+            col = core.LColor()
+            peeker.lookup(col, (strip + 0.5) / NUM_STRIPS, 0.5)
+            assert col.almost_equal(card_color(NUM_CARDS - NUM_STRIPS + strip), 0.02)
+    finally:
+        for var, value in zip([var for var, value in variables], old_values):
+            var.value = value
+        if buffer is not None:
+            engine.remove_window(buffer)
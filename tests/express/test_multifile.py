@@ -1,4 +1,5 @@
-from panda3d.core import Multifile, StringStream, IStreamWrapper
+from panda3d.core import Multifile, StringStream, IStreamWrapper, Filename
+import threading
 
 
 def test_multifile_read_empty():
@@ -10,3 +11,82 @@ def test_multifile_read_empty():
     assert m.is_read_valid()
     assert m.get_num_subfiles() == 0
     m.close()
+
+
+def write_multifile(path, subfiles):
+    m = Multifile()
+    assert m.open_write(Filename.from_os_specific(str(path)))
+
+    # The Multifile does not take ownership of the streams, which must stay
+    # alive until it is closed.
+    streams = []
+    for name, data, compression in subfiles:
+        stream = StringStream(data)
+        streams.append(stream)
+        m.add_subfile(name, stream, compression)
+    m.close()
+
+
+def test_multifile_read_mapped(tmp_path):
+    plain = bytes(range(256)) * 64
+    packed = b'compress me ' * 1000
+    path = tmp_path / "test.mf"
+    write_multifile(path, [
+        ("plain.bin", plain, 0),
+        ("packed.bin", packed, 6),
+        ("empty.bin", b'', 0),
+    ])
+
+    m = Multifile()
+    assert m.open_read(Filename.from_os_specific(str(path)))
+    assert m.is_mapped()
+
+    assert m.read_subfile(m.find_subfile("plain.bin")) == plain
+    assert m.read_subfile(m.find_subfile("packed.bin")) == packed
+    assert m.read_subfile(m.find_subfile("empty.bin")) == b''
+
+    # The stream returned for an uncompressed subfile reads straight out of
+    # the mapping, and must support seeking like an ISubStream.
+    stream = m.open_read_subfile(m.find_subfile("plain.bin"))
+    assert stream.read(4) == plain[:4]
+    stream.seekg(1000)
+    assert stream.tellg() == 1000
+    assert stream.read(16) == plain[1000:1016]
+    stream.seekg(-8, 2)
+    assert stream.read(100) == plain[-8:]
+    assert stream.read(1) == b''
+    Multifile.close_read_subfile(stream)
+
+    stream = m.open_read_subfile(m.find_subfile("packed.bin"))
+    assert stream.read(len(packed) + 1) == packed
+    Multifile.close_read_subfile(stream)
+
+    m.close()
+    assert not m.is_mapped()
+
+
+def test_multifile_read_mapped_threads(tmp_path):
+    subfiles = [("file%d" % (i), bytes([i]) * (i * 997 + 1), 0) for i in range(16)]
+    path = tmp_path / "threads.mf"
+    write_multifile(path, subfiles)
+
+    m = Multifile()
+    assert m.open_read(Filename.from_os_specific(str(path)))
+    assert m.is_mapped()
+
+    errors = []
+
+    def read_all():
+        for name, data, _ in subfiles:
+            for i in range(10):
+                if m.read_subfile(m.find_subfile(name)) != data:
+                    errors.append(name)
+
+    threads = [threading.Thread(target=read_all) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    assert not errors
+    m.close()
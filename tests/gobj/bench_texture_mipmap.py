@@ -0,0 +1,84 @@
+"""
+Times the generation of a full mipmap chain on the CPU, for a few common
+texture formats, with each mipmap filter, instruction set level and number
+of worker threads.  This is not run as part of the test suite; run it
+directly:
+
+    python tests/gobj/bench_texture_mipmap.py [size]
+"""
+
+from panda3d.core import Texture, ConfigVariableInt, ConfigVariableString
+from array import array
+import sys
+import time
+
+
+FORMATS = [
+    ("R8", Texture.T_unsigned_byte, Texture.F_red),
+    ("RGBA8", Texture.T_unsigned_byte, Texture.F_rgba),
+    ("SRGB8_A8", Texture.T_unsigned_byte, Texture.F_srgb_alpha),
+    ("RGBA16", Texture.T_unsigned_short, Texture.F_rgba16),
+    ("RGBA32F", Texture.T_float, Texture.F_rgba32),
+]
+
+
+def make_texture(size, component_type, format):
+    tex = Texture("bench")
+    tex.setup_2d_texture(size, size, component_type, format)
+    tex.minfilter = Texture.FT_linear_mipmap_linear
+    num_values = tex.get_expected_ram_image_size() // tex.component_width
+    if component_type == Texture.T_float:
+        data = array('f', ((i % 1001) * 0.125 for i in range(num_values)))
+    elif component_type == Texture.T_unsigned_short:
+        data = array('H', ((i * 977) & 0xffff for i in range(num_values)))
+    else:
+        data = array('B', ((i * 31 + i // 7) & 0xff for i in range(num_values)))
+    tex.set_ram_image(data)
+    return tex
+
+
+def time_mipmaps(tex, repeat=5):
+    """ Returns the best time, in milliseconds, to generate the mipmaps. """
+
+    best = None
+    for i in range(repeat):
+        tex.clear_ram_mipmap_images()
+        start = time.perf_counter()
+        tex.generate_ram_mipmap_images()
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best * 1000.0
+
+
+def main():
+    size = int(sys.argv[1]) if len(sys.argv) > 1 else 2048
+
+    filter_var = ConfigVariableString("texture-mipmap-filter")
+    simd_var = ConfigVariableString("texture-mipmap-simd")
+    threads_var = ConfigVariableInt("texture-mipmap-num-threads")
+
+    configs = []
+    for simd in ("none", "sse2", "sse4.1", "avx2"):
+        configs.append(("box", simd, 0))
+    configs.append(("box", "auto", 4))
+    for filter in ("kaiser", "lanczos"):
+        configs.append((filter, "auto", 0))
+        configs.append((filter, "auto", 4))
+
+    print("%dx%d, full mipmap chain, best of 5 (ms)" % (size, size))
+    print("%-10s" % "" + "".join("%-20s" % ("%s/%s/%dt" % c) for c in configs))
+
+    for name, component_type, format in FORMATS:
+        tex = make_texture(size, component_type, format)
+        row = "%-10s" % name
+        for filter, simd, threads in configs:
+            filter_var.value = filter
+            simd_var.value = simd
+            threads_var.value = threads
+            row += "%-20.2f" % time_mipmaps(tex)
+        print(row)
+
+
+if __name__ == "__main__":
+    main()
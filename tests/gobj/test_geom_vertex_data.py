@@ -0,0 +1,182 @@
+from panda3d import core
+import pytest
+import tempfile
+
+
+def make_skinned_vdata(num_rows, num_values=3):
+    array = core.GeomVertexArrayFormat()
+    array.add_column("vertex", num_values, core.Geom.NT_float32, core.Geom.C_point)
+    array.add_column("normal", 3, core.Geom.NT_float32, core.Geom.C_normal)
+    blend_array = core.GeomVertexArrayFormat()
+    blend_array.add_column("transform_blend", 1, core.Geom.NT_uint16, core.Geom.C_index, 0, 2)
+
+    fmt = core.GeomVertexFormat()
+    fmt.add_array(array)
+    fmt.add_array(blend_array)
+    aspec = core.GeomVertexAnimationSpec()
+    aspec.set_panda()
+    fmt.set_animation(aspec)
+    fmt = core.GeomVertexFormat.register_format(fmt)
+
+    translate = core.UserVertexTransform("translate")
+    translate.set_matrix(core.Mat4.translate_mat(1, 2, 3))
+    scale = core.UserVertexTransform("scale")
+    scale.set_matrix(core.Mat4.scale_mat(1, 2, 4))
+
+    table = core.TransformBlendTable()
+    table.add_blend(core.TransformBlend(translate, 1.0))
+    table.add_blend(core.TransformBlend(scale, 1.0))
+    table.add_blend(core.TransformBlend(translate, 0.5, scale, 0.5))
+    table.set_rows(core.SparseArray.lower_on(num_rows))
+
+    vdata = core.GeomVertexData("skinned", fmt, core.Geom.UH_static)
+    vdata.set_transform_blend_table(table)
+    vdata.set_num_rows(num_rows)
+
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    normal = core.GeomVertexWriter(vdata, "normal")
+    blend = core.GeomVertexWriter(vdata, "transform_blend")
+    for i in range(num_rows):
+        if num_values == 4:
+            vertex.add_data4(i, -i, 0.5 * i, 1)
+        else:
+            vertex.add_data3(i, -i, 0.5 * i)
+        normal.add_data3(core.Vec3(1, 1, 1).normalized())
+        # Make runs of varying length with the same blend index.
+        blend.add_data1i((i // (1 + i % 3)) % 3)
+
+    return vdata
+
+
+def read_animated(vdata):
+    animated = vdata.animate_vertices(True, core.Thread.get_current_thread())
+    vertex = core.GeomVertexReader(animated, "vertex")
+    normal = core.GeomVertexReader(animated, "normal")
+    result = []
+    while not vertex.is_at_end():
+        result.append((core.LVecBase4f(*vertex.get_data4()), core.LVecBase3f(*normal.get_data3())))
+    return result
+
+
+@pytest.mark.parametrize("num_values", [3, 4])
+def test_animate_vertices_simd(num_values):
+    var = core.ConfigVariableBool("animate-vertices-simd")
+    vdata = make_skinned_vdata(100, num_values)
+
+    old_value = var.value
+    try:
+        var.value = True
+        fast = read_animated(vdata)
+        var.value = False
+        slow = read_animated(vdata)
+    finally:
+        var.value = old_value
+
+    assert len(fast) == len(slow) == 100
+    for (fast_vertex, fast_normal), (slow_vertex, slow_normal) in zip(fast, slow):
+        assert fast_vertex.almost_equal(slow_vertex, 1e-4)
+        assert fast_normal.almost_equal(slow_normal, 1e-4)
+        assert fast_normal.length() == pytest.approx(1.0, abs=1e-4)
+
+
+def test_animate_vertices_translate():
+    vdata = make_skinned_vdata(3)
+    blend = core.GeomVertexRewriter(vdata, "transform_blend")
+    while not blend.is_at_end():
+        blend.set_data1i(0)
+
+    result = read_animated(vdata)
+    for i, (vertex, normal) in enumerate(result):
+        assert vertex.almost_equal(core.Vec4(i + 1, 2 - i, 0.5 * i + 3, 1))
+
+
+def make_large_vdata(num_rows):
+    vdata = core.GeomVertexData("large", core.GeomVertexFormat.get_v3(), core.Geom.UH_static)
+    vdata.set_num_rows(num_rows)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    for i in range(num_rows):
+        vertex.add_data3(i, -i, 0.5 * i)
+    return vdata
+
+
+def write_aligned_bam(dest, vdata):
+    writer = core.BamWriter(dest)
+    writer.set_file_minor_ver(46)
+    writer.aligned_data_threshold = 1024
+    writer.init()
+    writer.write_object(vdata)
+    writer.flush()
+
+
+def read_vertices(vdata):
+    vertex = core.GeomVertexReader(vdata, "vertex")
+    result = []
+    while not vertex.is_at_end():
+        result.append(core.LVecBase3f(*vertex.get_data3()))
+    return result
+
+
+def test_vertex_data_bam_aligned_buffer():
+    vdata = make_large_vdata(1000)
+    buffer = core.DatagramBuffer()
+    write_aligned_bam(buffer, vdata)
+
+    reader = core.BamReader(buffer)
+    reader.init()
+    vdata2 = reader.read_object()
+    reader.resolve()
+
+    assert read_vertices(vdata2) == read_vertices(vdata)
+
+
+def test_vertex_data_bam_aligned_file():
+    vdata = make_large_vdata(1000)
+
+    file = tempfile.NamedTemporaryFile(suffix='.bam')
+    filename = core.Filename.from_os_specific(file.name)
+    filename.make_true_case()
+
+    dof = core.DatagramOutputFile()
+    assert dof.open(filename)
+    write_aligned_bam(dof, vdata)
+    dof.close()
+
+    dif = core.DatagramInputFile()
+    assert dif.open(filename)
+    reader = core.BamReader(dif)
+    reader.init()
+    vdata2 = reader.read_object()
+    reader.resolve()
+    dif.close()
+
+    assert read_vertices(vdata2) == read_vertices(vdata)
+
+    # Modifying the loaded data should not affect the file.
+    vertex = core.GeomVertexWriter(vdata2, "vertex")
+    vertex.set_data3(1, 2, 3)
+    assert read_vertices(vdata2)[0] == (1, 2, 3)
+    assert read_vertices(vdata2)[1:] == read_vertices(vdata)[1:]
+
+
+def test_vertex_data_bam_decode_threads():
+    vdata = make_large_vdata(1000)
+    buffer = core.DatagramBuffer()
+    writer = core.BamWriter(buffer)
+    writer.init()
+    writer.write_object(vdata)
+    writer.flush()
+
+    num_threads = core.ConfigVariableInt("bam-decode-num-threads")
+    min_size = core.ConfigVariableInt("bam-decode-min-size")
+    old_values = (num_threads.value, min_size.value)
+    try:
+        num_threads.value = 2
+        min_size.value = 1
+        reader = core.BamReader(buffer)
+        reader.init()
+        vdata2 = reader.read_object()
+        reader.resolve()
+    finally:
+        num_threads.value, min_size.value = old_values
+
+    assert read_vertices(vdata2) == read_vertices(vdata)
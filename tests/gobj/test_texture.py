@@ -1,4 +1,7 @@
-from panda3d.core import Texture, PNMImage, LColor
+from panda3d.core import Texture, PNMImage, LColor, ConfigVariableInt
+from panda3d.core import ConfigVariableString, SamplerState
+from panda3d.core import BamReader, BamWriter, BamEnums, DatagramBuffer
+from panda3d.core import Filename, TexturePool
 from array import array
 import math
 
@@ -134,3 +137,271 @@ def test_texture_clear_half():
     assert col.y == -inf
     assert col.z == -inf
     assert math.isnan(col.w)
+
+
+def make_rgtc_source(size, num_components):
+    """ Creates a texture filled with a gradient, suitable for compressing
+    with CM_rgtc. """
+
+    format = Texture.F_red if num_components == 1 else Texture.F_rg
+    tex = Texture("")
+    tex.setup_2d_texture(size, size, Texture.T_unsigned_byte, format)
+    data = array('B', ((x * 7 + y * 3 + c * 50) & 0xff
+                       for y in range(size)
+                       for x in range(size)
+                       for c in range(num_components)))
+    tex.set_ram_image(data)
+    return tex
+
+
+def test_texture_compress_threads():
+    var = ConfigVariableInt("texture-compress-num-threads")
+    old_value = var.value
+    try:
+        for num_components in (1, 2):
+            for size in (3, 16, 37, 130):
+                results = []
+                for threads in (0, 2):
+                    var.value = threads
+                    tex = make_rgtc_source(size, num_components)
+                    assert tex.compress_ram_image(Texture.CM_rgtc)
+                    assert tex.ram_image_compression == Texture.CM_rgtc
+                    results.append(bytes(tex.get_ram_image()))
+
+                assert results[0] == results[1]
+    finally:
+        var.value = old_value
+
+
+def test_texture_async_compress():
+    tex = make_rgtc_source(64, 2)
+    future = tex.async_compress_ram_image(Texture.CM_rgtc)
+    assert future.result() == tex
+    assert tex.ram_image_compression == Texture.CM_rgtc
+
+
+def box_filter_rgba8(data, x_size, y_size):
+    """ Returns the next mipmap level of the given unsigned byte RGBA image,
+    averaging each 2x2 block of pixels. """
+
+    to_x_size = max(x_size // 2, 1)
+    to_y_size = max(y_size // 2, 1)
+    result = array('B')
+    for y in range(to_y_size):
+        y0 = y * 2
+        y1 = min(y0 + 1, y_size - 1)
+        for x in range(to_x_size):
+            x0 = x * 2
+            x1 = min(x0 + 1, x_size - 1)
+            for c in range(4):
+                total = (data[(y0 * x_size + x0) * 4 + c] +
+                         data[(y0 * x_size + x1) * 4 + c] +
+                         data[(y1 * x_size + x0) * 4 + c] +
+                         data[(y1 * x_size + x1) * 4 + c])
+                result.append(total >> 2)
+    return result
+
+
+def test_texture_generate_mipmaps_rgba8():
+    x_size, y_size = 37, 10
+    tex = Texture("")
+    tex.setup_2d_texture(x_size, y_size, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.minfilter = Texture.FT_linear_mipmap_linear
+    data = array('B', ((i * 31 + i // 7) & 0xff for i in range(x_size * y_size * 4)))
+    tex.set_ram_image(data)
+    tex.generate_ram_mipmap_images()
+
+    assert tex.get_num_ram_mipmap_images() == 6
+    for n in range(1, tex.get_num_ram_mipmap_images()):
+        data = box_filter_rgba8(data, x_size, y_size)
+        x_size = max(x_size // 2, 1)
+        y_size = max(y_size // 2, 1)
+        assert bytes(tex.get_ram_mipmap_image(n)) == data.tobytes()
+
+
+def test_texture_generate_mipmaps_threads():
+    var = ConfigVariableInt("texture-mipmap-num-threads")
+    old_value = var.value
+    try:
+        for component_type in (Texture.T_unsigned_byte, Texture.T_unsigned_short, Texture.T_float):
+            for format in (Texture.F_red, Texture.F_rgb, Texture.F_rgba):
+                results = []
+                for threads in (0, 2):
+                    var.value = threads
+                    tex = Texture("")
+                    tex.setup_2d_texture(600, 300, component_type, format)
+                    tex.minfilter = Texture.FT_linear_mipmap_linear
+                    size = tex.get_expected_ram_image_size() // tex.component_width
+                    if component_type == Texture.T_float:
+                        data = array('f', ((i % 1001) * 0.125 for i in range(size)))
+                    elif component_type == Texture.T_unsigned_short:
+                        data = array('H', ((i * 977) & 0xffff for i in range(size)))
+                    else:
+                        data = array('B', ((i * 31 + i // 7) & 0xff for i in range(size)))
+                    tex.set_ram_image(data)
+                    tex.generate_ram_mipmap_images()
+                    results.append([bytes(tex.get_ram_mipmap_image(n))
+                                     for n in range(tex.get_num_ram_mipmap_images())])
+
+                assert results[0] == results[1]
+    finally:
+        var.value = old_value
+
+
+def make_mipmap_source(tex):
+    size = tex.get_expected_ram_image_size() // tex.component_width
+    if tex.component_type == Texture.T_float:
+        data = array('f', ((i % 1001) * 0.125 for i in range(size)))
+    elif tex.component_type == Texture.T_unsigned_short:
+        data = array('H', ((i * 977) & 0xffff for i in range(size)))
+    else:
+        data = array('B', ((i * 31 + i // 7) & 0xff for i in range(size)))
+    tex.set_ram_image(data)
+
+
+def test_texture_generate_mipmaps_simd():
+    # Each set of instruction set extensions must give the same results as the
+    # scalar code.
+    var = ConfigVariableString("texture-mipmap-simd")
+    old_value = var.value
+    try:
+        for component_type in (Texture.T_unsigned_byte, Texture.T_unsigned_short, Texture.T_float):
+            for format in (Texture.F_red, Texture.F_rg, Texture.F_rgb, Texture.F_rgba):
+                for z_size in (1, 6):
+                    results = []
+                    for level in ("none", "sse2", "sse4.1", "avx2"):
+                        var.value = level
+                        tex = Texture("")
+                        if z_size == 1:
+                            tex.setup_2d_texture(301, 77, component_type, format)
+                        else:
+                            tex.setup_3d_texture(93, 40, z_size, component_type, format)
+                        tex.minfilter = Texture.FT_linear_mipmap_linear
+                        make_mipmap_source(tex)
+                        tex.generate_ram_mipmap_images()
+                        results.append([bytes(tex.get_ram_mipmap_image(n))
+                                         for n in range(tex.get_num_ram_mipmap_images())])
+
+                    for result in results[1:]:
+                        assert result == results[0]
+    finally:
+        var.value = old_value
+
+
+def test_texture_generate_mipmaps_kernel_flat():
+    # A windowed sinc filter must keep a flat color exactly.
+    var = ConfigVariableString("texture-mipmap-filter")
+    old_value = var.value
+    try:
+        for filter in ("kaiser", "lanczos"):
+            var.value = filter
+            for wrap in (SamplerState.WM_clamp, SamplerState.WM_repeat, SamplerState.WM_mirror):
+                tex = Texture("")
+                tex.setup_2d_texture(50, 21, Texture.T_unsigned_byte, Texture.F_rgba)
+                tex.minfilter = Texture.FT_linear_mipmap_linear
+                tex.wrap_u = wrap
+                tex.wrap_v = wrap
+                tex.set_ram_image(array('B', [10, 100, 200, 255] * (50 * 21)))
+                tex.generate_ram_mipmap_images()
+
+                assert tex.get_num_ram_mipmap_images() == 6
+                for n in range(1, tex.get_num_ram_mipmap_images()):
+                    image = tex.get_ram_mipmap_image(n)
+                    assert bytes(image) == bytes([10, 100, 200, 255]) * (len(image) // 4)
+    finally:
+        var.value = old_value
+
+
+def test_texture_generate_mipmaps_kernel_gradient():
+    # On a smooth gradient, the sinc filters agree closely with the box filter
+    # away from the edges, but they do produce different results.
+    var = ConfigVariableString("texture-mipmap-filter")
+    old_value = var.value
+    try:
+        results = {}
+        for filter in ("box", "kaiser", "lanczos"):
+            var.value = filter
+            tex = Texture("")
+            tex.setup_2d_texture(64, 64, Texture.T_float, Texture.F_r32)
+            tex.minfilter = Texture.FT_linear_mipmap_linear
+            tex.set_ram_image(array('f', (math.sin(x * 0.1) * 100 + y for y in range(64) for x in range(64))))
+            tex.generate_ram_mipmap_images()
+            results[filter] = array('f', bytes(tex.get_ram_mipmap_image(1)))
+
+        box = results["box"]
+        for filter in ("kaiser", "lanczos"):
+            assert results[filter] != box
+            for y in range(4, 28):
+                for x in range(4, 28):
+                    assert abs(results[filter][y * 32 + x] - box[y * 32 + x]) < 1.0
+    finally:
+        var.value = old_value
+
+
+def test_texture_mipmap_filter_strings():
+    for filter in (Texture.MF_box, Texture.MF_kaiser, Texture.MF_lanczos):
+        assert Texture.string_mipmap_filter(Texture.format_mipmap_filter(filter)) == filter
+
+
+def bam_round_trip_texture(tex, texture_mode):
+    """ Writes the texture to a bam stream and reads it back, with the bam
+    decode threads enabled for even the smallest payloads. """
+
+    buffer = DatagramBuffer()
+    writer = BamWriter(buffer)
+    writer.set_file_texture_mode(texture_mode)
+    writer.init()
+    writer.write_object(tex)
+    writer.flush()
+    del writer
+
+    num_threads = ConfigVariableInt("bam-decode-num-threads")
+    min_size = ConfigVariableInt("bam-decode-min-size")
+    old_values = (num_threads.value, min_size.value)
+    try:
+        num_threads.value = 2
+        min_size.value = 1
+        reader = BamReader(buffer)
+        reader.init()
+        tex2 = reader.read_object()
+        reader.resolve()
+        del reader
+    finally:
+        num_threads.value, min_size.value = old_values
+    return tex2
+
+
+def test_texture_bam_decode_threads_rawdata():
+    tex = Texture("")
+    tex.setup_2d_texture(64, 64, Texture.T_unsigned_byte, Texture.F_rgba)
+    tex.set_ram_image(array('B', ((i * 7) & 0xff for i in range(64 * 64 * 4))))
+    tex.generate_simple_ram_image()
+
+    tex2 = bam_round_trip_texture(tex, BamEnums.BTM_rawdata)
+    assert bytes(tex2.get_ram_image()) == bytes(tex.get_ram_image())
+    assert bytes(tex2.get_simple_ram_image()) == bytes(tex.get_simple_ram_image())
+
+
+def test_texture_bam_decode_threads_simple_image(tmp_path):
+    # A texture written by filename is read into a temporary texture, which
+    # is thrown away after its simple RAM image has been copied to the one
+    # loaded from disk.
+    img = PNMImage(32, 32, 4)
+    img.fill(0.25, 0.5, 0.75)
+    img.alpha_fill(1.0)
+    fn = Filename.from_os_specific(str(tmp_path / "simple.png"))
+    assert img.write(fn)
+
+    tex = Texture("simple")
+    assert tex.read(fn)
+    tex.generate_simple_ram_image()
+    simple_image = bytes(tex.get_simple_ram_image())
+    assert simple_image
+
+    TexturePool.release_all_textures()
+    try:
+        tex2 = bam_round_trip_texture(tex, BamEnums.BTM_fullpath)
+        assert tex2 is not None
+        assert bytes(tex2.get_simple_ram_image()) == simple_image
+    finally:
+        TexturePool.release_all_textures()
@@ -0,0 +1,82 @@
+from panda3d import core
+import pytest
+
+
+CODECS = [
+    ("none", core.VertexDataPage.CC_none),
+    ("zlib", core.VertexDataPage.CC_zlib),
+    ("lz4", core.VertexDataPage.CC_lz4),
+    ("zstd", core.VertexDataPage.CC_zstd),
+]
+
+
+@pytest.fixture
+def compressed_lru():
+    """ Allows pages to be moved to RC_compressed for the duration of a test. """
+
+    lru = core.VertexDataPage.get_global_lru(core.VertexDataPage.RC_compressed)
+    old_size = lru.get_max_size()
+    lru.set_max_size(1 << 30)
+    yield lru
+    lru.set_max_size(old_size)
+
+
+def make_array(num_rows):
+    fmt = core.GeomVertexArrayFormat()
+    fmt.add_column("vertex", 3, core.Geom.NT_float32, core.Geom.C_point)
+    fmt = core.GeomVertexArrayFormat.register_format(fmt)
+
+    array = core.GeomVertexArrayData(fmt, core.GeomEnums.UH_static)
+    handle = array.modify_handle()
+    handle.unclean_set_num_rows(num_rows)
+
+    # A repetitive pattern, so that every codec actually compresses it.
+    data = bytes(range(256)) * (handle.get_data_size_bytes() // 256)
+    handle.copy_data_from(data)
+    return array, data
+
+
+@pytest.mark.parametrize("name,codec", CODECS, ids=[c[0] for c in CODECS])
+def test_vertex_data_page_codec_round_trip(compressed_lru, name, codec):
+    if not core.VertexDataPage.has_codec(codec):
+        pytest.skip("{} support not compiled in".format(name))
+
+    page = core.load_prc_file_data("", "vertex-data-compression " + name)
+    try:
+        assert core.VertexDataPage.get_compression_codec() == codec
+
+        array, data = make_array(16384)
+
+        # Move the array into a page of the book, then evict the page from
+        # the resident LRU so that it is compressed with the chosen codec.
+        core.GeomVertexArrayData.get_independent_lru().evict_to(0)
+        core.VertexDataPage.get_global_lru(core.VertexDataPage.RC_resident).evict_to(0)
+        core.VertexDataPage.flush_threads()
+        assert compressed_lru.get_total_size() > 0
+
+        # Reading the data back expands the page again.
+        assert array.get_handle().get_data() == data
+    finally:
+        core.unload_prc_file(page)
+
+
+def test_vertex_data_page_codec_fallback():
+    # Naming a codec that was not compiled in falls back to zlib, or to no
+    # compression at all.
+    for name, codec in CODECS:
+        page = core.load_prc_file_data("", "vertex-data-compression " + name)
+        try:
+            result = core.VertexDataPage.get_compression_codec()
+            if core.VertexDataPage.has_codec(codec):
+                assert result == codec
+            else:
+                assert core.VertexDataPage.has_codec(result)
+                assert result in (core.VertexDataPage.CC_zlib, core.VertexDataPage.CC_none)
+        finally:
+            core.unload_prc_file(page)
+
+
+def test_vertex_data_page_format_codec():
+    for name, codec in CODECS:
+        assert core.VertexDataPage.format_codec(codec) == name
+        assert core.VertexDataPage.string_codec(name) == codec
@@ -0,0 +1,42 @@
+from panda3d.core import RenderState, ColorAttrib, ColorScaleAttrib
+import threading
+
+
+def test_render_state_unique():
+    # Equal states are shared, whichever shard of the table they end up in.
+    states = [RenderState.make(ColorAttrib.make_flat((i / 256.0, 0.25, 0.5, 1))) for i in range(200)]
+    for i, state in enumerate(states):
+        other = RenderState.make(ColorAttrib.make_flat((i / 256.0, 0.25, 0.5, 1)))
+        assert other.this == state.this
+    assert RenderState.validate_states()
+
+
+def test_render_state_unique_threads():
+    results = [None] * 4
+
+    def make_states(n):
+        results[n] = [RenderState.make(ColorScaleAttrib.make((i / 1024.0, 1, 1, 1))) for i in range(1000)]
+
+    threads = [threading.Thread(target=make_states, args=(n, )) for n in range(len(results))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    for i in range(1000):
+        assert len(set(states[i].this for states in results)) == 1
+    assert RenderState.validate_states()
+
+
+def test_render_state_compose_cache():
+    a = RenderState.make(ColorAttrib.make_flat((1, 0, 0, 1)))
+    b = RenderState.make(ColorScaleAttrib.make((0.5, 0.5, 0.5, 1)))
+
+    # The second composition comes from the cache of a, and is the same state.
+    ab = a.compose(b)
+    assert a.compose(b).this == ab.this
+    assert ab.has_attrib(ColorAttrib)
+    assert ab.has_attrib(ColorScaleAttrib)
+
+    inv = a.invert_compose(ab)
+    assert a.invert_compose(ab).this == inv.this
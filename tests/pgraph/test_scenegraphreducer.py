@@ -0,0 +1,127 @@
+from panda3d.core import SceneGraphReducer, PandaNode, GeomNode, NodePath
+from panda3d.core import Geom, GeomTriangles, GeomVertexData
+from panda3d.core import GeomVertexFormat, GeomVertexWriter
+
+
+def make_geom(offset):
+    vdata = GeomVertexData("tri", GeomVertexFormat.get_v3(), Geom.UH_static)
+    writer = GeomVertexWriter(vdata, "vertex")
+    writer.add_data3(offset, 0, 0)
+    writer.add_data3(offset + 1, 0, 0)
+    writer.add_data3(offset, 0, 1)
+    prim = GeomTriangles(Geom.UH_static)
+    prim.add_vertices(0, 1, 2)
+    geom = Geom(vdata)
+    geom.add_primitive(prim)
+    return geom
+
+
+def make_level(num_branches=8, depth=4):
+    # Each branch is a chain of redundant nodes ending in a few GeomNodes.
+    root = PandaNode("root")
+    for i in range(num_branches):
+        parent = NodePath(root).attach_new_node("branch%d" % (i))
+        for j in range(depth):
+            parent = parent.attach_new_node("link%d" % (j))
+        for k in range(3):
+            geom_node = GeomNode("geom%d" % (k))
+            geom_node.add_geom(make_geom(i * 10 + k))
+            geom_node.add_geom(make_geom(i * 10 + k + 5))
+            parent.attach_new_node(geom_node)
+    return root
+
+
+def describe(node):
+    result = [node.get_name(), node.get_num_children()]
+    if node.is_geom_node():
+        result.append(node.get_num_geoms())
+    for child in node.get_children():
+        result.append(describe(child))
+    return result
+
+
+def test_flatten_threads():
+    serial = make_level()
+    parallel = make_level()
+
+    reducer = SceneGraphReducer()
+    reducer.set_num_threads(0)
+    serial_count = reducer.flatten(serial, ~0)
+    reducer.unify(serial, False)
+
+    reducer = SceneGraphReducer()
+    reducer.set_num_threads(4)
+    assert reducer.get_num_threads() == 4
+    parallel_count = reducer.flatten(parallel, ~0)
+    reducer.unify(parallel, False)
+
+    assert parallel_count == serial_count
+    assert describe(parallel) == describe(serial)
+
+
+def test_flatten_threads_instanced():
+    # A branch that is instanced in two places may not be flattened on a
+    # separate thread; make sure it still gets flattened correctly.
+    serial = make_level()
+    parallel = make_level()
+    for root in (serial, parallel):
+        shared = root.get_child(0)
+        root.get_child(1).add_child(shared)
+
+    reducer = SceneGraphReducer()
+    serial_count = reducer.flatten(serial, 0)
+
+    reducer = SceneGraphReducer()
+    reducer.set_num_threads(4)
+    parallel_count = reducer.flatten(parallel, 0)
+
+    assert parallel_count == serial_count
+    assert describe(parallel) == describe(serial)
+
+
+def test_flatten_incremental():
+    root = make_level(num_branches=4)
+
+    reducer = SceneGraphReducer()
+    reducer.set_incremental(True)
+    assert reducer.get_incremental()
+    assert reducer.flatten(root, 0) > 0
+    flattened = describe(root)
+
+    # Nothing has changed, so there is nothing to do.
+    assert reducer.flatten(root, 0) == 0
+    assert describe(root) == flattened
+
+    # Insert a redundant node into one branch; only that branch is dirty.
+    branch = root.get_child(2)
+    extra = PandaNode("extra")
+    for child in branch.get_children():
+        branch.remove_child(child)
+        extra.add_child(child)
+    branch.add_child(extra)
+    assert reducer.flatten(root, 0) == 1
+    assert describe(root) == flattened
+
+    reducer.set_incremental(False)
+    assert not reducer.get_incremental()
+    assert reducer.flatten(root, 0) == 0
+    assert describe(root) == flattened
+
+
+def test_unify_incremental():
+    root = make_level(num_branches=4)
+
+    reducer = SceneGraphReducer()
+    reducer.set_incremental(True)
+    reducer.flatten(root, 0)
+    reducer.unify(root, False)
+    unified = describe(root)
+
+    # Add a copy of an existing Geom to one of the branches; the next unify
+    # only needs to revisit that branch, but must still merge the copy in.
+    geom_node = root.get_child(1)
+    while not geom_node.is_geom_node():
+        geom_node = geom_node.get_child(0)
+    geom_node.add_geom(geom_node.get_geom(0).make_copy())
+    reducer.unify(root, False)
+    assert describe(root) == unified
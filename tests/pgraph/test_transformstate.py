@@ -0,0 +1,113 @@
+from panda3d.core import TransformState, ConfigVariableDouble, ConfigVariableInt
+import math
+import pytest
+import threading
+
+
+def test_transform_state_unique():
+    # Equal states are shared, whichever shard of the table they end up in.
+    states = [TransformState.make_pos((i, 0.25, 1000)) for i in range(200)]
+    for i, state in enumerate(states):
+        assert TransformState.make_pos((i, 0.25, 1000)).this == state.this
+    assert TransformState.validate_states()
+
+
+def test_transform_state_unique_threads():
+    results = [None] * 4
+
+    def make_states(n):
+        results[n] = [TransformState.make_pos((i, 0.5, 2000)) for i in range(1000)]
+
+    threads = [threading.Thread(target=make_states, args=(n, )) for n in range(len(results))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    for i in range(1000):
+        assert len(set(states[i].this for states in results)) == 1
+    assert TransformState.validate_states()
+
+
+def test_transform_state_compose_cache():
+    a = TransformState.make_pos((1, 2, 3))
+    b = TransformState.make_hpr((90, 0, 0))
+
+    # The second composition comes from the cache of a, and is the same state.
+    ab = a.compose(b)
+    assert a.compose(b).this == ab.this
+    assert ab.get_mat().almost_equal(TransformState.make_pos_hpr((1, 2, 3), (90, 0, 0)).get_mat())
+
+    inv = a.invert_compose(ab)
+    assert a.invert_compose(ab).this == inv.this
+    assert inv.get_hpr().almost_equal((90, 0, 0))
+    assert inv.get_pos().almost_equal((0, 0, 0))
+
+
+@pytest.fixture
+def gc_config():
+    """ Restores the garbage collection settings changed by a test. """
+
+    variables = [
+        ConfigVariableDouble("garbage-collect-states-rate"),
+        ConfigVariableDouble("garbage-collect-states-budget"),
+        ConfigVariableInt("garbage-collect-states-old-age"),
+        ConfigVariableInt("garbage-collect-old-states-interval"),
+    ]
+    old_values = [var.value for var in variables]
+    yield variables
+    for var, value in zip(variables, old_values):
+        var.value = value
+
+
+def make_states(first, count):
+    return [TransformState.make_pos((first + i, 0.5, -1000)) for i in range(count)]
+
+
+def test_transform_state_garbage_collect_all(gc_config):
+    rate, budget, old_age, old_interval = gc_config
+    rate.value = 1.0
+    budget.value = 0.0
+    TransformState.garbage_collect()
+
+    make_states(0, 500)
+    num_states = TransformState.get_num_states()
+    assert num_states >= 500
+
+    # With the rate at 1, every state is visited, so all of the ones we just
+    # let go of are collected at once.
+    assert TransformState.garbage_collect() >= 500
+    assert TransformState.get_num_states() <= num_states - 500
+
+
+def test_transform_state_garbage_collect_rate(gc_config):
+    rate, budget, old_age, old_interval = gc_config
+    rate.value = 1.0
+    budget.value = 0.0
+    old_age.value = 1
+    old_interval.value = 1000000
+
+    # Make a large number of states that stay alive, and collect once so that
+    # they are all considered long-lived.
+    held = make_states(0, 20000)
+    TransformState.garbage_collect()
+    TransformState.garbage_collect()
+
+    # Now let go of a smaller number of new states.
+    make_states(20000, 1000)
+    num_states = TransformState.get_num_states()
+
+    # Only a small fraction of the states may be visited per call, whether or
+    # not they are skipped for being long-lived, so only a small fraction of
+    # the new states can be collected by a single call.
+    rate.value = 0.01
+    num_collected = TransformState.garbage_collect()
+    assert num_collected < 100
+
+    # But they are all collected eventually.
+    total = num_collected
+    for i in range(int(math.ceil(1 / rate.value)) * 2):
+        total += TransformState.garbage_collect()
+    assert total >= 1000
+
+    del held